@@ -12,8 +12,17 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <spdlog/spdlog.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SVISION_BITMAP_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SVISION_BITMAP_SSE2
+#endif
+
 auto blend_colors(uint32_t foreground, uint32_t background, uint8_t alpha) {
     auto invAlpha = 255 - alpha;
     auto foreRed = GetRed(foreground);
@@ -524,29 +533,196 @@ auto Bitmap::fill(int x, int y, uint32_t old, uint32_t c) -> void {
 }
 
 auto Bitmap::draw(Position position, const Bitmap &other, bool alpha_blending) -> void {
-    auto other_offset = 0;
-    auto my_offset = position.y * size.width + position.x;
     auto my_raw_data = this->buffer.data();
     auto other_raw_data = other.buffer.data();
 
+    // Rows above or below this bitmap are skipped, they must not move the offsets
     for (auto y = 0; y < other.size.height; y++) {
         auto yy = y + position.y;
-        if (yy >= 0 && yy < size.height) {
-            for (auto x = 0; x < other.size.width; x++) {
-                auto xx = x + position.x;
-                if (xx >= 0 && xx < size.width) {
-                    auto c2 = other_raw_data[other_offset];
-                    if (!alpha_blending) {
-                        my_raw_data[my_offset] = c2;
-                    } else {
-                        auto alpha = GetAlpha(c2);
-                        my_raw_data[my_offset] = blend_colors(c2, my_raw_data[my_offset], alpha);
-                    }
-                }
-                other_offset += 1;
-                my_offset += 1;
+        if (yy < 0 || yy >= size.height) {
+            continue;
+        }
+        auto other_offset = y * other.size.width;
+        auto my_offset = yy * size.width + position.x;
+        for (auto x = 0; x < other.size.width; x++, other_offset++, my_offset++) {
+            auto xx = x + position.x;
+            if (xx < 0 || xx >= size.width) {
+                continue;
             }
+            auto c2 = other_raw_data[other_offset];
+            if (!alpha_blending) {
+                my_raw_data[my_offset] = c2;
+            } else {
+                auto alpha = GetAlpha(c2);
+                my_raw_data[my_offset] = blend_colors(c2, my_raw_data[my_offset], alpha);
+            }
+        }
+    }
+}
+
+auto Bitmap::blit(Position position, const Bitmap &other, Position source, Size size) -> void {
+    // Clip to the source, then to the target
+    if (source.x < 0) {
+        size.width += source.x;
+        position.x -= source.x;
+        source.x = 0;
+    }
+    if (source.y < 0) {
+        size.height += source.y;
+        position.y -= source.y;
+        source.y = 0;
+    }
+    if (position.x < 0) {
+        size.width += position.x;
+        source.x -= position.x;
+        position.x = 0;
+    }
+    if (position.y < 0) {
+        size.height += position.y;
+        source.y -= position.y;
+        position.y = 0;
+    }
+    size.width = std::min({size.width, other.size.width - source.x, this->size.width - position.x});
+    size.height =
+        std::min({size.height, other.size.height - source.y, this->size.height - position.y});
+    if (size.width <= 0 || size.height <= 0) {
+        return;
+    }
+
+    for (auto y = 0; y < size.height; y++) {
+        auto from = other.buffer.data() + (source.y + y) * other.size.width + source.x;
+        auto to = buffer.data() + (position.y + y) * this->size.width + position.x;
+        std::memmove(to, from, size.width * sizeof(uint32_t));
+    }
+}
+
+auto Bitmap::scroll_vertically(int delta) -> void {
+    if (delta == 0 || std::abs(delta) >= size.height) {
+        return;
+    }
+    auto lines = size.height - std::abs(delta);
+    auto from = buffer.data() + std::max(delta, 0) * size.width;
+    auto to = buffer.data() + std::max(-delta, 0) * size.width;
+    std::memmove(to, from, static_cast<size_t>(lines) * size.width * sizeof(uint32_t));
+}
+
+auto Bitmap::scroll_horizontally(int delta) -> void {
+    if (delta == 0 || std::abs(delta) >= size.width) {
+        return;
+    }
+    auto columns = static_cast<size_t>(size.width - std::abs(delta));
+    for (auto y = 0; y < size.height; y++) {
+        auto line = buffer.data() + y * size.width;
+        std::memmove(line + std::max(-delta, 0), line + std::max(delta, 0),
+                     columns * sizeof(uint32_t));
+    }
+}
+
+// Blends `color` over `count` pixels. Same math as blend_colors(), (x * 0x8081) >> 23 is an
+// exact x / 255 for 16 bit values. Pixels with no coverage are left untouched.
+static auto blend_mask_row(uint32_t *target, const uint8_t *alpha, int count, uint32_t color)
+    -> void {
+    auto opaque = color | 0xff000000;
+    auto x = 0;
+
+#if defined(SVISION_BITMAP_AVX2)
+    auto zero = _mm256_setzero_si256();
+    auto full = _mm256_set1_epi32(static_cast<int>(opaque));
+    auto foreground = _mm256_unpacklo_epi8(full, zero);
+    auto max_alpha = _mm256_set1_epi16(255);
+    auto div_255 = _mm256_set1_epi16(static_cast<short>(0x8081));
+    auto alpha_channel = _mm256_set1_epi32(static_cast<int>(0xff000000));
+    for (; x + 8 <= count; x += 8) {
+        uint64_t coverage;
+        memcpy(&coverage, alpha + x, sizeof(coverage));
+        if (coverage == 0) {
+            continue;
+        }
+        auto dst = reinterpret_cast<__m256i *>(target + x);
+        if (coverage == ~uint64_t{0}) {
+            _mm256_storeu_si256(dst, full);
+            continue;
+        }
+
+        // Each pixel's coverage in all 4 bytes of the pixel
+        auto coverage128 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(&coverage));
+        auto a32 = _mm256_cvtepu8_epi32(coverage128);
+        auto a = _mm256_mullo_epi32(a32, _mm256_set1_epi32(0x01010101));
+        auto background = _mm256_loadu_si256(dst);
+
+        auto blend = [&](__m256i bg, __m256i a16) {
+            auto sum = _mm256_add_epi16(_mm256_mullo_epi16(foreground, a16),
+                                        _mm256_mullo_epi16(bg, _mm256_sub_epi16(max_alpha, a16)));
+            return _mm256_srli_epi16(_mm256_mulhi_epu16(sum, div_255), 7);
+        };
+        auto low = blend(_mm256_unpacklo_epi8(background, zero), _mm256_unpacklo_epi8(a, zero));
+        auto high = blend(_mm256_unpackhi_epi8(background, zero), _mm256_unpackhi_epi8(a, zero));
+        auto result = _mm256_or_si256(_mm256_packus_epi16(low, high), alpha_channel);
+        auto untouched = _mm256_cmpeq_epi32(a32, zero);
+        _mm256_storeu_si256(dst, _mm256_blendv_epi8(result, background, untouched));
+    }
+#elif defined(SVISION_BITMAP_SSE2)
+    auto zero = _mm_setzero_si128();
+    auto full = _mm_set1_epi32(static_cast<int>(opaque));
+    auto foreground = _mm_unpacklo_epi8(full, zero);
+    auto max_alpha = _mm_set1_epi16(255);
+    auto div_255 = _mm_set1_epi16(static_cast<short>(0x8081));
+    auto alpha_channel = _mm_set1_epi32(static_cast<int>(0xff000000));
+    for (; x + 4 <= count; x += 4) {
+        uint32_t coverage;
+        memcpy(&coverage, alpha + x, sizeof(coverage));
+        if (coverage == 0) {
+            continue;
+        }
+        auto dst = reinterpret_cast<__m128i *>(target + x);
+        if (coverage == 0xffffffff) {
+            _mm_storeu_si128(dst, full);
+            continue;
         }
-        my_offset += size.width - other.size.width;
+
+        // Each pixel's coverage in all 4 bytes of the pixel
+        auto a8 = _mm_cvtsi32_si128(static_cast<int>(coverage));
+        auto a16 = _mm_unpacklo_epi8(a8, a8);
+        auto a = _mm_unpacklo_epi16(a16, a16);
+        auto background = _mm_loadu_si128(dst);
+
+        auto blend = [&](__m128i bg, __m128i alpha16) {
+            auto sum = _mm_add_epi16(_mm_mullo_epi16(foreground, alpha16),
+                                     _mm_mullo_epi16(bg, _mm_sub_epi16(max_alpha, alpha16)));
+            return _mm_srli_epi16(_mm_mulhi_epu16(sum, div_255), 7);
+        };
+        auto low = blend(_mm_unpacklo_epi8(background, zero), _mm_unpacklo_epi8(a, zero));
+        auto high = blend(_mm_unpackhi_epi8(background, zero), _mm_unpackhi_epi8(a, zero));
+        auto result = _mm_or_si128(_mm_packus_epi16(low, high), alpha_channel);
+        auto untouched = _mm_cmpeq_epi32(a, zero);
+        result = _mm_or_si128(_mm_and_si128(untouched, background),
+                              _mm_andnot_si128(untouched, result));
+        _mm_storeu_si128(dst, result);
+    }
+#endif
+
+    for (; x < count; x++) {
+        if (alpha[x] == 255) {
+            target[x] = opaque;
+        } else if (alpha[x] != 0) {
+            target[x] = blend_colors(color, target[x], alpha[x]);
+        }
+    }
+}
+
+auto Bitmap::blend_mask(const AlphaMask &mask, Position position, uint32_t color) -> void {
+    // Clip once per call, not per pixel
+    auto x0 = std::max(0, -position.x);
+    auto y0 = std::max(0, -position.y);
+    auto x1 = std::min(mask.size.width, size.width - position.x);
+    auto y1 = std::min(mask.size.height, size.height - position.y);
+    if (x1 <= x0) {
+        return;
+    }
+
+    for (auto y = y0; y < y1; y++) {
+        auto source = mask.buffer.data() + y * mask.size.width + x0;
+        auto target = buffer.data() + (y + position.y) * size.width + position.x + x0;
+        blend_mask_row(target, source, x1 - x0, color);
     }
 }
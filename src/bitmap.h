@@ -96,6 +96,17 @@ struct Gradient {
 auto Lighter(uint32_t color, double percentage = 0.1) -> uint32_t;
 auto Darker(uint32_t color, double percentage = 0.1) -> uint32_t;
 
+// 8 bit coverage, without a color. Drawn into a Bitmap using Bitmap::blend_mask.
+struct AlphaMask {
+    std::vector<uint8_t> buffer;
+    Size size = {0, 0};
+
+    auto resize(int width, int height) -> void {
+        buffer.assign(width * height, 0);
+        size = {width, height};
+    }
+};
+
 struct Bitmap {
     uint32_t background_color = 0;
     std::vector<uint32_t> buffer;
@@ -156,4 +167,15 @@ struct Bitmap {
 
     auto fill(int x, int y, uint32_t old, uint32_t color) -> void;
     auto draw(Position position, const Bitmap &other, bool alpha_blending = false) -> void;
+
+    // Copies `size` pixels of `other` from `source` to `position`, clipped to both bitmaps
+    auto blit(Position position, const Bitmap &other, Position source, Size size) -> void;
+
+    // Moves the pixels `delta` lines up, or down when negative. Lines scrolled into view keep
+    // their old pixels.
+    auto scroll_vertically(int delta) -> void;
+
+    // Moves the pixels `delta` columns left, or right when negative
+    auto scroll_horizontally(int delta) -> void;
+    auto blend_mask(const AlphaMask &mask, Position position, uint32_t color) -> void;
 };
@@ -83,7 +83,7 @@ Button::Button(Position pp, Size size, std::string_view text, bool is_default,
 
 auto Button::draw() -> void {
     get_theme()->draw_button(content, has_focus, is_default, is_enabled, has_frame, state.state,
-                             text, icon);
+                             text, icon, cache_text ? &text_run : nullptr);
 }
 
 auto Button::on_hover(const EventMouse &) -> void {
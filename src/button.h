@@ -23,8 +23,11 @@ struct Button : Widget {
     bool has_frame = true;
     std::shared_ptr<Bitmap> icon;
 
-    std::string text;
     std::function<void(Button &)> on_button_click;
+
+    // Keep the rendered text between redraws, for text which rarely changes
+    bool cache_text = false;
+    TextRun text_run;
     AbstractButtonState state;
 
     // TODO this part can be extracted into another helper class to be re-used.
@@ -54,6 +57,15 @@ struct Button : Widget {
     auto set_auto_repeat(int64_t repeat_millies, int64_t repeat_start = 500) -> void;
     auto disable_auto_repeat() -> void;
 
+    // The size hint depends on the text, it is only changed through `set_text()`
+    auto get_text() const -> const std::string & { return text; }
+    auto set_text(std::string_view new_text) -> std::shared_ptr<Button> {
+        this->text = new_text;
+        invalidate_size_hint();
+        invalidate();
+        return std::dynamic_pointer_cast<Button>(this->shared_from_this());
+    }
+
     auto set_is_default(bool new_state) -> std::shared_ptr<Button> {
         this->is_default = new_state;
         this->needs_redraw = true;
@@ -69,6 +81,7 @@ struct Button : Widget {
     auto set_auto_shrink(bool new_state) -> std::shared_ptr<Button> {
         this->auto_shrink = new_state;
         this->needs_redraw = true;
+        invalidate_size_hint();
         return std::dynamic_pointer_cast<Button>(this->shared_from_this());
     }
 
@@ -87,4 +100,7 @@ struct Button : Widget {
         this->icon = icon;
         return std::dynamic_pointer_cast<Button>(this->shared_from_this());
     }
+
+  private:
+    std::string text;
 };
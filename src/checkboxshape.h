@@ -19,6 +19,12 @@ enum class CheckboxShape {
 struct ItemStatus {
     bool is_selected = false;
     bool is_active = false;
+
+    auto inline operator==(const ItemStatus &other) const -> bool {
+        return is_selected == other.is_selected && is_active == other.is_active;
+    }
+
+    auto inline operator!=(const ItemStatus &other) const -> bool { return !(*this == other); }
 };
 
 struct Frame {
@@ -61,6 +61,11 @@ auto Combobox::on_focus_change(bool new_state) -> void {
     }
 }
 
+auto Combobox::on_theme_changed() -> void {
+    // The background is taken from the theme on focus changes
+    on_focus_change(has_focus);
+}
+
 auto Combobox::on_keyboard(const EventKeyboard &event) -> EventPropagation {
     auto result = EventPropagation::propagate;
     switch (event.key) {
@@ -93,6 +98,15 @@ auto Combobox::on_keyboard(const EventKeyboard &event) -> EventPropagation {
         result = EventPropagation::handled;
         break;
     default:
+        if (!event.is_control_pressed() && !event.is_mod_pressed() && !event.text.empty()) {
+            auto get_text = [this](size_t row) { return std::string_view(strings[row]); };
+            auto row = type_ahead.on_key(event.text, strings.size(), get_text, selected_item);
+            if (row >= 0) {
+                set_active_index(row);
+                result = EventPropagation::handled;
+                break;
+            }
+        }
         result = Widget::on_keyboard(event);
     }
 
@@ -191,6 +205,7 @@ auto Combobox::set_active_index(int index) -> void {
 
 auto Combobox::set_items(const std::vector<std::string> &new_strings) -> void {
     this->strings = new_strings;
+    type_ahead.invalidate();
     if (this->selected_item >= this->strings.size()) {
         this->selected_item = this->strings.size();
     }
@@ -11,6 +11,7 @@
 #include <string>
 #include <vector>
 
+#include <typeahead.h>
 #include <widget.h>
 
 struct Button;
@@ -34,6 +35,7 @@ struct Combobox : Widget {
     virtual auto on_keyboard(const EventKeyboard &) -> EventPropagation override;
     virtual auto size_hint() const -> Size override;
     virtual auto on_resize() -> void override;
+    virtual auto on_theme_changed() -> void override;
 
     auto show_popup() -> void;
     auto set_active_index(int index) -> void;
@@ -42,4 +44,5 @@ struct Combobox : Widget {
 
   private:
     std::shared_ptr<Button> popup_button = nullptr;
+    TypeAhead type_ahead;
 };
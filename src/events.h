@@ -9,11 +9,17 @@
 
 #include <sizepoint.h>
 
+#include <string>
+
 enum class EventPropagation {
     handled = true,
     propagate = false,
 };
 
+// The wheel is reported as a press of one of these buttons, as X11 does
+constexpr int mouse_wheel_up = 4;
+constexpr int mouse_wheel_down = 5;
+
 enum class MouseEvents {
     Unknown,
     Press,
@@ -55,6 +61,9 @@ struct EventKeyboard : Event {
     KeyCodes key;
     bool keydown;
 
+    // What the key types, UTF-8. Empty for keys which type nothing, like arrows or insert.
+    std::string text;
+
     auto is_control_pressed() const -> bool { return modifiers & 0x1; }
     auto is_shift_pressed() const -> bool { return modifiers & 0x2; }
     auto is_mod_pressed() const -> bool { return modifiers & 0x4; }
@@ -68,6 +77,12 @@ struct EventMouse : Event {
     int x = -1;
     int y = -1;
 
+    // Same bits as in keyboard events
+    int modifiers = 0;
+
+    auto is_control_pressed() const -> bool { return modifiers & 0x1; }
+    auto is_shift_pressed() const -> bool { return modifiers & 0x2; }
+
     auto invalidate() -> auto {
         x = -1;
         y = -1;
@@ -6,33 +6,105 @@
  */
 
 #include "fontprovider.h"
+#include "utf8.h"
+
+#include <algorithm>
+#include <atomic>
 
 // this file is autogenerated from old bitmap fonts
 #include "fontdos.h"
 
-auto static write_fixed_char(Bitmap &bitmap, Position position, char c, const uint32_t color)
-    -> void {
-    // const unsigned char *font = ATIx550_8x16_bin;
-    const unsigned char *font = IBM_VGA_8x16_bin;
-
-    for (auto y = 0; y < 16; y++) {
-        unsigned char line = font[16 * (unsigned char)c + y];
-        for (auto x = 0; x < 8; x++) {
-            auto xx = 8 - x;
-            if (get_bit(line, xx)) {
-                bitmap.put_pixel(position.x + x, position.y + y, color);
+// The bitmap font as coverage masks, so it is drawn like any other font
+auto static get_fixed_glyphs() -> const std::array<AlphaMask, 256> & {
+    static const auto glyphs = []() {
+        // const unsigned char *font = ATIx550_8x16_bin;
+        const unsigned char *font = IBM_VGA_8x16_bin;
+        auto masks = std::array<AlphaMask, 256>();
+        for (auto c = 0; c < 256; c++) {
+            masks[c].resize(8, 16);
+            for (auto y = 0; y < 16; y++) {
+                unsigned char line = font[16 * c + y];
+                for (auto x = 0; x < 8; x++) {
+                    if (get_bit(line, 8 - x)) {
+                        masks[c].buffer[y * 8 + x] = 255;
+                    }
+                }
             }
         }
+        return masks;
+    }();
+    return glyphs;
+}
+
+auto CodePointCoverage::add(char32_t first, char32_t last) -> void {
+    for (; first <= last && first < 0x10000; first++) {
+        bmp[first >> 6] |= uint64_t{1} << (first & 63);
+    }
+    if (first > last) {
+        return;
+    }
+
+    // cmaps are sorted, so this is usually an append or an extension of the last range
+    if (!ranges.empty() && first >= ranges.back().first && first <= ranges.back().second + 1) {
+        ranges.back().second = std::max(ranges.back().second, last);
+        return;
+    }
+    auto range = std::make_pair(first, last);
+    ranges.insert(std::upper_bound(ranges.begin(), ranges.end(), range), range);
+}
+
+auto CodePointCoverage::contains_astral(char32_t code_point) const -> bool {
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), code_point,
+                               [](char32_t c, const auto &range) { return c < range.first; });
+    if (it == ranges.begin()) {
+        return false;
+    }
+    --it;
+    return code_point <= it->second;
+}
+
+auto FontProvider::next_id() -> uint64_t {
+    static auto last_id = std::atomic<uint64_t>(0);
+    return ++last_id;
+}
+
+auto FontProvider::prewarm(std::u32string code_points, PrewarmCallback done) -> void {
+    wait_for_prewarm();
+    if (code_points.empty()) {
+        for (auto c = U' '; c < 127; c++) {
+            code_points.push_back(c);
+        }
+    }
+    prewarm_result = std::async(std::launch::async, [this, code_points, done]() {
+        auto start = std::chrono::steady_clock::now();
+        auto count = load_glyphs(code_points);
+        auto end = std::chrono::steady_clock::now();
+        if (done) {
+            done(count, std::chrono::duration_cast<std::chrono::microseconds>(end - start));
+        }
+    });
+}
+
+auto FontProvider::wait_for_prewarm() -> void {
+    if (prewarm_result.valid()) {
+        prewarm_result.get();
     }
 }
 
 auto FontProviderFixed::write(Bitmap &bitmap, Position position, const std::string_view str,
                               const uint32_t color) -> void {
-    for (auto c : str) {
-        write_fixed_char(bitmap, position, c, color);
+    utf8_for_each(str, [&](char32_t c) {
+        // The font only covers code page 437, show anything outside ASCII as '?'
+        auto glyph = c < 0x80 ? static_cast<unsigned char>(c) : '?';
+        bitmap.blend_mask(get_fixed_glyphs()[glyph], position, color);
         position.x += 8;
-    }
+    });
 }
 auto FontProviderFixed::text_size(const std::string_view str) -> Size {
-    return Size{static_cast<int>(str.length()) * 8, 16};
+    return Size{static_cast<int>(utf8_length(str)) * 8, 16};
+}
+
+auto FontProviderFixed::with_size(int /*pixel_size*/) -> std::shared_ptr<FontProvider> {
+    // This is a bitmap font, available only at 8x16
+    return std::make_shared<FontProviderFixed>();
 }
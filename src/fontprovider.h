@@ -7,18 +7,99 @@
 
 #pragma once
 
+#include <array>
 #include <bitmap.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
+
+// A rasterized glyph, as kept in the per size caches of the font providers.
+// Offset is relative to the pen position on the baseline.
+struct Glyph {
+    // The face in the fallback chain which has this glyph, 0 is the main face
+    int face = 0;
+    int index = 0;
+    float advance = 0;
+    Position offset = {};
+    AlphaMask mask = {};
+};
+
+// The code points a font has, built once from its cmap. The BMP is a bitmap, code points
+// above it are kept as sorted ranges.
+struct CodePointCoverage {
+    auto add(char32_t first, char32_t last) -> void;
+    auto contains(char32_t code_point) const -> bool {
+        if (code_point < 0x10000) {
+            return (bmp[code_point >> 6] >> (code_point & 63)) & 1;
+        }
+        return contains_astral(code_point);
+    }
+
+  private:
+    auto contains_astral(char32_t code_point) const -> bool;
+
+    std::array<uint64_t, 0x10000 / 64> bmp = {};
+    std::vector<std::pair<char32_t, char32_t>> ranges;
+};
 
 struct FontProvider {
     virtual ~FontProvider() = default;
     auto virtual write(Bitmap &, Position, const std::string_view, const uint32_t color)
         -> void = 0;
     auto virtual text_size(const std::string_view str) -> Size = 0;
+
+    // Returns a provider for the same font face, at a different pixel size. The parsed font
+    // is shared between all providers created this way, each one only owns its own glyph cache.
+    auto virtual with_size(int pixel_size) -> std::shared_ptr<FontProvider> = 0;
+    auto virtual get_size() const -> int = 0;
+
+    // Unique for every provider ever created. Unlike the address of the provider, it is never
+    // reused after the provider is freed, so it can identify the font of cached text.
+    auto get_id() const -> uint64_t { return id; }
+
+    // Changes when the provider starts drawing text differently, like when a fallback font
+    // is added. Text rasterized with an older generation has to be rasterized again.
+    auto get_generation() const -> uint32_t { return generation; }
+
+    // Adds a font to the fallback chain, used for code points missing in the main font.
+    // Returns false if the font cannot be used.
+    auto virtual add_fallback(const std::string_view font_file) -> bool {
+        (void)(font_file);
+        return false;
+    }
+
+    // Rasterizes `code_points` (printable ASCII when empty) into the glyph cache on a worker
+    // thread, and returns immediately. Every other call on this provider waits for the worker
+    // to finish, so this should be started as early as possible. Providers of other sizes can
+    // be used meanwhile. `done` is called on the worker thread.
+    using PrewarmCallback = std::function<void(int glyphs, std::chrono::microseconds time)>;
+    auto prewarm(std::u32string code_points = {}, PrewarmCallback done = {}) -> void;
+    auto wait_for_prewarm() -> void;
+
+  protected:
+    // Loads the glyphs into the cache, returns how many were loaded
+    auto virtual load_glyphs(const std::u32string &) -> int { return 0; }
+
+    auto bump_generation() -> void { generation++; }
+
+  private:
+    static auto next_id() -> uint64_t;
+
+    const uint64_t id = next_id();
+    uint32_t generation = 0;
+    std::future<void> prewarm_result;
 };
 
 struct FontProviderFixed : FontProvider {
     auto virtual write(Bitmap &, Position, const std::string_view, const uint32_t color)
         -> void override;
     auto virtual text_size(const std::string_view str) -> Size override;
+    auto virtual with_size(int pixel_size) -> std::shared_ptr<FontProvider> override;
+    auto virtual get_size() const -> int override { return 16; }
 };
@@ -7,139 +7,218 @@
 
 #include "fontproviderfreetype.h"
 #include "spdlog/spdlog.h"
+#include <algorithm>
 #include <string_view>
+#include <utf8.h>
 
-FontProviderFreetype::FontProviderFreetype(const std::string_view default_font) {
+FontFaceFreetype::FontFaceFreetype(const std::string_view font_file) {
     if (FT_Init_FreeType(&library)) {
         spdlog::error("Freetype: Could not initialize");
+        library = nullptr;
         return;
     }
 
-    auto error = FT_New_Face(library, default_font.data(), 0, &face);
+    auto error = FT_New_Face(library, font_file.data(), 0, &face);
     if (error) {
-        spdlog::error("Freetype: Could not load font: {}, {}", default_font.data(),
+        spdlog::error("Freetype: Could not load font: {}, {}", font_file.data(),
                       FT_Error_String(error));
         FT_Done_FreeType(library);
+        library = nullptr;
+        face = nullptr;
         return;
     }
 
+    auto glyph_index = FT_UInt{0};
+    auto code_point = FT_Get_First_Char(face, &glyph_index);
+    while (glyph_index != 0) {
+        coverage.add(code_point, code_point);
+        code_point = FT_Get_Next_Char(face, code_point, &glyph_index);
+    }
     initialized = true;
 }
 
-// Function to extract one Unicode code point from a UTF-8 string_view
-// Returns the extracted Unicode code point and updates the iterator
-static int32_t extractUnicodeCharacter(std::string_view::const_iterator &it) {
-    int32_t unicodeChar = 0;
-    size_t bytesRead = 0;
-
-    // Decode the Unicode character
-    char32_t firstByte = static_cast<unsigned char>(*it);
-    if (firstByte <= 0x7F) {
-        unicodeChar = firstByte;
-        bytesRead = 1;
-    } else if ((firstByte & 0xE0) == 0xC0) {
-        unicodeChar = (firstByte & 0x1F) << 6;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 1)) & 0x3F);
-        bytesRead = 2;
-    } else if ((firstByte & 0xF0) == 0xE0) {
-        unicodeChar = (firstByte & 0x0F) << 12;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 1)) & 0x3F) << 6;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 2)) & 0x3F);
-        bytesRead = 3;
-    } else if ((firstByte & 0xF8) == 0xF0) {
-        unicodeChar = (firstByte & 0x07) << 18;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 1)) & 0x3F) << 12;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 2)) & 0x3F) << 6;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 3)) & 0x3F);
-        bytesRead = 4;
-    } else {
-        // Handle invalid UTF-8 encoding
-        //        std::cerr << "Invalid UTF-8 encoding\n";
-    }
-
-    // Update the iterator
-    it += bytesRead;
-
-    return unicodeChar;
+FontFaceFreetype::~FontFaceFreetype() {
+    if (face) {
+        FT_Done_Face(face);
+    }
+    if (library) {
+        FT_Done_FreeType(library);
+    }
+}
+
+FontProviderFreetype::FontProviderFreetype(const std::string_view default_font, int size)
+    : FontProviderFreetype(std::make_shared<FontFaceFreetype>(default_font), size) {}
+
+FontProviderFreetype::FontProviderFreetype(std::shared_ptr<FontFaceFreetype> face, int size) {
+    this->face = face;
+    this->fontSize = size;
+    auto lock = std::lock_guard<std::mutex>(face->face_lock);
+    if (face->initialized && FT_New_Size(face->face, &this->size)) {
+        spdlog::error("Freetype: Could not allocate a new size");
+        this->size = nullptr;
+    }
+}
+
+FontProviderFreetype::~FontProviderFreetype() {
+    wait_for_prewarm();
+    auto lock = std::lock_guard<std::mutex>(face->face_lock);
+    for (auto &fallback : fallbacks) {
+        FT_Done_Size(fallback.size);
+    }
+    if (size) {
+        FT_Done_Size(size);
+    }
 }
 
-static auto draw_glyph(Bitmap &bitmap, int x, int y, uint32_t color, FT_GlyphSlot slot) {
-    for (auto dy = 0u; dy < slot->bitmap.rows; dy++) {
-        for (auto dx = 0u; dx < slot->bitmap.width; dx++) {
-            auto glyphColor = slot->bitmap.buffer[dy * slot->bitmap.width + dx];
-            bitmap.blend_pixel(x + dx, y + dy, color, glyphColor);
+auto FontProviderFreetype::with_size(int pixel_size) -> std::shared_ptr<FontProvider> {
+    auto provider = std::make_shared<FontProviderFreetype>(face, pixel_size);
+    for (auto &fallback : fallbacks) {
+        provider->add_fallback(fallback.face);
+    }
+    return provider;
+}
+
+auto FontProviderFreetype::add_fallback(const std::string_view font_file) -> bool {
+    return add_fallback(std::make_shared<FontFaceFreetype>(font_file));
+}
+
+auto FontProviderFreetype::add_fallback(std::shared_ptr<FontFaceFreetype> fallback) -> bool {
+    wait_for_prewarm();
+    auto lock = std::lock_guard<std::mutex>(face->face_lock);
+    auto fallback_size = FT_Size{};
+    if (!fallback->initialized || FT_New_Size(fallback->face, &fallback_size)) {
+        return false;
+    }
+    fallbacks.push_back({fallback, fallback_size});
+
+    // Glyphs which were missing may now come from the new face
+    cached_size = 0;
+    bump_generation();
+    return true;
+}
+
+auto FontProviderFreetype::face_for(int code_point) const -> int {
+    if (face->coverage.contains(code_point)) {
+        return 0;
+    }
+    for (auto i = 0u; i < fallbacks.size(); i++) {
+        if (fallbacks[i].face->coverage.contains(code_point)) {
+            return i + 1;
         }
     }
+    return 0;
+}
+
+// The face is shared between sizes, so our size must be the active one before
+// loading anything from it. Call with the face lock held.
+auto FontProviderFreetype::activate_size() -> bool {
+    if (!size) {
+        return false;
+    }
+    FT_Activate_Size(size);
+    for (auto &fallback : fallbacks) {
+        FT_Activate_Size(fallback.size);
+    }
+    if (cached_size != fontSize) {
+        glyphs.clear();
+        ascii_glyphs = {};
+        FT_Set_Pixel_Sizes(face->face, 0, fontSize);
+        for (auto &fallback : fallbacks) {
+            FT_Set_Pixel_Sizes(fallback.face->face, 0, fontSize);
+        }
+        cached_size = fontSize;
+        ascender = size->metrics.ascender >> 6;
+        height = size->metrics.height;
+    }
+    return true;
+}
+
+auto FontProviderFreetype::get_glyph(int code_point) -> const Glyph & {
+    auto is_ascii = code_point >= 0 && code_point < 128;
+    if (is_ascii && ascii_glyphs[code_point]) {
+        return *ascii_glyphs[code_point];
+    }
+    auto it = glyphs.find(code_point);
+    if (it != glyphs.end()) {
+        return it->second;
+    }
+
+    auto &glyph = glyphs[code_point];
+    if (is_ascii) {
+        ascii_glyphs[code_point] = &glyph;
+    }
+    glyph.face = face_for(code_point);
+    auto ft_face = glyph.face == 0 ? face->face : fallbacks[glyph.face - 1].face->face;
+    auto error = FT_Load_Char(ft_face, code_point, FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL);
+    if (error) {
+        return glyph;
+    }
+
+    // https://stackoverflow.com/questions/62374506/how-do-i-align-glyphs-along-the-baseline-with-freetype
+    // https://freetype.org/freetype2/docs/tutorial/step2.html
+    auto slot = ft_face->glyph;
+    glyph.index = slot->glyph_index;
+    glyph.advance = slot->advance.x / 64.0f;
+    glyph.offset = {slot->bitmap_left, -slot->bitmap_top};
+    glyph.mask.resize(slot->bitmap.width, slot->bitmap.rows);
+    for (auto row = 0u; row < slot->bitmap.rows; row++) {
+        auto source = slot->bitmap.buffer + row * slot->bitmap.pitch;
+        std::copy(source, source + slot->bitmap.width,
+                  glyph.mask.buffer.begin() + row * slot->bitmap.width);
+    }
+    return glyph;
+}
+
+auto FontProviderFreetype::load_glyphs(const std::u32string &code_points) -> int {
+    // Runs on the prewarm worker. The lock is taken per glyph so other sizes of the face can
+    // still draw, and each of them activates its own size again.
+    for (auto code_point : code_points) {
+        auto lock = std::lock_guard<std::mutex>(face->face_lock);
+        if (!activate_size()) {
+            return 0;
+        }
+        get_glyph(code_point);
+    }
+    return static_cast<int>(code_points.size());
 }
 
 auto FontProviderFreetype::write(Bitmap &bitmap, Position position, const std::string_view text,
                                  const uint32_t color) -> void {
-    if (!initialized) {
+    auto text_bounds = text_size(text);
+    auto lock = std::lock_guard<std::mutex>(face->face_lock);
+    if (!activate_size()) {
         return;
     };
 
-    FT_Set_Pixel_Sizes(face, 0, fontSize);
-    auto text_bounds = text_size(text);
     if (debug_render) {
         bitmap.draw_rectangle(position.x, position.y, text_bounds.width, text_bounds.height,
                               0x00ff00, 0x00ff00);
-        auto yyy = position.y + (face->size->metrics.ascender >> 6);
+        auto yyy = position.y + ascender;
         bitmap.line(position.x, yyy, position.x + text_bounds.width, yyy, 0xff8080);
     }
 
     auto penX = position.x * 64;
-    auto penY = position.y * 64;
-    auto it = text.begin();
-    const auto end = text.end();
-
-    while (it != end) {
-        auto code_point = extractUnicodeCharacter(it);
-        auto error = FT_Load_Char(face, code_point, FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL);
-        if (error) {
-            //            spdlog::error("Freetype: Error rendering glyph: {}\n",
-            //            FT_Error_String(error));
-            continue;
-        }
-
-        // https://stackoverflow.com/questions/62374506/how-do-i-align-glyphs-along-the-baseline-with-freetype
-        // https://freetype.org/freetype2/docs/tutorial/step2.html
-        // https://kevinboone.me/fbtextdemo.html?i=2
-
-        auto physicallStartX = (penX + face->glyph->bitmap_left) >> 6;
-        auto physicallStartY = (penY - face->glyph->bitmap_top) >> 6;
-        auto delta = text_bounds.height - face->glyph->bitmap_top;
-
-        draw_glyph(bitmap, physicallStartX, physicallStartY + delta, color, face->glyph);
-
-        penX += face->glyph->advance.x;
-        penY += face->glyph->advance.y;
-    }
+    utf8_for_each(text, [&](char32_t code_point) {
+        auto &glyph = get_glyph(code_point);
+        auto physicallStartX = (penX >> 6) + glyph.offset.x;
+        auto physicallStartY = position.y + text_bounds.height + glyph.offset.y;
+
+        bitmap.blend_mask(glyph.mask, {physicallStartX, physicallStartY}, color);
+        penX += static_cast<int>(glyph.advance * 64);
+    });
 }
 
 auto FontProviderFreetype::text_size(const std::string_view text) -> Size {
-    if (!initialized) {
+    wait_for_prewarm();
+    auto lock = std::lock_guard<std::mutex>(face->face_lock);
+    if (!activate_size()) {
         return {0, 0};
     };
 
     auto penX = 0;
-    auto penY = (unsigned int)0;
-    auto it = text.begin();
-    const auto end = text.end();
-
-    FT_Set_Pixel_Sizes(face, 0, fontSize);
-    while (it != end) {
-        auto code_point = extractUnicodeCharacter(it);
-        auto error = FT_Load_Char(face, code_point, FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL);
-        if (error) {
-            continue;
-        }
-
-        FT_GlyphSlot slot = face->glyph;
-        penX += slot->advance.x;
-        penY += slot->advance.y;
-    }
+    utf8_for_each(text, [&](char32_t code_point) {
+        penX += static_cast<int>(get_glyph(code_point).advance * 64);
+    });
 
-    auto size_x = penX / 64;
-    auto size_y = (penY + face->size->metrics.height) / 64;
-    return {size_x, (int)size_y};
+    return {penX / 64, height / 64};
 }
@@ -9,19 +9,70 @@
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_SIZES_H
 
 #include <fontprovider.h>
 
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// The loaded font file. Every `FontProviderFreetype` holds its own `FT_Size` on this face.
+struct FontFaceFreetype {
+    explicit FontFaceFreetype(const std::string_view font_file);
+    FontFaceFreetype(const FontFaceFreetype &) = delete;
+    ~FontFaceFreetype();
+
+    FT_Library library = nullptr;
+    FT_Face face = nullptr;
+    bool initialized = false;
+    CodePointCoverage coverage;
+
+    // FreeType objects are not thread safe, and a prewarm of one size runs while other sizes
+    // draw. Every provider of this face holds this while using the face or its fallbacks.
+    std::mutex face_lock;
+};
+
 struct FontProviderFreetype : FontProvider {
-    explicit FontProviderFreetype(const std::string_view default_font);
+    explicit FontProviderFreetype(const std::string_view default_font, int size = 14);
+    FontProviderFreetype(std::shared_ptr<FontFaceFreetype> face, int size);
+    FontProviderFreetype(const FontProviderFreetype &) = delete;
+    virtual ~FontProviderFreetype() override;
 
     auto virtual write(Bitmap &, Position, const std::string_view, const uint32_t color)
         -> void override;
     auto virtual text_size(const std::string_view str) -> Size override;
+    auto virtual with_size(int pixel_size) -> std::shared_ptr<FontProvider> override;
+    auto virtual get_size() const -> int override { return fontSize; }
+    auto virtual add_fallback(const std::string_view font_file) -> bool override;
+    auto add_fallback(std::shared_ptr<FontFaceFreetype> fallback) -> bool;
 
-    FT_Library library;
-    FT_Face face;
-    bool initialized = false;
-    const int fontSize = 14;
+    std::shared_ptr<FontFaceFreetype> face;
+    int fontSize = 14;
     bool debug_render = false;
+
+  protected:
+    auto virtual load_glyphs(const std::u32string &code_points) -> int override;
+
+  private:
+    auto activate_size() -> bool;
+    auto get_glyph(int code_point) -> const Glyph &;
+    auto face_for(int code_point) const -> int;
+
+    // Fallback faces, each one needs its own size object too
+    struct Fallback {
+        std::shared_ptr<FontFaceFreetype> face;
+        FT_Size size = nullptr;
+    };
+    std::vector<Fallback> fallbacks;
+
+    // Per size cache, valid for `cached_size`
+    FT_Size size = nullptr;
+    int cached_size = 0;
+    int ascender = 0;
+    int height = 0;
+    std::unordered_map<int, Glyph> glyphs;
+    std::array<const Glyph *, 128> ascii_glyphs = {};
 };
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <iterator>
@@ -5,14 +7,17 @@
 #include <vector>
 
 #include <spdlog/spdlog.h>
+#include <utf8.h>
 
 #define STBTT_STATIC
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "fontproviders/fontproviderstb.hpp"
 
 static std::vector<unsigned char> readFile(std::string_view filename) {
-    // TODO handle errors
     std::ifstream file(filename.data(), std::ios::binary);
+    if (!file) {
+        return {};
+    }
     file.unsetf(std::ios::skipws);
     std::streampos fileSize;
     file.seekg(0, std::ios::end);
@@ -26,56 +31,417 @@ static std::vector<unsigned char> readFile(std::string_view filename) {
     return vec;
 }
 
-// Function to extract one Unicode code point from a UTF-8 string_view
-// Returns the extracted Unicode code point and updates the iterator
-static int32_t extractUnicodeCharacter(std::string_view::const_iterator &it) {
-    int32_t unicodeChar = 0;
-    size_t bytesRead = 0;
-
-    char32_t firstByte = static_cast<unsigned char>(*it);
-    if (firstByte <= 0x7F) {
-        unicodeChar = firstByte;
-        bytesRead = 1;
-    } else if ((firstByte & 0xE0) == 0xC0) {
-        unicodeChar = (firstByte & 0x1F) << 6;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 1)) & 0x3F);
-        bytesRead = 2;
-    } else if ((firstByte & 0xF0) == 0xE0) {
-        unicodeChar = (firstByte & 0x0F) << 12;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 1)) & 0x3F) << 6;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 2)) & 0x3F);
-        bytesRead = 3;
-    } else if ((firstByte & 0xF8) == 0xF0) {
-        unicodeChar = (firstByte & 0x07) << 18;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 1)) & 0x3F) << 12;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 2)) & 0x3F) << 6;
-        unicodeChar |= (static_cast<unsigned char>(*(it + 3)) & 0x3F);
-        bytesRead = 4;
-    } else {
-        // Handle invalid UTF-8 encoding
-    }
-
-    it += bytesRead;
-    return unicodeChar;
-}
-
-FontProviderSTB::FontProviderSTB(const std::string_view default_font) {
-    font_data = readFile(default_font.data());
+FontFaceSTB::FontFaceSTB(const std::string_view font_file) {
+    font_data = readFile(font_file.data());
+    if (font_data.empty()) {
+        spdlog::error("STB: Could not load font: {}", font_file);
+        return;
+    }
     auto data = font_data.data();
-    auto ret = stbtt_InitFont(&this->font_info, data, stbtt_GetFontOffsetForIndex(data, 0));
-    spdlog::warn("initfont = {}", ret);
+    if (!stbtt_InitFont(&font_info, data, stbtt_GetFontOffsetForIndex(data, 0))) {
+        spdlog::error("STB: Could not parse font: {}", font_file);
+        return;
+    }
+    stbtt_GetFontVMetrics(&font_info, &ascent, &descent, &line_gap);
+    build_coverage();
+    build_kerning();
+    is_valid = true;
+}
+
+// Reads the cmap subtable stb picked, instead of probing every code point
+auto FontFaceSTB::build_coverage() -> void {
+    auto cmap = font_info.data + font_info.index_map;
+    auto format = ttUSHORT(cmap);
+
+    if (format == 4) {
+        auto segments = ttUSHORT(cmap + 6) / 2;
+        auto end_codes = cmap + 14;
+        auto start_codes = end_codes + segments * 2 + 2;
+        auto deltas = start_codes + segments * 2;
+        auto range_offsets = deltas + segments * 2;
+        for (auto i = 0; i < segments; i++) {
+            auto start = ttUSHORT(start_codes + i * 2);
+            auto end = ttUSHORT(end_codes + i * 2);
+            auto delta = ttUSHORT(deltas + i * 2);
+            auto range_offset = ttUSHORT(range_offsets + i * 2);
+            for (auto c = start; c <= end && c != 0xffff; c++) {
+                auto glyph = c;
+                if (range_offset != 0) {
+                    glyph = ttUSHORT(range_offsets + i * 2 + range_offset + (c - start) * 2);
+                    if (glyph == 0) {
+                        continue;
+                    }
+                }
+                if (static_cast<uint16_t>(glyph + delta) != 0) {
+                    coverage.add(c, c);
+                }
+            }
+        }
+        return;
+    }
+
+    if (format == 12 || format == 13) {
+        auto groups = ttULONG(cmap + 12);
+        for (auto i = 0u; i < groups; i++) {
+            auto group = cmap + 16 + i * 12;
+            if (format == 13 && ttULONG(group + 8) == 0) {
+                continue;
+            }
+            coverage.add(ttULONG(group), ttULONG(group + 4));
+        }
+        return;
+    }
+
+    // Formats 0 and 6 only cover the BMP, and are small
+    for (auto c = 0; c < 0x10000; c++) {
+        if (stbtt_FindGlyphIndex(&font_info, c) != 0) {
+            coverage.add(c, c);
+        }
+    }
+}
+
+auto FontFaceSTB::build_kerning() -> void {
+    has_kerning = font_info.kern != 0 || font_info.gpos != 0;
+    if (!has_kerning) {
+        return;
+    }
+
+    // Only printable ASCII can kern, the rest of the table stays 0
+    ascii_kerning.resize(128 * 128);
+    for (auto c1 = ' '; c1 < 127; c1++) {
+        auto g1 = stbtt_FindGlyphIndex(&font_info, c1);
+        for (auto c2 = ' '; c2 < 127; c2++) {
+            auto g2 = stbtt_FindGlyphIndex(&font_info, c2);
+            ascii_kerning[c1 * 128 + c2] = stbtt_GetGlyphKernAdvance(&font_info, g1, g2);
+        }
+    }
+
+    // stb prefers GPOS over the old kern table, and so do we
+    if (font_info.gpos) {
+        lazy_kerning = true;
+        return;
+    }
+    auto length = stbtt_GetKerningTableLength(&font_info);
+    auto table = std::vector<stbtt_kerningentry>(length);
+    length = stbtt_GetKerningTable(&font_info, table.data(), length);
+    for (auto i = 0; i < length; i++) {
+        kerning_pairs.insert(table[i].glyph1, table[i].glyph2, table[i].advance);
+    }
+}
+
+auto FontFaceSTB::get_kerning(int code_point1, int glyph1, int code_point2, int glyph2) const
+    -> int {
+    if (!has_kerning) {
+        return 0;
+    }
+    if (code_point1 >= 0 && code_point1 < 128 && code_point2 >= 0 && code_point2 < 128) {
+        return ascii_kerning[code_point1 * 128 + code_point2];
+    }
+
+    auto advance = 0;
+    if (!lazy_kerning) {
+        kerning_pairs.find(glyph1, glyph2, advance);
+        return advance;
+    }
+
+    // Lookups share the lock, only a pair seen for the first time takes it alone
+    {
+        auto lock = std::shared_lock<std::shared_mutex>(kerning_lock);
+        if (kerning_pairs.find(glyph1, glyph2, advance)) {
+            return advance;
+        }
+    }
+    advance = stbtt_GetGlyphKernAdvance(&font_info, glyph1, glyph2);
+    auto lock = std::unique_lock<std::shared_mutex>(kerning_lock);
+    kerning_pairs.insert(glyph1, glyph2, advance);
+    return advance;
+}
+
+static auto kerning_key(int glyph1, int glyph2) -> uint64_t {
+    // glyph indices are 16 bit, the +1 keeps 0 as the "empty slot" marker
+    return ((static_cast<uint64_t>(glyph1 & 0xffff) << 16) | (glyph2 & 0xffff)) + 1;
+}
+
+static auto kerning_hash(uint64_t key, size_t capacity) -> size_t {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+}
+
+auto KerningPairs::insert(int glyph1, int glyph2, int advance) -> void {
+    if ((count + 1) * 2 > slots.size()) {
+        grow();
+    }
+    auto key = kerning_key(glyph1, glyph2);
+    auto value = (key << 16) | static_cast<uint16_t>(advance);
+    auto i = kerning_hash(key, slots.size());
+    while (slots[i] != 0) {
+        if ((slots[i] >> 16) == key) {
+            slots[i] = value;
+            return;
+        }
+        i = (i + 1) & (slots.size() - 1);
+    }
+    slots[i] = value;
+    count++;
+}
+
+auto KerningPairs::find(int glyph1, int glyph2, int &advance) const -> bool {
+    if (slots.empty()) {
+        return false;
+    }
+    auto key = kerning_key(glyph1, glyph2);
+    auto i = kerning_hash(key, slots.size());
+    while (slots[i] != 0) {
+        if ((slots[i] >> 16) == key) {
+            advance = static_cast<int16_t>(slots[i] & 0xffff);
+            return true;
+        }
+        i = (i + 1) & (slots.size() - 1);
+    }
+    return false;
+}
+
+auto KerningPairs::grow() -> void {
+    auto old_slots = std::move(slots);
+    slots.assign(std::max<size_t>(64, old_slots.size() * 2), 0);
+    count = 0;
+    for (auto slot : old_slots) {
+        if (slot != 0) {
+            auto key = (slot >> 16) - 1;
+            insert(static_cast<int>(key >> 16), static_cast<int>(key & 0xffff),
+                   static_cast<int16_t>(slot & 0xffff));
+        }
+    }
+}
+
+auto FontFaceSTB::get_sdf_glyph(int glyph_index) -> const SdfGlyph & {
+    auto it = sdf_glyphs.find(glyph_index);
+    if (it != sdf_glyphs.end()) {
+        return it->second;
+    }
+
+    auto &sdf = sdf_glyphs[glyph_index];
+    auto sdf_scale = stbtt_ScaleForPixelHeight(&font_info, sdf_pixel_size);
+    auto width = 0;
+    auto height = 0;
+    auto data = stbtt_GetGlyphSDF(&font_info, sdf_scale, glyph_index, sdf_padding, sdf_on_edge,
+                                  sdf_distance_scale, &width, &height, &sdf.offset.x,
+                                  &sdf.offset.y);
+    if (!data) {
+        return sdf;
+    }
+
+    // Shelf packing, the atlas only grows down
+    constexpr auto atlas_width = 1024;
+    if (sdf_atlas.size.width == 0) {
+        sdf_atlas.resize(atlas_width, 0);
+    }
+    if (sdf_cursor.x + width > atlas_width) {
+        sdf_cursor = {0, sdf_cursor.y + sdf_row_height};
+        sdf_row_height = 0;
+    }
+    if (sdf_cursor.y + height > sdf_atlas.size.height) {
+        sdf_atlas.size.height = std::max(sdf_atlas.size.height * 2, sdf_cursor.y + height);
+        sdf_atlas.buffer.resize(atlas_width * sdf_atlas.size.height);
+    }
+    for (auto y = 0; y < height; y++) {
+        std::copy(data + y * width, data + (y + 1) * width,
+                  sdf_atlas.buffer.begin() + (sdf_cursor.y + y) * atlas_width + sdf_cursor.x);
+    }
+    stbtt_FreeSDF(data, nullptr);
+
+    sdf.position = sdf_cursor;
+    sdf.size = {width, height};
+    sdf_cursor.x += width;
+    sdf_row_height = std::max(sdf_row_height, height);
+    return sdf;
+}
+
+// Bilinear, clamped to the glyph's own cell in the atlas
+auto FontFaceSTB::sample_sdf(const SdfGlyph &sdf, float x, float y) const -> float {
+    x = std::clamp(x, 0.0f, static_cast<float>(sdf.size.width - 1));
+    y = std::clamp(y, 0.0f, static_cast<float>(sdf.size.height - 1));
+    auto x0 = static_cast<int>(x);
+    auto y0 = static_cast<int>(y);
+    auto x1 = std::min(x0 + 1, sdf.size.width - 1);
+    auto y1 = std::min(y0 + 1, sdf.size.height - 1);
+    auto fx = x - x0;
+    auto fy = y - y0;
+
+    auto row0 = sdf_atlas.buffer.data() + (sdf.position.y + y0) * sdf_atlas.size.width;
+    auto row1 = sdf_atlas.buffer.data() + (sdf.position.y + y1) * sdf_atlas.size.width;
+    auto top = row0[sdf.position.x + x0] * (1 - fx) + row0[sdf.position.x + x1] * fx;
+    auto bottom = row1[sdf.position.x + x0] * (1 - fx) + row1[sdf.position.x + x1] * fx;
+    return top * (1 - fy) + bottom * fy;
+}
+
+auto FontFaceSTB::render_sdf(int glyph_index, float scale, Glyph &glyph) -> void {
+    auto lock = std::lock_guard<std::mutex>(sdf_lock);
+    auto &sdf = get_sdf_glyph(glyph_index);
+    if (sdf.size.width == 0 || sdf.size.height == 0) {
+        return;
+    }
+
+    auto ratio = scale / stbtt_ScaleForPixelHeight(&font_info, sdf_pixel_size);
+    auto x0 = static_cast<int>(floorf(sdf.offset.x * ratio));
+    auto y0 = static_cast<int>(floorf(sdf.offset.y * ratio));
+    auto x1 = static_cast<int>(ceilf((sdf.offset.x + sdf.size.width) * ratio));
+    auto y1 = static_cast<int>(ceilf((sdf.offset.y + sdf.size.height) * ratio));
+    glyph.offset = {x0, y0};
+    glyph.mask.resize(x1 - x0, y1 - y0);
+
+    // Distance from the edge in target pixels, smoothstep over one pixel around the edge
+    auto distance_scale = ratio / sdf_distance_scale;
+    for (auto y = 0; y < glyph.mask.size.height; y++) {
+        auto sdf_y = (y0 + y + 0.5f) / ratio - sdf.offset.y - 0.5f;
+        for (auto x = 0; x < glyph.mask.size.width; x++) {
+            auto sdf_x = (x0 + x + 0.5f) / ratio - sdf.offset.x - 0.5f;
+            auto distance = (sample_sdf(sdf, sdf_x, sdf_y) - sdf_on_edge) * distance_scale;
+            auto t = std::clamp(distance + 0.5f, 0.0f, 1.0f);
+            auto alpha = t * t * (3 - 2 * t);
+            auto index = y * glyph.mask.size.width + x;
+            glyph.mask.buffer[index] = static_cast<uint8_t>(alpha * 255 + 0.5f);
+        }
+    }
+}
+
+FontProviderSTB::FontProviderSTB(const std::string_view default_font, int size)
+    : FontProviderSTB(std::make_shared<FontFaceSTB>(default_font), size) {}
+
+FontProviderSTB::FontProviderSTB(std::shared_ptr<FontFaceSTB> face, int size) {
+    this->face = face;
+    this->fontSize = size;
+}
+
+auto FontProviderSTB::with_size(int pixel_size) -> std::shared_ptr<FontProvider> {
+    wait_for_prewarm();
+    auto provider = std::make_shared<FontProviderSTB>(face, pixel_size);
+    provider->fallbacks = fallbacks;
+    provider->set_use_sdf(use_sdf);
+    return provider;
+}
+
+auto FontProviderSTB::add_fallback(const std::string_view font_file) -> bool {
+    return add_fallback(std::make_shared<FontFaceSTB>(font_file));
+}
+
+auto FontProviderSTB::add_fallback(std::shared_ptr<FontFaceSTB> fallback) -> bool {
+    wait_for_prewarm();
+    if (!fallback->is_valid) {
+        return false;
+    }
+    fallbacks.push_back(fallback);
+
+    // Glyphs which were missing may now come from the new face
+    cached_size = 0;
+    bump_generation();
+    return true;
+}
+
+auto FontProviderSTB::set_use_sdf(bool new_use_sdf) -> void {
+    wait_for_prewarm();
+    if (use_sdf == new_use_sdf) {
+        return;
+    }
+    use_sdf = new_use_sdf;
+    bump_generation();
+}
+
+auto FontProviderSTB::face_for(int code_point) const -> int {
+    if (face->coverage.contains(code_point)) {
+        return 0;
+    }
+    for (auto i = 0u; i < fallbacks.size(); i++) {
+        if (fallbacks[i]->coverage.contains(code_point)) {
+            return i + 1;
+        }
+    }
+    // Nobody has it, let the main face draw its "missing glyph"
+    return 0;
+}
+
+auto FontProviderSTB::update_metrics() -> void {
+    if (cached_size == fontSize && cached_sdf == use_sdf) {
+        return;
+    }
+    glyphs.clear();
+    ascii_glyphs = {};
+    cached_size = fontSize;
+    cached_sdf = use_sdf;
+    scale = stbtt_ScaleForPixelHeight(&face->font_info, static_cast<float>(fontSize));
+    scales.assign(1, scale);
+    for (auto &fallback : fallbacks) {
+        scales.push_back(
+            stbtt_ScaleForPixelHeight(&fallback->font_info, static_cast<float>(fontSize)));
+    }
+    ascent = static_cast<int>(face->ascent * scale);
+    descent = static_cast<int>(face->descent * scale);
+    line_gap = static_cast<int>(face->line_gap * scale);
+}
+
+auto FontProviderSTB::get_glyph(int code_point) -> const Glyph & {
+    auto is_ascii = code_point >= 0 && code_point < 128;
+    if (is_ascii && ascii_glyphs[code_point]) {
+        return *ascii_glyphs[code_point];
+    }
+    auto it = glyphs.find(code_point);
+    if (it != glyphs.end()) {
+        return it->second;
+    }
+
+    auto &glyph = glyphs[code_point];
+    if (is_ascii) {
+        ascii_glyphs[code_point] = &glyph;
+    }
+    glyph.face = face_for(code_point);
+    auto &font_info = face_at(glyph.face).font_info;
+    auto face_scale = scales[glyph.face];
+    auto advance = 0;
+    auto lsb = 0;
+    auto x0 = 0;
+    auto y0 = 0;
+    auto x1 = 0;
+    auto y1 = 0;
+
+    glyph.index = stbtt_FindGlyphIndex(&font_info, code_point);
+    stbtt_GetGlyphHMetrics(&font_info, glyph.index, &advance, &lsb);
+    stbtt_GetGlyphBitmapBox(&font_info, glyph.index, face_scale, face_scale, &x0, &y0, &x1, &y1);
+    glyph.advance = advance * face_scale;
+    if (use_sdf) {
+        face_at(glyph.face).render_sdf(glyph.index, face_scale, glyph);
+        return glyph;
+    }
+    glyph.offset = {x0, y0};
+    if (x1 > x0 && y1 > y0) {
+        auto &mask = glyph.mask;
+        mask.resize(x1 - x0, y1 - y0);
+        stbtt_MakeGlyphBitmap(&font_info, mask.buffer.data(), mask.size.width, mask.size.height,
+                              mask.size.width, face_scale, face_scale, glyph.index);
+    }
+    return glyph;
+}
+
+auto FontProviderSTB::load_glyphs(const std::u32string &code_points) -> int {
+    if (!face->is_valid) {
+        return 0;
+    }
+    update_metrics();
+    for (auto code_point : code_points) {
+        get_glyph(code_point);
+    }
+    return static_cast<int>(code_points.size());
 }
 
 void FontProviderSTB::write(Bitmap &bitmap, Position position, const std::string_view text,
                             uint32_t color) {
-    int ascent, descent, lineGap;
+    wait_for_prewarm();
+    if (!face->is_valid) {
+        return;
+    }
+    update_metrics();
+
     auto x = position.x;
     auto y = position.y;
 
-    float scale = stbtt_ScaleForPixelHeight(&font_info, static_cast<float>(fontSize));
-    stbtt_GetFontVMetrics(&font_info, &ascent, &descent, &lineGap);
-    ascent = ascent * scale;
-
     if (debug_render) {
         auto text_bounds = text_size(text);
         bitmap.draw_rectangle(position.x, position.y, text_bounds.width, text_bounds.height,
@@ -84,80 +450,61 @@ void FontProviderSTB::write(Bitmap &bitmap, Position position, const std::string
         bitmap.line(position.x, yyy, position.x + text_bounds.width, yyy, 0xff8080);
     }
 
-    auto it = text.begin();
-    const auto end = text.end();
-    auto last_point = 0;
-    while (it != end) {
-        auto code_point = extractUnicodeCharacter(it);
-        auto advance = 0;
-        auto lsb = 0;
-        auto glyphWidth = 0;
-        auto glyphHeight = 0;
-        auto gx = 0;
-        auto gy = 0;
-
-        if (last_point != 0) {
-            auto kern = stbtt_GetCodepointKernAdvance(&font_info, last_point, code_point);
-            x += roundf(kern * scale);
-        }
+    auto last_code_point = 0;
+    auto last_glyph = 0;
+    auto last_face = 0;
+    utf8_for_each(text, [&](char32_t c) {
+        auto code_point = static_cast<int>(c);
+        auto &glyph = get_glyph(code_point);
 
-        auto bitmapBuffer = static_cast<unsigned char *>(nullptr);
-        auto glyphIndex = stbtt_FindGlyphIndex(&font_info, code_point);
-        stbtt_GetCodepointHMetrics(&font_info, code_point, &advance, &lsb);
-        bitmapBuffer = stbtt_GetGlyphBitmap(&font_info, scale, scale, glyphIndex, &glyphWidth,
-                                            &glyphHeight, &gx, &gy);
-
-        if (bitmapBuffer) {
-            for (auto yy = 0; yy < glyphHeight; ++yy) {
-                for (auto xx = 0; xx < glyphWidth; ++xx) {
-                    auto index = yy * glyphWidth + xx;
-                    if (bitmapBuffer[index] > 10) {
-                        auto targetX = x + xx + gx;
-                        auto targetY = y + yy + gy + ascent;
-                        bitmap.blend_pixel(targetX, targetY, color, bitmapBuffer[index]);
-                    }
-                }
-            }
+        if (last_glyph != 0 && last_face == glyph.face) {
+            auto kern = face_at(glyph.face).get_kerning(last_code_point, last_glyph, code_point,
+                                                        glyph.index);
+            x += roundf(kern * scales[glyph.face]);
         }
-        stbtt_FreeBitmap(bitmapBuffer, 0);
-        x += static_cast<int>(advance * scale);
-        last_point = code_point;
-    }
+
+        bitmap.blend_mask(glyph.mask, {x + glyph.offset.x, y + glyph.offset.y + ascent}, color);
+        x += static_cast<int>(glyph.advance);
+        last_code_point = code_point;
+        last_glyph = glyph.index;
+        last_face = glyph.face;
+    });
 }
 
 auto FontProviderSTB::text_size(const std::string_view text) -> Size {
+    wait_for_prewarm();
+    if (!face->is_valid) {
+        return {0, 0};
+    }
+    update_metrics();
+
     auto metrics = Size{};
-    auto ascent = 0;
-    auto descent = 0;
-    auto lineGap = 0;
     auto x0 = 0;
     auto y0 = 0;
     auto x1 = 0;
     auto y1 = 0;
-
-    stbtt_GetFontVMetrics(&font_info, &ascent, &descent, &lineGap);
-    auto scale = stbtt_ScaleForPixelHeight(&font_info, (float)fontSize);
-    auto baseline = (int)(ascent * scale);
-    auto last_point = 0;
-    auto it = text.begin();
-    auto const end = text.end();
-
-    while (it != end) {
-        auto code_point = extractUnicodeCharacter(it);
-        if (last_point != 0) {
-            auto kern = stbtt_GetCodepointKernAdvance(&font_info, last_point, code_point);
-            x1 += roundf(kern * scale);
-        }
+    auto last_code_point = 0;
+    auto last_glyph = 0;
+    auto last_face = 0;
+    utf8_for_each(text, [&](char32_t c) {
+        auto code_point = static_cast<int>(c);
         if (code_point == '\n') {
-            y0 -= (ascent - descent + lineGap) * scale;
-            continue;
+            y0 -= ascent - descent + line_gap;
+            return;
         }
-        int advance, lsb;
-        stbtt_GetCodepointHMetrics(&font_info, code_point, &advance, &lsb);
-        x1 = x0 + advance * scale;
-        y1 = y0 + baseline;
+        auto &glyph = get_glyph(code_point);
+        if (last_glyph != 0 && last_face == glyph.face) {
+            auto kern = face_at(glyph.face).get_kerning(last_code_point, last_glyph, code_point,
+                                                        glyph.index);
+            x0 += roundf(kern * scales[glyph.face]);
+        }
+        x1 = x0 + glyph.advance;
+        y1 = y0 + ascent;
         x0 = x1;
-    }
+        last_code_point = code_point;
+        last_glyph = glyph.index;
+        last_face = glyph.face;
+    });
 
     metrics.width = x1;
     metrics.height = y1;
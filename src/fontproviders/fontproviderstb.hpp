@@ -10,15 +10,126 @@
 #include <fontprovider.h>
 #include <stb/stb_truetype.h>
 
+#include <array>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+// Kerning of glyph pairs, in font units. Open addressing, each slot packs the pair and the
+// advance into a single 64 bit value, so a lookup is usually one cache line.
+struct KerningPairs {
+    auto insert(int glyph1, int glyph2, int advance) -> void;
+    auto find(int glyph1, int glyph2, int &advance) const -> bool;
+    auto size() const -> size_t { return count; }
+
+  private:
+    auto grow() -> void;
+    std::vector<uint64_t> slots;
+    size_t count = 0;
+};
+
+// The parsed font file. This is shared between all the sizes of the same font, and is
+// read only after construction.
+struct FontFaceSTB {
+    explicit FontFaceSTB(const std::string_view font_file);
+
+    stbtt_fontinfo font_info = {};
+    std::vector<unsigned char> font_data;
+    bool is_valid = false;
+
+    // In font units, scale them using the size
+    int ascent = 0;
+    int descent = 0;
+    int line_gap = 0;
+
+    CodePointCoverage coverage;
+
+    // Kerning between two glyphs, in font units. ASCII pairs are found in a dense table,
+    // all other pairs in a hash built from the kern table.
+    auto get_kerning(int code_point1, int glyph1, int code_point2, int glyph2) const -> int;
+
+    // Renders a glyph at `scale` from its signed distance field. The field is made once per
+    // glyph at sdf_pixel_size, and kept in an atlas shared by all sizes of this face.
+    auto render_sdf(int glyph_index, float scale, Glyph &glyph) -> void;
+
+    static constexpr int sdf_pixel_size = 64;
+    static constexpr int sdf_padding = 6;
+    static constexpr unsigned char sdf_on_edge = 128;
+    static constexpr float sdf_distance_scale = 128.0f / sdf_padding;
+
+  private:
+    struct SdfGlyph {
+        Position position = {};
+        Position offset = {};
+        Size size = {};
+    };
+    auto get_sdf_glyph(int glyph_index) -> const SdfGlyph &;
+    auto sample_sdf(const SdfGlyph &sdf, float x, float y) const -> float;
+
+    AlphaMask sdf_atlas;
+    Position sdf_cursor = {};
+    int sdf_row_height = 0;
+    std::unordered_map<int, SdfGlyph> sdf_glyphs;
+    std::mutex sdf_lock;
+
+    auto build_coverage() -> void;
+    auto build_kerning() -> void;
+
+    bool has_kerning = false;
+    std::vector<int16_t> ascii_kerning;
+
+    // GPOS pairs cannot be listed upfront, these are added on first use
+    bool lazy_kerning = false;
+    mutable KerningPairs kerning_pairs;
+    mutable std::shared_mutex kerning_lock;
+};
+
 struct FontProviderSTB : FontProvider {
-    explicit FontProviderSTB(const std::string_view default_font);
+    explicit FontProviderSTB(const std::string_view default_font, int size = 16);
+    FontProviderSTB(std::shared_ptr<FontFaceSTB> face, int size);
+    virtual ~FontProviderSTB() override { wait_for_prewarm(); }
 
     auto virtual write(Bitmap &, Position, const std::string_view, const uint32_t color)
         -> void override;
     auto virtual text_size(const std::string_view str) -> Size override;
+    auto virtual with_size(int pixel_size) -> std::shared_ptr<FontProvider> override;
+    auto virtual get_size() const -> int override { return fontSize; }
+    auto virtual add_fallback(const std::string_view font_file) -> bool override;
+    auto add_fallback(std::shared_ptr<FontFaceSTB> fallback) -> bool;
 
-    stbtt_fontinfo font_info;
-    std::vector<unsigned char> font_data;
+    std::shared_ptr<FontFaceSTB> face;
+    std::vector<std::shared_ptr<FontFaceSTB>> fallbacks;
     int fontSize = 16;
     bool debug_render = false;
+
+    // Scale glyphs from signed distance fields, instead of rasterizing the outlines for every
+    // size. Cheaper when the size changes often, slightly softer at small sizes.
+    auto get_use_sdf() const -> bool { return use_sdf; }
+    auto set_use_sdf(bool new_use_sdf) -> void;
+
+  protected:
+    auto virtual load_glyphs(const std::u32string &code_points) -> int override;
+
+  private:
+    auto update_metrics() -> void;
+    auto get_glyph(int code_point) -> const Glyph &;
+    auto face_for(int code_point) const -> int;
+    auto face_at(int index) const -> FontFaceSTB & {
+        return index == 0 ? *face : *fallbacks[index - 1];
+    }
+
+    bool use_sdf = false;
+
+    // Per size cache, valid for `cached_size`
+    int cached_size = 0;
+    bool cached_sdf = false;
+    float scale = 0;
+    std::vector<float> scales;
+    int ascent = 0;
+    int descent = 0;
+    int line_gap = 0;
+    std::unordered_map<int, Glyph> glyphs;
+    std::array<const Glyph *, 128> ascii_glyphs = {};
 };
@@ -12,7 +12,9 @@
 #include <widget.h>
 
 struct Label : public Widget {
-    std::string text;
+    // Keep the rendered text between redraws, for text which rarely changes
+    bool cache_text = false;
+    TextRun text_run;
 
     Label(std::string_view text) : Widget({}, {}, 0) {
         this->text = text;
@@ -29,8 +31,21 @@ struct Label : public Widget {
         auto my_theme = get_theme();
         auto color = my_theme->colors.text_color;
         auto text_padding = my_theme->get_padding().get_horizontal();
-        auto text_size = my_theme->font->text_size(text);
+        auto run = cache_text ? &text_run : nullptr;
+        auto text_size = my_theme->measure_text(text, run);
         auto centered = content.size.centered(text_size, text_padding);
-        my_theme->font->write(content, centered, text, color);
+        my_theme->draw_text(content, centered, text, color, run);
+    }
+
+    // The size hint depends on the text, it is only changed through `set_text()`
+    auto get_text() const -> const std::string & { return text; }
+    auto set_text(std::string_view new_text) -> std::shared_ptr<Label> {
+        this->text = new_text;
+        invalidate_size_hint();
+        invalidate();
+        return std::dynamic_pointer_cast<Label>(this->shared_from_this());
     }
+
+  private:
+    std::string text;
 };
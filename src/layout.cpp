@@ -5,11 +5,12 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
 #include <cmath>
 #include <layout.h>
 
 auto HorizontalLayout::relayout(Position position, const Size size) -> void {
-    if (sub_items.empty()) {
+    if (sub_items.empty() || !needs_relayout(position, size)) {
         return;
     }
     auto recommended_size = Size{};
@@ -19,14 +20,16 @@ auto HorizontalLayout::relayout(Position position, const Size size) -> void {
     // from the list
     auto widget_count = 0;
     auto width = size.width - margin.get_horizontal();
-    for (auto &item : sub_items) {
-        if (item->ignore_layout()) {
+    auto &items = get_item_data();
+    auto count = sub_items.size();
+    for (size_t i = 0; i < count; i++) {
+        if (!items.visible[i]) {
             continue;
         }
-        auto hint = item->size_hint();
+        auto hint = items.hints[i];
         if (hint.width <= 0) {
             widget_count++;
-            total_weight += item->weight;
+            total_weight += items.weights[i];
         } else {
             width -= hint.width;
         }
@@ -54,13 +57,13 @@ auto HorizontalLayout::relayout(Position position, const Size size) -> void {
 
     // Second pass - resize items. Width is computed, unless the
     // widget has a size hint. In such case - we enforce it.
-    for (auto &item : sub_items) {
-        if (item->ignore_layout()) {
+    for (size_t i = 0; i < count; i++) {
+        if (!items.visible[i]) {
             continue;
         }
-        auto hint = item->size_hint();
+        auto hint = items.hints[i];
         if (hint.width <= 0) {
-            recommended_size.width = std::roundl((width * item->weight) / total_weight);
+            recommended_size.width = std::roundl((width * items.weights[i]) / total_weight);
 
         } else {
             recommended_size.width = hint.width;
@@ -70,12 +73,12 @@ auto HorizontalLayout::relayout(Position position, const Size size) -> void {
             recommended_size.height = hint.height;
         }
 
-        if (item != *sub_items.begin()) {
+        if (i != 0) {
             position.x += padding.start;
         }
-        item->relayout(position, recommended_size);
+        sub_items[i]->relayout(position, recommended_size);
         position.x += recommended_size.width;
-        if (item != *std::prev(sub_items.end())) {
+        if (i != count - 1) {
             position.x += padding.end;
         }
     }
@@ -87,12 +90,13 @@ auto HorizontalLayout::size_hint() const -> Size {
     auto has_auto_width = false;
     auto has_auto_height = false;
 
-    for (auto &item : sub_items) {
-        if (item->ignore_layout()) {
+    auto &items = get_item_data();
+    for (size_t i = 0; i < sub_items.size(); i++) {
+        if (!items.visible[i]) {
             continue;
         }
         wideget_count++;
-        auto item_hint = item->size_hint();
+        auto item_hint = items.hints[i];
         if (item_hint.width != 0) {
             hint.width = std::max(item_hint.width, hint.width);
         } else {
@@ -123,7 +127,7 @@ auto HorizontalLayout::size_hint() const -> Size {
 }
 
 auto VerticalLayout::relayout(Position position, const Size size) -> void {
-    if (sub_items.empty()) {
+    if (sub_items.empty() || !needs_relayout(position, size)) {
         return;
     }
     auto recommended_size = Size{};
@@ -133,14 +137,16 @@ auto VerticalLayout::relayout(Position position, const Size size) -> void {
     // from the list
     auto widget_count = 0;
     auto height = size.height - margin.get_vertical();
-    for (auto &item : sub_items) {
-        if (item->ignore_layout()) {
+    auto &items = get_item_data();
+    auto count = sub_items.size();
+    for (size_t i = 0; i < count; i++) {
+        if (!items.visible[i]) {
             continue;
         }
-        auto hint = item->size_hint();
+        auto hint = items.hints[i];
         if (hint.height <= 0) {
             widget_count++;
-            total_weight += item->weight;
+            total_weight += items.weights[i];
         } else {
             height -= hint.height;
         }
@@ -168,14 +174,13 @@ auto VerticalLayout::relayout(Position position, const Size size) -> void {
 
     // Second pass - resize items. Height is computed, unless the
     // widget has a size hint. In such case - we enforce it.
-    for (auto &item : sub_items) {
-        if (item->ignore_layout()) {
+    for (size_t i = 0; i < count; i++) {
+        if (!items.visible[i]) {
             continue;
         }
-        auto hint = item->size_hint();
+        auto hint = items.hints[i];
         if (hint.height <= 0) {
-            recommended_size.height = height / widget_count;
-            recommended_size.height = std::lround((height * item->weight) / total_weight);
+            recommended_size.height = std::lround((height * items.weights[i]) / total_weight);
         } else {
             recommended_size.height = hint.height;
         }
@@ -183,12 +188,12 @@ auto VerticalLayout::relayout(Position position, const Size size) -> void {
             recommended_size.width = hint.width;
         }
 
-        if (item != *sub_items.begin()) {
+        if (i != 0) {
             position.y += padding.top;
         }
-        item->relayout(position, recommended_size);
+        sub_items[i]->relayout(position, recommended_size);
         position.y += recommended_size.height;
-        if (item != *std::prev(sub_items.end())) {
+        if (i != count - 1) {
             position.y += padding.bottom;
         }
     }
@@ -200,12 +205,13 @@ auto VerticalLayout::size_hint() const -> Size {
     auto has_auto_width = false;
     auto has_auto_height = false;
 
-    for (auto &item : sub_items) {
-        if (item->ignore_layout()) {
+    auto &items = get_item_data();
+    for (size_t i = 0; i < sub_items.size(); i++) {
+        if (!items.visible[i]) {
             continue;
         }
         widget_count++;
-        auto item_hint = item->size_hint();
+        auto item_hint = items.hints[i];
         if (item_hint.height != 0) {
             hint.height = std::max(item_hint.height, hint.height);
         } else {
@@ -236,4 +242,478 @@ auto VerticalLayout::size_hint() const -> Size {
     return hint;
 }
 
-auto LayoutItem::remove_all() -> void { this->sub_items.clear(); }
+auto LayoutItem::get_size_hint() const -> Size {
+    if (!has_size_hint) {
+        cached_size_hint = size_hint();
+        has_size_hint = true;
+    }
+    return cached_size_hint;
+}
+
+auto LayoutItem::invalidate_size_hint() -> void {
+    for (auto item = this; item != nullptr; item = item->parent_item) {
+        item->has_size_hint = false;
+        item->has_item_data = false;
+        item->needs_layout = true;
+    }
+}
+
+auto LayoutItem::set_padding(LayoutParams new_padding) -> void {
+    padding = new_padding;
+    invalidate_size_hint();
+}
+
+auto LayoutItem::set_margin(LayoutParams new_margin) -> void {
+    margin = new_margin;
+    invalidate_size_hint();
+}
+
+auto LayoutItem::set_weight(double new_weight) -> void {
+    weight = new_weight;
+    invalidate_size_hint();
+}
+
+auto LayoutItem::get_item_data() const -> const LayoutItemData & {
+    if (has_item_data) {
+        return item_data;
+    }
+    auto count = sub_items.size();
+    item_data.hints.resize(count);
+    item_data.weights.resize(count);
+    item_data.visible.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        auto &item = sub_items[i];
+        item_data.visible[i] = !item->ignore_layout();
+        item_data.hints[i] = item_data.visible[i] ? item->get_size_hint() : Size{};
+        item_data.weights[i] = item->weight;
+    }
+    item_data.generation++;
+    has_item_data = true;
+    return item_data;
+}
+
+auto LayoutItem::needs_relayout(Position position, Size size) -> bool {
+    if (!needs_layout && position == laid_out_position && size == laid_out_size) {
+        return false;
+    }
+    needs_layout = false;
+    laid_out_position = position;
+    laid_out_size = size;
+    return true;
+}
+
+auto LayoutItem::remove_all() -> void {
+    this->sub_items.clear();
+    invalidate_size_hint();
+}
+
+// Tracks with a size keep it, the others share what is left of `available`
+static auto distribute_tracks(const std::vector<int> &fixed, int available, int spacing)
+    -> std::vector<int> {
+    auto tracks = fixed;
+    auto flexible = 0;
+    auto free = available - spacing * std::max(0, static_cast<int>(tracks.size()) - 1);
+    for (auto track : tracks) {
+        if (track > 0) {
+            free -= track;
+        } else {
+            flexible++;
+        }
+    }
+    if (flexible == 0) {
+        return tracks;
+    }
+    free = std::max(free, 0);
+    auto share = free / flexible;
+    auto remainder = free % flexible;
+    for (auto &track : tracks) {
+        if (track <= 0) {
+            track = share + (remainder > 0 ? 1 : 0);
+            remainder--;
+        }
+    }
+    return tracks;
+}
+
+auto GridLayout::set_columns(int new_columns) -> void {
+    if (columns == new_columns) {
+        return;
+    }
+    columns = new_columns;
+    invalidate_size_hint();
+}
+
+auto GridLayout::remove_all() -> void {
+    cells.clear();
+    LayoutItem::remove_all();
+}
+
+auto GridLayout::measure() const -> const Measure & {
+    auto &items = get_item_data();
+    if (is_measured && measured.generation == items.generation) {
+        return measured;
+    }
+
+    auto count = sub_items.size();
+    auto column_count = std::max(columns, 1);
+    auto total_columns = 0;
+    auto total_rows = 0;
+    auto next_cell = 0;
+    measured.cells.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        auto cell = i < cells.size() ? cells[i] : Cell{};
+        if (cell.row < 0 || cell.column < 0) {
+            cell.row = next_cell / column_count;
+            cell.column = next_cell % column_count;
+            next_cell++;
+        }
+        cell.row_span = std::max(cell.row_span, 1);
+        cell.column_span = std::max(cell.column_span, 1);
+        total_columns = std::max(total_columns, cell.column + cell.column_span);
+        total_rows = std::max(total_rows, cell.row + cell.row_span);
+        measured.cells[i] = cell;
+    }
+
+    // Spanning items do not size the tracks, they get the sum of them
+    measured.widths.assign(total_columns, 0);
+    measured.heights.assign(total_rows, 0);
+    for (size_t i = 0; i < count; i++) {
+        if (!items.visible[i]) {
+            continue;
+        }
+        auto &cell = measured.cells[i];
+        auto hint = items.hints[i];
+        if (cell.column_span == 1) {
+            measured.widths[cell.column] = std::max(measured.widths[cell.column], hint.width);
+        }
+        if (cell.row_span == 1) {
+            measured.heights[cell.row] = std::max(measured.heights[cell.row], hint.height);
+        }
+    }
+    measured.generation = items.generation;
+    is_measured = true;
+    return measured;
+}
+
+auto GridLayout::relayout(Position position, const Size size) -> void {
+    if (sub_items.empty() || !needs_relayout(position, size)) {
+        return;
+    }
+    auto &items = get_item_data();
+    auto &m = measure();
+    auto spacing = Size{padding.get_horizontal(), padding.get_vertical()};
+    auto widths = distribute_tracks(m.widths, size.width - margin.get_horizontal(), spacing.width);
+    auto heights =
+        distribute_tracks(m.heights, size.height - margin.get_vertical(), spacing.height);
+
+    // Start of every track, and one past the last
+    auto x = std::vector<int>(widths.size() + 1, position.x + margin.start);
+    auto y = std::vector<int>(heights.size() + 1, position.y + margin.top);
+    for (size_t i = 0; i < widths.size(); i++) {
+        x[i + 1] = x[i] + widths[i] + spacing.width;
+    }
+    for (size_t i = 0; i < heights.size(); i++) {
+        y[i + 1] = y[i] + heights[i] + spacing.height;
+    }
+
+    for (size_t i = 0; i < sub_items.size(); i++) {
+        if (!items.visible[i]) {
+            continue;
+        }
+        auto &cell = m.cells[i];
+        auto last_column = cell.column + cell.column_span;
+        auto last_row = cell.row + cell.row_span;
+        auto cell_position = Position{x[cell.column], y[cell.row]};
+        auto cell_size = Size{x[last_column] - x[cell.column] - spacing.width,
+                              y[last_row] - y[cell.row] - spacing.height};
+        sub_items[i]->relayout(cell_position, cell_size);
+    }
+}
+
+auto GridLayout::size_hint() const -> Size {
+    auto &m = measure();
+    if (m.widths.empty()) {
+        return {};
+    }
+    auto hint = Size{margin.get_horizontal(), margin.get_vertical()};
+    hint.width += padding.get_horizontal() * (static_cast<int>(m.widths.size()) - 1);
+    hint.height += padding.get_vertical() * (static_cast<int>(m.heights.size()) - 1);
+    for (auto width : m.widths) {
+        if (width <= 0) {
+            hint.width = 0;
+            break;
+        }
+        hint.width += width;
+    }
+    for (auto height : m.heights) {
+        if (height <= 0) {
+            hint.height = 0;
+            break;
+        }
+        hint.height += height;
+    }
+    return hint;
+}
+
+static auto main_axis(FlexDirection direction, Size size) -> int {
+    return direction == FlexDirection::Row ? size.width : size.height;
+}
+
+static auto cross_axis(FlexDirection direction, Size size) -> int {
+    return direction == FlexDirection::Row ? size.height : size.width;
+}
+
+static auto clamp_to_limits(int value, int min, int max) -> int {
+    value = std::max(value, min);
+    if (max > 0) {
+        value = std::min(value, max);
+    }
+    return value;
+}
+
+auto FlexLayout::set_direction(FlexDirection new_direction) -> void {
+    if (direction == new_direction) {
+        return;
+    }
+    direction = new_direction;
+    invalidate_size_hint();
+}
+
+auto FlexLayout::set_justify(FlexJustify new_justify) -> void {
+    if (justify == new_justify) {
+        return;
+    }
+    justify = new_justify;
+    invalidate_size_hint();
+}
+
+auto FlexLayout::set_align(FlexAlign new_align) -> void {
+    if (align == new_align) {
+        return;
+    }
+    align = new_align;
+    invalidate_size_hint();
+}
+
+auto FlexLayout::set_wrap(bool new_wrap) -> void {
+    if (wrap == new_wrap) {
+        return;
+    }
+    wrap = new_wrap;
+    invalidate_size_hint();
+}
+
+auto FlexLayout::remove_all() -> void {
+    item_params.clear();
+    LayoutItem::remove_all();
+}
+
+auto FlexLayout::measure() const -> const Measure & {
+    auto &items = get_item_data();
+    if (is_measured && measured.generation == items.generation) {
+        return measured;
+    }
+
+    auto count = sub_items.size();
+    measured.basis.resize(count);
+    measured.cross.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        auto params = get_params(i);
+        auto hint = items.hints[i];
+        measured.basis[i] = clamp_to_limits(main_axis(direction, hint),
+                                            main_axis(direction, params.min),
+                                            main_axis(direction, params.max));
+        measured.cross[i] = cross_axis(direction, hint);
+    }
+    measured.generation = items.generation;
+    is_measured = true;
+    return measured;
+}
+
+auto FlexLayout::relayout(Position position, const Size size) -> void {
+    if (sub_items.empty() || !needs_relayout(position, size)) {
+        return;
+    }
+    struct Line {
+        size_t first = 0;
+        size_t last = 0;
+        int cross = 0;
+    };
+
+    auto &items = get_item_data();
+    auto &m = measure();
+    auto is_row = direction == FlexDirection::Row;
+    auto gap = is_row ? padding.get_horizontal() : padding.get_vertical();
+    auto cross_gap = is_row ? padding.get_vertical() : padding.get_horizontal();
+    auto inner = Size{size.width - margin.get_horizontal(), size.height - margin.get_vertical()};
+    auto available = main_axis(direction, inner);
+    auto available_cross = cross_axis(direction, inner);
+    auto count = sub_items.size();
+
+    // Break items into lines, a line is as high as its highest item
+    auto lines = std::vector<Line>();
+    auto line_main = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!items.visible[i]) {
+            continue;
+        }
+        auto is_first = lines.empty();
+        if (!is_first && wrap && line_main + gap + m.basis[i] > available) {
+            is_first = true;
+        }
+        if (is_first) {
+            lines.push_back({i, i, 0});
+            line_main = m.basis[i];
+        } else {
+            line_main += gap + m.basis[i];
+        }
+        lines.back().last = i;
+        lines.back().cross = std::max(lines.back().cross, m.cross[i]);
+    }
+    if (lines.empty()) {
+        return;
+    }
+
+    // Lines without a cross size share the cross space left by the others
+    if (!wrap) {
+        lines[0].cross = available_cross;
+    } else {
+        auto free_cross = available_cross - cross_gap * (static_cast<int>(lines.size()) - 1);
+        auto auto_lines = 0;
+        for (auto &line : lines) {
+            free_cross -= line.cross;
+            auto_lines += line.cross == 0 ? 1 : 0;
+        }
+        for (auto &line : lines) {
+            if (line.cross == 0) {
+                line.cross = std::max(free_cross, 0) / auto_lines;
+            }
+        }
+    }
+
+    auto sizes = std::vector<int>(count, 0);
+    auto cross_offset = 0;
+    for (auto &line : lines) {
+        auto used = -gap;
+        auto total_grow = 0.0;
+        auto total_shrink = 0.0;
+        auto item_count = 0;
+        for (auto i = line.first; i <= line.last; i++) {
+            if (!items.visible[i]) {
+                continue;
+            }
+            auto params = get_params(i);
+            used += gap + m.basis[i];
+            total_grow += params.grow;
+            total_shrink += params.shrink * m.basis[i];
+            item_count++;
+        }
+
+        // Grow into free space, or shrink proportionally to the size of the items
+        auto free = available - used;
+        auto line_main = -gap;
+        for (auto i = line.first; i <= line.last; i++) {
+            if (!items.visible[i]) {
+                continue;
+            }
+            auto params = get_params(i);
+            auto item_main = static_cast<double>(m.basis[i]);
+            if (free > 0 && total_grow > 0) {
+                item_main += free * params.grow / total_grow;
+            } else if (free < 0 && total_shrink > 0) {
+                item_main += free * params.shrink * m.basis[i] / total_shrink;
+            }
+            sizes[i] = clamp_to_limits(std::lround(item_main), main_axis(direction, params.min),
+                                       main_axis(direction, params.max));
+            line_main += gap + sizes[i];
+        }
+
+        auto leftover = std::max(available - line_main, 0);
+        auto main_offset = 0;
+        auto spacing = gap;
+        switch (justify) {
+        case FlexJustify::Start:
+            break;
+        case FlexJustify::Center:
+            main_offset = leftover / 2;
+            break;
+        case FlexJustify::End:
+            main_offset = leftover;
+            break;
+        case FlexJustify::SpaceBetween:
+            if (item_count > 1) {
+                spacing += leftover / (item_count - 1);
+            }
+            break;
+        }
+
+        for (auto i = line.first; i <= line.last; i++) {
+            if (!items.visible[i]) {
+                continue;
+            }
+            auto params = get_params(i);
+            auto item_cross = m.cross[i];
+            if (align == FlexAlign::Stretch || item_cross <= 0) {
+                item_cross = line.cross;
+            }
+            item_cross = clamp_to_limits(item_cross, cross_axis(direction, params.min),
+                                         cross_axis(direction, params.max));
+            auto item_cross_offset = cross_offset;
+            if (align == FlexAlign::Center) {
+                item_cross_offset += (line.cross - item_cross) / 2;
+            } else if (align == FlexAlign::End) {
+                item_cross_offset += line.cross - item_cross;
+            }
+
+            auto item_position = Position{position.x + margin.start, position.y + margin.top};
+            auto item_size = Size{};
+            if (is_row) {
+                item_position.x += main_offset;
+                item_position.y += item_cross_offset;
+                item_size = {sizes[i], item_cross};
+            } else {
+                item_position.x += item_cross_offset;
+                item_position.y += main_offset;
+                item_size = {item_cross, sizes[i]};
+            }
+            sub_items[i]->relayout(item_position, item_size);
+            main_offset += sizes[i] + spacing;
+        }
+        cross_offset += line.cross + cross_gap;
+    }
+}
+
+auto FlexLayout::size_hint() const -> Size {
+    auto &items = get_item_data();
+    auto &m = measure();
+    auto main = 0;
+    auto cross = 0;
+    auto item_count = 0;
+    auto has_auto_main = wrap;
+    auto has_auto_cross = wrap;
+    for (size_t i = 0; i < sub_items.size(); i++) {
+        if (!items.visible[i]) {
+            continue;
+        }
+        item_count++;
+        main += m.basis[i];
+        cross = std::max(cross, m.cross[i]);
+        has_auto_main |= m.basis[i] <= 0 || get_params(i).grow > 0;
+        has_auto_cross |= m.cross[i] <= 0;
+    }
+    if (item_count == 0) {
+        return {};
+    }
+
+    auto is_row = direction == FlexDirection::Row;
+    main += (item_count - 1) * (is_row ? padding.get_horizontal() : padding.get_vertical());
+    main += is_row ? margin.get_horizontal() : margin.get_vertical();
+    cross += is_row ? margin.get_vertical() : margin.get_horizontal();
+    if (has_auto_main) {
+        main = 0;
+    }
+    if (has_auto_cross) {
+        cross = 0;
+    }
+    return is_row ? Size{main, cross} : Size{cross, main};
+}
@@ -7,29 +7,56 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
-#include <list>
 #include <memory>
 #include <sizepoint.h>
+#include <vector>
 
 struct Widget;
 
+// The data of the sub items read by the layout passes. Kept as arrays, so a pass over a large
+// form reads a few cache lines per item instead of following a pointer into every item.
+struct LayoutItemData {
+    // Changes every time the data is collected, layouts keeping measurements compare it
+    uint32_t generation = 0;
+    std::vector<Size> hints;
+    std::vector<double> weights;
+    std::vector<uint8_t> visible;
+};
+
 struct LayoutItem {
-    std::list<std::shared_ptr<LayoutItem>> sub_items;
+    std::vector<std::shared_ptr<LayoutItem>> sub_items;
     std::function<void(LayoutItem &, int)> on_item_added;
     LayoutParams padding = {};
     LayoutParams margin = {};
 
+    // The item containing this one, changes of the size hint are propagated to it
+    LayoutItem *parent_item = nullptr;
+
     double weight = 1;
 
     virtual auto relayout(Position position, const Size size) -> void = 0;
     virtual auto size_hint() const -> Size = 0;
     virtual auto ignore_layout() const -> bool { return false; }
 
-    auto remove_all() -> void;
+    // The size hint, computed once and cached. Items call `invalidate_size_hint()` when their
+    // content or visibility changes, which also marks all the items containing them for
+    // relayout. Assigning the members above after the first layout needs this as well, the
+    // setters below do it.
+    auto get_size_hint() const -> Size;
+    auto invalidate_size_hint() -> void;
+    auto set_padding(LayoutParams new_padding) -> void;
+    auto set_margin(LayoutParams new_margin) -> void;
+    auto set_weight(double new_weight) -> void;
+
+    // Layouts with per item parameters drop them as well
+    virtual auto remove_all() -> void;
 
     template <typename T> auto add(T layoutItem) -> T {
         sub_items.push_back(layoutItem);
+        layoutItem->parent_item = this;
+        invalidate_size_hint();
         if (on_item_added) {
             on_item_added(*this, sub_items.size() - 1);
         }
@@ -42,6 +69,24 @@ struct LayoutItem {
     }
 
     virtual ~LayoutItem() = default;
+
+  protected:
+    // Returns false if the item was already laid out at this rectangle, and nothing inside
+    // it changed since. Otherwise remembers the rectangle for the next time.
+    auto needs_relayout(Position position, Size size) -> bool;
+
+    // Collected from the sub items, and kept until one of them invalidates its size hint.
+    auto get_item_data() const -> const LayoutItemData &;
+
+    bool needs_layout = true;
+
+  private:
+    mutable Size cached_size_hint = {};
+    mutable bool has_size_hint = false;
+    mutable LayoutItemData item_data;
+    mutable bool has_item_data = false;
+    Position laid_out_position = {};
+    Size laid_out_size = {};
 };
 
 struct HorizontalSpacer : LayoutItem {
@@ -63,3 +108,111 @@ struct VerticalLayout : LayoutItem {
     virtual auto relayout(Position position, const Size size) -> void override;
     virtual auto size_hint() const -> Size override;
 };
+
+// Items are placed in cells, row by row in the order they are added, or at an explicit cell
+// with `add_at()`. A column is as wide as the widest size hint in it, columns whose items have
+// no width hint share the remaining width. Rows work the same way. Padding is the spacing
+// between cells.
+struct GridLayout : LayoutItem {
+    struct Cell {
+        int row = -1;
+        int column = -1;
+        int row_span = 1;
+        int column_span = 1;
+    };
+
+    explicit GridLayout(int columns = 2) : columns(columns) {}
+
+    // Changing the column count lays out the grid again
+    auto get_columns() const -> int { return columns; }
+    auto set_columns(int new_columns) -> void;
+
+    template <typename T>
+    auto add_at(T item, int row, int column, int row_span = 1, int column_span = 1) -> T {
+        add(item);
+        cells.resize(sub_items.size());
+        cells.back() = {row, column, row_span, column_span};
+        return item;
+    }
+
+    virtual auto relayout(Position position, const Size size) -> void override;
+    virtual auto size_hint() const -> Size override;
+    virtual auto remove_all() -> void override;
+
+  private:
+    // Computed from the item data, and kept while it is valid
+    struct Measure {
+        uint32_t generation = 0;
+        std::vector<Cell> cells;
+        std::vector<int> widths;
+        std::vector<int> heights;
+    };
+    auto measure() const -> const Measure &;
+
+    int columns = 2;
+    std::vector<Cell> cells;
+    mutable Measure measured;
+    mutable bool is_measured = false;
+};
+
+enum class FlexDirection { Row, Column };
+enum class FlexJustify { Start, Center, End, SpaceBetween };
+enum class FlexAlign { Start, Center, End, Stretch };
+
+// Per item parameters of a flex layout. Sizes of 0 mean no limit.
+struct FlexItem {
+    double grow = 0;
+    double shrink = 1;
+    Size min = {};
+    Size max = {};
+};
+
+// Items are placed along the main axis starting from their size hint, then grow into free
+// space or shrink when there is not enough of it. With `wrap` items which do not fit move to
+// a new line. Items added with `add()` get the default parameters.
+struct FlexLayout : LayoutItem {
+    explicit FlexLayout(FlexDirection direction = FlexDirection::Row) : direction(direction) {}
+
+    // Changing any of these lays out the items again
+    auto get_direction() const -> FlexDirection { return direction; }
+    auto get_justify() const -> FlexJustify { return justify; }
+    auto get_align() const -> FlexAlign { return align; }
+    auto get_wrap() const -> bool { return wrap; }
+    auto set_direction(FlexDirection new_direction) -> void;
+    auto set_justify(FlexJustify new_justify) -> void;
+    auto set_align(FlexAlign new_align) -> void;
+    auto set_wrap(bool new_wrap) -> void;
+
+    template <typename T> auto add_flex(T item, FlexItem params) -> T {
+        add(item);
+        item_params.resize(sub_items.size());
+        item_params.back() = params;
+        return item;
+    }
+
+    virtual auto relayout(Position position, const Size size) -> void override;
+    virtual auto size_hint() const -> Size override;
+    virtual auto remove_all() -> void override;
+
+  private:
+    auto get_params(size_t index) const -> FlexItem {
+        return index < item_params.size() ? item_params[index] : FlexItem{};
+    }
+
+    // Item sizes along the main and cross axis, clamped to their limits. Computed from the
+    // item data, and kept while it is valid.
+    struct Measure {
+        uint32_t generation = 0;
+        std::vector<int> basis;
+        std::vector<int> cross;
+    };
+    auto measure() const -> const Measure &;
+
+    FlexDirection direction = FlexDirection::Row;
+    FlexJustify justify = FlexJustify::Start;
+    FlexAlign align = FlexAlign::Stretch;
+    bool wrap = false;
+    std::vector<FlexItem> item_params;
+    mutable Measure measured;
+    mutable bool is_measured = false;
+};
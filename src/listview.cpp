@@ -9,16 +9,50 @@
 #include "scrollbar.h"
 #include "theme.h"
 
-auto ListItemAdapter::get_widget(size_t /*position*/, std::shared_ptr<Theme> theme) -> PWidget {
-    auto font_size =
-        theme->font->text_size("X") + theme->get_padding(PaddingStyle::Label).get_vertical();
-    auto position = Position{0, 0};
-    auto size = font_size;
-    auto p = std::make_shared<ListItemWidget>(position, size, "");
-    p->can_focus = true;
-    p->draw_background = false;
-    p->theme = theme;
-    return p;
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+auto ItemAdapter::rows_inserted(size_t first, size_t count) -> void {
+    for (auto observer : observers) {
+        observer->on_rows_inserted(first, count);
+    }
+}
+
+auto ItemAdapter::rows_removed(size_t first, size_t count) -> void {
+    for (auto observer : observers) {
+        observer->on_rows_removed(first, count);
+    }
+}
+
+auto ItemAdapter::rows_changed(size_t first, size_t count) -> void {
+    for (auto observer : observers) {
+        observer->on_rows_changed(first, count);
+    }
+}
+
+auto ItemAdapter::reset() -> void {
+    for (auto observer : observers) {
+        observer->on_reset();
+    }
+}
+
+auto ItemAdapter::add_observer(ItemAdapterObserver *observer) -> void {
+    if (std::find(observers.begin(), observers.end(), observer) == observers.end()) {
+        observers.push_back(observer);
+    }
+}
+
+auto ItemAdapter::remove_observer(ItemAdapterObserver *observer) -> void {
+    observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+}
+
+auto ListItemAdapter::get_widget(size_t /*position*/, Theme &theme) -> PWidget {
+    return ListItemWidget::create(theme);
+}
+
+auto ListItemAdapter::get_item_height(size_t /*position*/, Theme &theme) -> int {
+    return ListItemWidget::get_height(theme);
 }
 
 auto ListItemAdapter::set_content(PWidget widget, size_t position, ItemStatus status) -> void {
@@ -33,7 +67,16 @@ ListView::ListView(Position position, Size size) : Widget(position, size, 0) {
     position.x = size.width - 24;
     position.y = 0;
     this->scrollbar = add_new<ScrollBar>(position, size.height, false);
-    this->scrollbar->did_change = [this](auto *, int) { this->invalidate(); };
+    this->scrollbar->did_change = [this](auto *, int value) {
+        if (value != to_scrollbar(scroll_offset)) {
+            is_scrolling = false;
+            scroll_offset = from_scrollbar(value);
+        }
+        this->invalidate();
+    };
+
+    selection.select_only(0, 1);
+    selection.add_observer(this);
 
     // We will complete redraw the background, the theme should only draw the frame
     // and sub children.
@@ -42,53 +85,32 @@ ListView::ListView(Position position, Size size) : Widget(position, size, 0) {
     this->frame = {FrameStyles::Reversed, FrameSize::SingleFrame};
 }
 
+ListView::~ListView() {
+    if (auto observed = observed_adapter.lock()) {
+        observed->remove_observer(this);
+    }
+}
+
 auto ListView::draw() -> void {
     auto t = get_theme();
-    t->draw_listview_background(content, has_focus, true);
-    if (reserved_widgets.empty()) {
-        did_adapter_update();
+    get_item_height();
+    if (needs_scroll_range) {
+        update_scroll_range();
+    }
+    if (is_scrolling) {
+        animate_scroll();
     }
 
-    auto first_widget = adapter->get_widget(0, t);
-    auto item_height = (first_widget->content.size.height);
-    auto widget_count = this->content.size.height / item_height + 1;
-    auto first_item = scrollbar->value / item_height;
-    auto offset = -(scrollbar->value % item_height);
-
-    for (auto i = 0; i < widget_count; i++) {
-        auto p = Position{0, offset};
-        auto size = Size{this->content.size.width - this->scrollbar->content.size.width,
-                         first_widget->content.size.height};
-        auto status = ItemStatus{false, false};
-        auto w = reserved_widgets[i];
-        if (!w) {
-            continue;
-        }
+    t->draw_listview_background(content, has_focus, true);
+    t->draw_listview_background(content, has_focus, false);
+    update_rows(*t);
+    content.blit({0, 0}, viewport, {0, 0}, {viewport.size.width, rows_bottom});
 
-        if (first_item >= adapter->get_count()) {
-            w->hide();
-            continue;
-        }
-        status.is_active = this->current_item == first_item;
-        w->position = p;
-        if (size.height < 0) {
-            size.height = 0;
-        }
-        if (size.width < 0) {
-            size.width = 0;
-        }
-        w->content.resize(size);
-        adapter->set_content(w, first_item, status);
-        if (!w->is_visible()) {
-            w->show();
-        } else {
-            w->invalidate();
-        }
-        offset += item_height;
-        first_item++;
+    // Rows are already in the viewport, only the scroll bar is composed as a child
+    if (scrollbar->is_visible()) {
+        scrollbar->draw_if_needed();
+        content.draw(scrollbar->position, scrollbar->content);
     }
-    get_theme()->draw_listview_background(content, has_focus, false);
-    Widget::draw();
 
     auto frame_proxy = this->frame;
     if (can_focus && t->modify_frame_on_hover()) {
@@ -108,7 +130,195 @@ auto ListView::draw() -> void {
     }
 }
 
+auto ListView::update_rows(Theme &theme) -> void {
+    auto width = std::max(this->content.size.width - this->scrollbar->content.size.width, 0);
+    auto height = std::max(this->content.size.height, 0);
+    if (viewport.size.width != width || viewport.size.height != height) {
+        viewport.resize(width, height);
+        needs_full_redraw = true;
+    }
+
+    // Rows of different heights are measured when shown, offsets below them move. The
+    // pixels on screen are not where the offsets say anymore, so everything is drawn.
+    auto item_count = adapter->get_count();
+    if (!adapter->has_uniform_height()) {
+        auto item = row_heights.row_at(scroll_offset);
+        auto offset = row_heights.offset_of(item) - scroll_offset;
+        while (offset < height && item < item_count) {
+            auto measured_height = adapter->get_item_height(item, theme);
+            if (measured_height != row_heights.get_height(item)) {
+                row_heights.set_height(item, measured_height);
+                needs_full_redraw = true;
+                needs_scroll_range = true;
+            }
+            offset += measured_height;
+            item++;
+        }
+        if (needs_scroll_range) {
+            update_scroll_range();
+        }
+    }
+
+    // Pixels still valid are moved, and only the strip scrolled into view is drawn
+    auto exposed_top = 0;
+    auto exposed_bottom = height;
+    auto delta = scroll_offset - viewport_offset;
+    if (!needs_full_redraw) {
+        if (delta >= height || -delta >= height) {
+            needs_full_redraw = true;
+        } else if (delta > 0) {
+            viewport.scroll_vertically(static_cast<int>(delta));
+            exposed_top = height - static_cast<int>(delta);
+        } else if (delta < 0) {
+            viewport.scroll_vertically(static_cast<int>(delta));
+            exposed_bottom = static_cast<int>(-delta);
+        } else {
+            exposed_bottom = 0;
+        }
+    }
+    viewport_offset = scroll_offset;
+
+    auto first = row_heights.row_at(scroll_offset);
+    auto last = first;
+    auto last_offset = row_heights.offset_of(first) - scroll_offset;
+    while (last_offset < height && last < item_count) {
+        last_offset += row_heights.get_height(last);
+        last++;
+    }
+    recycle_rows(first, last);
+
+    auto kept = rows.begin();
+    auto offset = static_cast<int>(row_heights.offset_of(first) - scroll_offset);
+    for (auto item = first; item < last; item++) {
+        auto row_height = row_heights.get_height(item);
+        if (row_height <= 0) {
+            continue;
+        }
+
+        auto row = Row{};
+        auto is_new = true;
+        if (kept != rows.end() && kept->item == item) {
+            row = std::move(*kept);
+            kept++;
+            is_new = false;
+        } else {
+            row.view_type = adapter->get_view_type(item);
+            row.widget = obtain_row(item, row.view_type);
+            row.item = item;
+        }
+
+        auto status = ItemStatus{false, false};
+        status.is_active = this->current_item == static_cast<int>(item);
+        status.is_selected = selection.is_selected(item);
+        auto &w = row.widget;
+        auto is_exposed = offset < exposed_bottom && offset + row_height > exposed_top;
+        auto is_changed = item >= dirty_first && item < dirty_last;
+        auto is_dirty =
+            is_new || needs_full_redraw || is_exposed || is_changed || status != row.status;
+        w->position = Position{0, offset};
+        if (!w->is_visible()) {
+            w->show();
+        }
+        if (is_dirty) {
+            row.status = status;
+            w->content.resize(width, row_height);
+            adapter->set_content(w, item, status);
+        } else if (needs_row_content) {
+            adapter->set_content(w, item, status);
+        }
+
+        // Rows may also be invalidated by themselves, when hovered
+        if (w->draw_if_needed(is_dirty)) {
+            viewport.draw(w->position, w->content);
+        }
+        next_rows.push_back(std::move(row));
+        offset += row_height;
+    }
+    rows.swap(next_rows);
+    next_rows.clear();
+    rows_bottom = std::clamp(offset, 0, height);
+    needs_full_redraw = false;
+    needs_row_content = false;
+    dirty_first = 0;
+    dirty_last = 0;
+
+    // Rows not needed for this frame
+    for (auto &[view_type, pool] : recycled_rows) {
+        for (auto &w : pool) {
+            if (w->is_visible()) {
+                w->hide();
+            }
+        }
+    }
+    if (is_scrolling) {
+        request_scroll_frame();
+    }
+}
+
+auto ListView::scroll_by(int64_t delta) -> void {
+    auto from = is_scrolling ? scroll_target : scroll_offset;
+    auto target = std::clamp(from + delta, int64_t(0), max_scroll_offset);
+    if (!window || !window->platform) {
+        // Nobody would draw the next frames
+        set_scroll_offset(target);
+        return;
+    }
+    scroll_target = target;
+    if (scroll_target == scroll_offset) {
+        return;
+    }
+    if (!is_scrolling) {
+        last_scroll_frame = std::chrono::steady_clock::now();
+        is_scrolling = true;
+    }
+    invalidate();
+}
+
+auto ListView::animate_scroll() -> void {
+    // Each frame covers part of the remaining distance, depending on the time since the
+    // previous frame. Late frames move further, so the speed does not depend on the frame rate.
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration<double, std::milli>(now - last_scroll_frame).count();
+    last_scroll_frame = now;
+
+    auto remaining = scroll_target - scroll_offset;
+    auto step = static_cast<int64_t>(remaining * (1.0 - std::exp(-elapsed / scroll_time_constant)));
+    if (step == 0) {
+        step = remaining > 0 ? 1 : -1;
+    }
+    if (std::abs(remaining) <= 1) {
+        step = remaining;
+    }
+    scroll_offset = std::clamp(scroll_offset + step, int64_t(0), max_scroll_offset);
+    scrollbar->set_value(to_scrollbar(scroll_offset));
+    if (scroll_offset == scroll_target || step == 0) {
+        is_scrolling = false;
+    }
+}
+
+auto ListView::request_scroll_frame() -> void {
+    if (!window || !window->platform) {
+        is_scrolling = false;
+        return;
+    }
+
+    // Posted from the UI thread, so it runs after this frame was painted
+    window->platform->post([weak = weak_from_this()]() {
+        if (auto self = weak.lock()) {
+            self->invalidate();
+        }
+    });
+}
+
 EventPropagation ListView::on_mouse_click(const EventMouse &event) {
+    if (event.button == mouse_wheel_up || event.button == mouse_wheel_down) {
+        if (event.pressed) {
+            auto delta = int64_t(get_item_height()) * wheel_rows;
+            scroll_by(event.button == mouse_wheel_up ? -delta : delta);
+        }
+        return EventPropagation::handled;
+    }
+
     if (!event.pressed) {
         return Widget::on_mouse(event);
     }
@@ -118,13 +328,16 @@ EventPropagation ListView::on_mouse_click(const EventMouse &event) {
         return p;
     }
 
-    auto first_widget = adapter->get_widget(0, get_theme());
-    auto item_height = (first_widget->content.size.height);
-    auto first_item = scrollbar->value / item_height;
-    auto offset = -(scrollbar->value % item_height);
-
-    auto clicked_item_offset = (event.y - offset) / item_height;
-    this->current_item = clicked_item_offset + first_item;
+    if (adapter->get_count() == 0) {
+        return EventPropagation::handled;
+    }
+    get_item_height();
+    this->current_item = static_cast<int>(row_heights.row_at(scroll_offset + event.y));
+    update_selection(event.is_shift_pressed(), event.is_control_pressed());
+    if (selection_mode == SelectionMode::Multiple && event.is_control_pressed() &&
+        !event.is_shift_pressed()) {
+        selection.toggle(current_item);
+    }
     invalidate();
     if (this->on_item_selected) {
         this->on_item_selected(*this, current_item, SelectionReason::Mouse);
@@ -132,24 +345,26 @@ EventPropagation ListView::on_mouse_click(const EventMouse &event) {
     return EventPropagation::handled;
 }
 
-auto static ensure_item_in_viewport(ListView &l, std::shared_ptr<Theme> theme) {
-    auto first_widget = l.adapter->get_widget(0, theme);
-    auto item_height = (first_widget->content.size.height);
-    auto widget_count = l.content.size.height / item_height;
-    auto first_visible_item = l.scrollbar->value / item_height;
-
-    if (l.current_item >= first_visible_item &&
-        l.current_item < first_visible_item + widget_count) {
-        return;
+auto ListView::ensure_item_visible(size_t item) -> void {
+    get_item_height();
+    auto top = row_heights.offset_of(item);
+    auto bottom = top + row_heights.get_height(item);
+    if (top < scroll_offset) {
+        set_scroll_offset(top);
+    } else if (bottom > scroll_offset + content.size.height) {
+        set_scroll_offset(bottom - content.size.height);
     }
+}
 
-    if (l.current_item < first_visible_item) {
-        l.scrollbar->set_value(item_height * l.current_item);
+auto ListView::set_scroll_offset(int64_t offset) -> void {
+    is_scrolling = false;
+    offset = std::clamp(offset, int64_t(0), max_scroll_offset);
+    if (offset == scroll_offset) {
         return;
     }
-
-    auto lll = (l.current_item - widget_count + 1);
-    l.scrollbar->set_value(item_height * lll);
+    scroll_offset = offset;
+    scrollbar->set_value(to_scrollbar(offset));
+    invalidate();
 }
 
 auto ListView::on_keyboard(const EventKeyboard &event) -> EventPropagation {
@@ -178,24 +393,41 @@ auto ListView::on_keyboard(const EventKeyboard &event) -> EventPropagation {
         break;
     case KeyCodes::PageDown:
         result = EventPropagation::handled;
-        this->current_item += adapter->get_count() / 5;
-        if (this->current_item >= adapter->get_count()) {
-            this->current_item = adapter->get_count() - 1;
-        }
+        this->current_item = static_cast<int>(
+            row_heights.row_at(row_heights.offset_of(current_item) + content.size.height));
         break;
     case KeyCodes::PageUp:
         result = EventPropagation::handled;
-        this->current_item -= adapter->get_count() / 5;
-        if (this->current_item < 0) {
-            this->current_item = 0;
-        }
+        this->current_item = static_cast<int>(
+            row_heights.row_at(row_heights.offset_of(current_item) - content.size.height));
         break;
     default:
+        if (!event.is_control_pressed() && !event.is_mod_pressed() && !event.text.empty()) {
+            auto get_text = [this](size_t row) { return adapter->get_text(row); };
+            auto row = type_ahead.on_key(event.text, adapter->get_count(), get_text, current_item);
+            if (row >= 0) {
+                result = EventPropagation::handled;
+                this->current_item = row;
+                break;
+            }
+        }
+        if (selection_mode == SelectionMode::Multiple) {
+            auto is_a_pressed = event.key == (KeyCodes)'A' || event.key == (KeyCodes)'a';
+            if (is_a_pressed && event.is_control_pressed()) {
+                result = EventPropagation::handled;
+                selection.select_all(adapter->get_count());
+            } else if (event.key == KeyCodes::Space && adapter->get_count() != 0) {
+                result = EventPropagation::handled;
+                selection.toggle(current_item);
+                selection_anchor = current_item;
+            }
+        }
         break;
     }
 
     if (old_item != this->current_item) {
-        ensure_item_in_viewport(*this, get_theme());
+        update_selection(event.is_shift_pressed(), event.is_control_pressed());
+        ensure_item_visible(current_item);
         invalidate();
         if (this->on_item_selected) {
             this->on_item_selected(*this, current_item, SelectionReason::KeyboardMove);
@@ -212,43 +444,308 @@ auto ListView::on_resize() -> void {
     auto default_buttons_size = this->scrollbar->get_padding().get_horizontal();
     auto p = Position{content.size.width - default_buttons_size, 0};
 
-    for (auto &w : reserved_widgets) {
-        w->hide();
-    }
-    this->reserved_widgets.clear();
+    // The rows are resized on the next draw, only the scroll range depends on the height
+    needs_scroll_range = true;
+    needs_full_redraw = true;
     this->scrollbar->position = p;
     this->scrollbar->content.resize(default_buttons_size, content.size.height);
     this->scrollbar->on_resize();
 }
 
+auto ListView::on_theme_changed() -> void {
+    // Item heights depend on the font, they are measured again on the next draw
+    measured_theme = nullptr;
+    needs_full_redraw = true;
+}
+
 auto ListView::did_adapter_update() -> void {
-    reserved_widgets.clear();
-    auto t = get_theme();
-    auto first_widget = adapter->get_widget(0, t);
-    auto item_height = first_widget->content.size.height;
-    auto widget_count = (this->content.size.height - 2) / item_height + 1;
+    measured_adapter = nullptr;
+    type_ahead.invalidate();
+    needs_full_redraw = true;
+    update_scroll_range();
+    auto item_count = static_cast<int>(adapter->get_count());
+    current_item = std::clamp(current_item, 0, std::max(item_count - 1, 0));
+    selection_anchor = current_item;
+    if (selection_mode == SelectionMode::Single) {
+        selection.select_only(current_item, current_item + 1);
+    } else {
+        selection.clear();
+    }
+    this->invalidate();
+}
+
+auto ListView::on_rows_inserted(size_t first, size_t count) -> void {
+    type_ahead.invalidate();
+    auto old_count = row_heights.size();
+    if (count == 0) {
+        return;
+    }
+    if (measured_adapter != adapter.get() || old_count + count != adapter->get_count()) {
+        on_reset();
+        return;
+    }
+
+    first = std::min(first, old_count);
+    auto top = row_heights.row_at(scroll_offset);
+    keep_at_end = keep_at_end || (first == old_count && scroll_offset >= max_scroll_offset);
+    row_heights.insert(first, count, item_height);
+
+    // Rows inserted above the view push its content down, the view moves along
+    if (first <= top && scroll_offset > 0) {
+        auto height = row_heights.offset_of(first + count) - row_heights.offset_of(first);
+        scroll_offset += height;
+        viewport_offset += height;
+    } else {
+        mark_dirty(first, std::numeric_limits<size_t>::max());
+    }
+    for (auto &row : rows) {
+        if (row.item >= first) {
+            row.item += count;
+        }
+    }
+    if (old_count != 0 && static_cast<size_t>(current_item) >= first) {
+        current_item += static_cast<int>(count);
+    }
+    selection.insert_rows(first, count);
+    if (selection_mode == SelectionMode::Single) {
+        selection.select_only(current_item, current_item + 1);
+    }
+    needs_row_content = true;
+    needs_scroll_range = true;
+    invalidate();
+}
+
+auto ListView::on_rows_removed(size_t first, size_t count) -> void {
+    type_ahead.invalidate();
+    auto old_count = row_heights.size();
+    if (count == 0 || first >= old_count) {
+        return;
+    }
+    count = std::min(count, old_count - first);
+    if (measured_adapter != adapter.get() || old_count - count != adapter->get_count()) {
+        on_reset();
+        return;
+    }
+
+    auto top = row_heights.row_at(scroll_offset);
+    if (first + count <= top && scroll_offset > 0) {
+        auto height = row_heights.offset_of(first + count) - row_heights.offset_of(first);
+        scroll_offset -= height;
+        viewport_offset -= height;
+    } else {
+        mark_dirty(first, std::numeric_limits<size_t>::max());
+    }
+    row_heights.remove(first, count);
+
+    // Widgets of removed rows go back to the pool, rows below move up
+    for (auto &row : rows) {
+        if (row.item >= first + count) {
+            row.item -= count;
+        } else if (row.item >= first) {
+            recycled_rows[row.view_type].push_back(std::move(row.widget));
+        }
+    }
+    rows.erase(std::remove_if(rows.begin(), rows.end(), [](const Row &row) { return !row.widget; }),
+               rows.end());
+
+    auto item = static_cast<size_t>(current_item);
+    if (item >= first + count) {
+        current_item -= static_cast<int>(count);
+    } else if (item >= first) {
+        auto item_count = row_heights.size();
+        current_item = static_cast<int>(item_count == 0 ? 0 : std::min(first, item_count - 1));
+    }
+    selection.remove_rows(first, count);
+    if (selection_mode == SelectionMode::Single) {
+        selection.select_only(current_item, current_item + 1);
+    }
+    needs_row_content = true;
+    needs_scroll_range = true;
+    invalidate();
+}
+
+auto ListView::on_rows_changed(size_t first, size_t count) -> void {
+    type_ahead.invalidate();
+    // Heights of variable rows are measured again when shown
+    auto item_count = row_heights.size();
+    if (first >= item_count) {
+        return;
+    }
+    mark_dirty(first, first + std::min(count, item_count - first));
+    invalidate();
+}
+
+auto ListView::on_reset() -> void { did_adapter_update(); }
+
+auto ListView::on_selection_changed(const std::vector<RowRange> &changed) -> void {
+    // Rows compare their status on every frame, those which changed are drawn again
+    invalidate();
+    if (did_change_selection) {
+        did_change_selection(*this, changed);
+    }
+}
+
+auto ListView::update_selection(bool is_extending, bool is_toggling) -> void {
+    auto current = static_cast<size_t>(current_item);
+    if (selection_mode == SelectionMode::Single) {
+        selection.select_only(current, current + 1);
+        return;
+    }
+    if (is_extending) {
+        auto first = std::min(selection_anchor, current);
+        auto last = std::max(selection_anchor, current) + 1;
+        if (is_toggling) {
+            selection.select(first, last);
+        } else {
+            selection.select_only(first, last);
+        }
+        return;
+    }
+    selection_anchor = current;
+    if (!is_toggling) {
+        selection.select_only(current, current + 1);
+    }
+}
+
+auto ListView::observe_adapter() -> void {
+    auto previous = observed_adapter.lock();
+    if (previous == adapter) {
+        return;
+    }
+    if (previous) {
+        previous->remove_observer(this);
+    }
+    if (adapter) {
+        adapter->add_observer(this);
+    }
+    observed_adapter = adapter;
+    type_ahead.invalidate();
+}
 
-    auto k = adapter->get_count() - widget_count;
-    if (adapter->get_count() < widget_count) {
-        k = 0;
+auto ListView::mark_dirty(size_t first, size_t last) -> void {
+    if (first >= last) {
+        return;
+    }
+    if (dirty_first >= dirty_last) {
+        dirty_first = first;
+        dirty_last = last;
+        return;
+    }
+    dirty_first = std::min(dirty_first, first);
+    dirty_last = std::max(dirty_last, last);
+}
+
+auto ListView::update_scroll_range() -> void {
+    auto item_height = get_item_height();
+    if (row_heights.size() != adapter->get_count()) {
+        row_heights.reset(adapter->get_count(), item_height);
+    }
+    needs_scroll_range = false;
+
+    auto visible_height = std::max(this->content.size.height, 0);
+    max_scroll_offset = std::max(row_heights.total_height() - visible_height, int64_t(0));
+    if (keep_at_end) {
+        scroll_offset = max_scroll_offset;
+        keep_at_end = false;
     }
+    scroll_offset = std::min(scroll_offset, max_scroll_offset);
 
     // the speed is just to make weird funky updates
-    this->scrollbar->set_values(0, k * item_height, 0, (item_height * 3) / 11);
+    auto maximum = to_scrollbar(max_scroll_offset);
+    auto step = std::max(to_scrollbar((item_height * 3) / 11), 1);
+    auto page = std::max(to_scrollbar(visible_height), 1);
+    this->scrollbar->set_values(0, maximum, to_scrollbar(scroll_offset), step, page);
+}
 
-    widget_count++;
-    while (widget_count != 0) {
-        // while this would work, this is unacceptable code. It does 3
-        // different actions in a single line, and will become undebuggable
-        // reserved_widgets.push_back(add(adapter->get_widget(widget_count)));
+auto ListView::get_item_height() -> int {
+    auto t = get_theme();
+    if (item_height > 0 && measured_theme == t && measured_adapter == adapter.get()) {
+        return item_height;
+    }
+    observe_adapter();
+    item_height = std::max(adapter->get_item_height(0, *t), 1);
+    measured_theme = t;
+    measured_adapter = adapter.get();
+    row_heights.reset(adapter->get_count(), item_height);
+    needs_scroll_range = true;
+    return item_height;
+}
 
-        auto b = adapter->get_widget(widget_count, t);
-        b->hide();
-        this->add(b);
-        this->reserved_widgets.push_back(b);
-        widget_count--;
+auto ListView::to_scrollbar(int64_t offset) const -> int {
+    if (max_scroll_offset <= max_scrollbar_value) {
+        return static_cast<int>(offset);
     }
-    this->invalidate();
+    return static_cast<int>(static_cast<double>(offset) * max_scrollbar_value / max_scroll_offset);
+}
+
+auto ListView::from_scrollbar(int value) const -> int64_t {
+    if (max_scroll_offset <= max_scrollbar_value) {
+        return value;
+    }
+    if (value >= max_scrollbar_value) {
+        return max_scroll_offset;
+    }
+    return static_cast<int64_t>(static_cast<double>(value) * max_scroll_offset /
+                                max_scrollbar_value);
+}
+
+auto ListView::recycle_rows(size_t first, size_t last) -> void {
+    // Widgets made by another adapter cannot be reused
+    if (rows_adapter != adapter.get()) {
+        for (auto &row : rows) {
+            widgets.remove(row.widget);
+        }
+        rows.clear();
+        for (auto &[view_type, pool] : recycled_rows) {
+            for (auto &w : pool) {
+                widgets.remove(w);
+            }
+            pool.clear();
+        }
+        rows_adapter = adapter.get();
+        needs_full_redraw = true;
+        return;
+    }
+
+    // Rows still on screen keep their widget, and their pixels
+    auto is_kept = [first, last](const Row &row) { return row.item >= first && row.item < last; };
+    for (auto &row : rows) {
+        if (!is_kept(row)) {
+            recycled_rows[row.view_type].push_back(std::move(row.widget));
+        }
+    }
+    rows.erase(std::remove_if(rows.begin(), rows.end(),
+                              [&is_kept](const Row &row) { return !is_kept(row); }),
+               rows.end());
+}
+
+auto ListView::obtain_row(size_t position, int view_type) -> std::shared_ptr<Widget> {
+    auto &pool = recycled_rows[view_type];
+    if (!pool.empty()) {
+        auto w = std::move(pool.back());
+        pool.pop_back();
+        return w;
+    }
+    auto w = adapter->get_widget(position, *get_theme());
+    w->hide();
+    this->add(w);
+    return w;
+}
+
+auto ListItemWidget::create(Theme &theme) -> std::shared_ptr<ListItemWidget> {
+    auto font_size =
+        theme.font->text_size("X") + theme.get_padding(PaddingStyle::Label).get_vertical();
+    auto position = Position{0, 0};
+    auto size = font_size;
+    auto p = std::make_shared<ListItemWidget>(position, size, "");
+    p->can_focus = true;
+    p->draw_background = false;
+    return p;
+}
+
+auto ListItemWidget::get_height(Theme &theme) -> int {
+    return theme.font->text_size("X").height +
+           theme.get_padding(PaddingStyle::Label).get_vertical();
 }
 
 auto ListItemWidget::draw() -> void {
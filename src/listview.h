@@ -7,23 +7,72 @@
 
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include <checkboxshape.h>
+#include <rowheights.h>
+#include <selectionmodel.h>
+#include <typeahead.h>
 #include <widget.h>
 
 struct ScrollBar;
 
+// Views attached to an adapter are told which rows changed, instead of reloading everything
+struct ItemAdapterObserver {
+    virtual ~ItemAdapterObserver() = default;
+    virtual auto on_rows_inserted(size_t first, size_t count) -> void = 0;
+    virtual auto on_rows_removed(size_t first, size_t count) -> void = 0;
+    virtual auto on_rows_changed(size_t first, size_t count) -> void = 0;
+    virtual auto on_reset() -> void = 0;
+};
+
 struct ItemAdapter {
     // ALA TurboVision
     using PWidget = std::shared_ptr<Widget>;
     virtual ~ItemAdapter() = default;
 
     virtual auto get_count() const -> size_t = 0;
-    virtual auto get_widget(size_t position, std::shared_ptr<Theme> theme) -> PWidget = 0;
+    virtual auto get_widget(size_t position, Theme &theme) -> PWidget = 0;
     virtual auto set_content(PWidget widget, size_t position, ItemStatus status) -> void = 0;
+
+    // Views ask this once, and keep it until the theme or the adapter changes. The default
+    // creates a widget to measure it, adapters should compute it directly.
+    virtual auto get_item_height(size_t position, Theme &theme) -> int {
+        return get_widget(position, theme)->content.size.height;
+    }
+
+    // Views with uniform rows ask the height of the first item only. Otherwise every row is
+    // measured when it is shown, and the scroll range is adjusted as rows are discovered.
+    virtual auto has_uniform_height() const -> bool { return true; }
+
+    // Used by adapters which sort or filter other adapters. May be called from worker threads.
+    virtual auto get_text(size_t position) const -> std::string_view {
+        (void)(position);
+        return {};
+    }
+
+    // Widgets made by `get_widget()` for items of the same view type are reused for each other
+    virtual auto get_view_type(size_t position) const -> int {
+        (void)(position);
+        return 0;
+    }
+
+    // Call these after changing the data, `get_count()` must already return the new count.
+    // Views keep their scroll position and selection, and repaint only the affected rows.
+    auto rows_inserted(size_t first, size_t count) -> void;
+    auto rows_removed(size_t first, size_t count) -> void;
+    auto rows_changed(size_t first, size_t count) -> void;
+    auto reset() -> void;
+
+    auto add_observer(ItemAdapterObserver *observer) -> void;
+    auto remove_observer(ItemAdapterObserver *observer) -> void;
+
+  private:
+    std::vector<ItemAdapterObserver *> observers;
 };
 
 struct ListItemAdapter : ItemAdapter {
@@ -31,8 +80,12 @@ struct ListItemAdapter : ItemAdapter {
 
     explicit ListItemAdapter(const std::vector<std::string> &s) { this->strings = s; };
     virtual auto get_count() const -> size_t override { return strings.size(); }
-    virtual auto get_widget(size_t position, std::shared_ptr<Theme> theme) -> PWidget override;
+    virtual auto get_widget(size_t position, Theme &theme) -> PWidget override;
     virtual auto set_content(PWidget widget, size_t position, ItemStatus status) -> void override;
+    virtual auto get_item_height(size_t position, Theme &theme) -> int override;
+    virtual auto get_text(size_t position) const -> std::string_view override {
+        return strings[position];
+    }
 };
 
 struct ListItemWidget : public Widget {
@@ -43,10 +96,14 @@ struct ListItemWidget : public Widget {
         this->text = text;
     }
 
+    // Used by adapters which show a line of text per row
+    static auto create(Theme &theme) -> std::shared_ptr<ListItemWidget>;
+    static auto get_height(Theme &theme) -> int;
+
     virtual auto draw() -> void override;
 };
 
-struct ListView : public Widget {
+struct ListView : public Widget, private ItemAdapterObserver, private SelectionObserver {
     enum class SelectionReason {
         Mouse,
         Keyboard,
@@ -55,16 +112,124 @@ struct ListView : public Widget {
 
     std::shared_ptr<ScrollBar> scrollbar = {};
     std::shared_ptr<ItemAdapter> adapter = {};
-    std::vector<std::shared_ptr<Widget>> reserved_widgets = {};
+    enum class SelectionMode {
+        Single,
+        Multiple,
+    };
+
     std::function<void(ListView &, int, SelectionReason)> on_item_selected;
     int current_item = 0;
 
+    // In single mode the selection follows the current item. In multiple mode shift extends
+    // it from the last row clicked, and control toggles rows.
+    SelectionMode selection_mode = SelectionMode::Single;
+    SelectionModel selection;
+    std::function<void(ListView &, const std::vector<RowRange> &)> did_change_selection;
+
     ListView();
     ListView(Position position, Size size);
+    virtual ~ListView();
     virtual auto draw() -> void override;
     virtual auto on_mouse_click(const EventMouse &event) -> EventPropagation override;
     virtual auto on_keyboard(const EventKeyboard &) -> EventPropagation override;
     virtual auto on_resize() -> void override;
+    virtual auto on_theme_changed() -> void override;
 
+    // Same as `ItemAdapter::reset()`, for adapters which do not notify their changes
     auto did_adapter_update() -> void;
+
+    // Asked from the adapter once, and kept until the theme or the adapter changes. With
+    // variable row heights this is the estimate for rows not shown yet.
+    auto get_item_height() -> int;
+
+    // The content is scrolled in pixels, with 64 bit offsets. Long lists are mapped onto the
+    // scroll bar proportionally.
+    auto get_scroll_offset() const -> int64_t { return scroll_offset; }
+    auto set_scroll_offset(int64_t offset) -> void;
+    auto ensure_item_visible(size_t item) -> void;
+
+    // Scrolls smoothly over a few frames, used for the mouse wheel
+    auto scroll_by(int64_t delta) -> void;
+
+  private:
+    struct Row {
+        int view_type = 0;
+        std::shared_ptr<Widget> widget;
+        size_t item = 0;
+        ItemStatus status = {};
+    };
+
+    virtual auto on_rows_inserted(size_t first, size_t count) -> void override;
+    virtual auto on_rows_removed(size_t first, size_t count) -> void override;
+    virtual auto on_rows_changed(size_t first, size_t count) -> void override;
+    virtual auto on_reset() -> void override;
+    virtual auto on_selection_changed(const std::vector<RowRange> &changed) -> void override;
+    auto observe_adapter() -> void;
+
+    // Called after the current item moved
+    auto update_selection(bool is_extending, bool is_toggling) -> void;
+    auto mark_dirty(size_t first, size_t last) -> void;
+
+    // Rows are rendered into `viewport`. When scrolling, its pixels are moved and only rows
+    // which scroll into view, or whose status changed, are rendered again.
+    auto update_rows(Theme &theme) -> void;
+
+    // Rows no longer on screen go to the pool, and are taken back by view type. Widgets are
+    // created only when the pool has none left, so scrolling does not allocate.
+    auto recycle_rows(size_t first, size_t last) -> void;
+    auto obtain_row(size_t position, int view_type) -> std::shared_ptr<Widget>;
+
+    auto update_scroll_range() -> void;
+    auto to_scrollbar(int64_t offset) const -> int;
+    auto from_scrollbar(int value) const -> int64_t;
+    auto animate_scroll() -> void;
+
+    // Asks the UI thread for the next frame of the animation, after this one was painted
+    auto request_scroll_frame() -> void;
+
+    static constexpr int64_t max_scrollbar_value = 1 << 30;
+    static constexpr int wheel_rows = 3;
+    static constexpr double scroll_time_constant = 40.0;
+
+    std::vector<Row> rows;
+    std::vector<Row> next_rows;
+    std::unordered_map<int, std::vector<std::shared_ptr<Widget>>> recycled_rows;
+    const ItemAdapter *rows_adapter = nullptr;
+    std::weak_ptr<ItemAdapter> observed_adapter;
+
+    int item_height = 0;
+    const Theme *measured_theme = nullptr;
+    const ItemAdapter *measured_adapter = nullptr;
+    bool needs_scroll_range = true;
+
+    RowHeights row_heights;
+    int64_t scroll_offset = 0;
+    int64_t max_scroll_offset = 0;
+
+    Bitmap viewport;
+    int64_t viewport_offset = 0;
+    int rows_bottom = 0;
+    bool needs_full_redraw = true;
+
+    // Rows whose content changed, drawn again on the next frame
+    size_t dirty_first = 0;
+    size_t dirty_last = 0;
+
+    // Rows were inserted or removed, rows kept on screen get their content again, as their
+    // widgets may point into storage of the adapter which has moved
+    bool needs_row_content = false;
+
+    // Appending to a list scrolled to its end keeps it at the end, as a log tail
+    bool keep_at_end = false;
+
+    // Typing selects rows by the start of their text
+    TypeAhead type_ahead;
+
+    // Where shift selections start
+    size_t selection_anchor = 0;
+
+    // Animated scrolling moves towards the target on every frame, while it runs
+    bool is_scrolling = false;
+    int64_t scroll_target = 0;
+    std::chrono::steady_clock::time_point last_scroll_frame;
 };
@@ -43,7 +43,7 @@ struct DebugWidget : public Widget {
     Position pos = {0, 0};
     bool unclick_inside = false;
 
-    DebugWidget(uint32_t color) : Widget(color) { this->mouse_cursor = MouseCursor::Cross; }
+    DebugWidget(uint32_t color) : Widget(color) { set_cursor(MouseCursor::Cross); }
 
     auto on_hover(const EventMouse &event) -> void {
         pos.x = event.x;
@@ -90,10 +90,10 @@ struct DebugWidget : public Widget {
 
         if (mouse_over) {
             auto str = fmt::format("{} Position = {}x{} ", state_pressed ? "*" : " ", pos.x, pos.y);
-            theme->font->write(content, {4, 4}, str, MakeColor(0xf, 0xf, 0));
+            get_theme()->font->write(content, {4, 4}, str, MakeColor(0xf, 0xf, 0));
         } else {
             if (state_pressed) {
-                theme->font->write(content, {4, 4}, "*", MakeColor(0xf, 0xf, 0));
+                get_theme()->font->write(content, {4, 4}, "*", MakeColor(0xf, 0xf, 0));
             }
         }
 
@@ -225,17 +225,36 @@ int main() {
                                                  "Autumn/Fall",
                                                  "Winter",
                                              });
+    w1->add_new_to_layout<Combobox>(l_right, std::vector<std::string>{
+                                                 "Plasma",
+                                                 "Redmond",
+                                                 "Fluent",
+                                             })
+        ->on_item_selected = [&platform](auto &, auto index) {
+        auto font = platform.default_font;
+        switch (index) {
+        case 0:
+            platform.set_theme(std::make_shared<ThemePlasma>(font));
+            break;
+        case 1:
+            platform.set_theme(std::make_shared<ThemeRedmond>(font));
+            break;
+        case 2:
+            platform.set_theme(std::make_shared<ThemeFluent>(font));
+            break;
+        }
+    };
 
     auto debug_widget = w1->add_new_to_layout<DebugWidget>(l_right, 0x22dd37);
     auto cb = w1->add_new_to_layout<Checkbox>(l_right, "Show/hide debug widget");
     cb->on_checkbox_change = [debug_widget](const Checkbox &cb) {
+        // the window is laid out again when the update ends
+        auto update = UpdateScope(*debug_widget->window);
         if (cb.is_checked) {
             debug_widget->show();
         } else {
             debug_widget->hide();
         }
-        // this is to trigger re-layout
-        debug_widget->window->relayout();
     };
     cb->set_checked(EventPropagation::handled);
     debug_widget->weight = 0.5;
@@ -278,8 +297,10 @@ int main() {
             clicked_count++;
             text = fmt::format("Cancel ({})", clicked_count);
             spdlog::info("Cancel Clicked! count = {}", clicked_count);
-            cancel_button->text = text;
-            cancel_button->invalidate();
+
+            // Laid out again when the scope ends, the new text may need more room
+            auto update = UpdateScope(*cancel_button);
+            cancel_button->set_text(text);
         });
     cancel_button->set_auto_repeat(300, 700);
     platform.show_window(w1);
@@ -0,0 +1,116 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "mappedfile.h"
+
+#include <spdlog/spdlog.h>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+auto MappedFile::open(const std::string_view file_name) -> bool {
+    close();
+    auto name = std::string(file_name);
+    file = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        spdlog::error("Cannot open {}", file_name);
+        return false;
+    }
+
+    auto file_size = LARGE_INTEGER{};
+    GetFileSizeEx(file, &file_size);
+    size = static_cast<size_t>(file_size.QuadPart);
+    is_mapped = true;
+    if (size == 0) {
+        return true;
+    }
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr) {
+        data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (data == nullptr) {
+        spdlog::error("Cannot map {}", file_name);
+        close();
+        return false;
+    }
+    return true;
+}
+
+auto MappedFile::close() -> void {
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+    if (file != nullptr) {
+        CloseHandle(file);
+    }
+    data = nullptr;
+    mapping = nullptr;
+    file = nullptr;
+    size = 0;
+    is_mapped = false;
+}
+
+#else
+
+auto MappedFile::open(const std::string_view file_name) -> bool {
+    close();
+    auto name = std::string(file_name);
+    auto fd = ::open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        spdlog::error("Cannot open {}", file_name);
+        return false;
+    }
+
+    struct stat info = {};
+    if (fstat(fd, &info) != 0) {
+        spdlog::error("Cannot read the size of {}", file_name);
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping keeps the file alive, the descriptor is not needed after this
+    size = static_cast<size_t>(info.st_size);
+    if (size != 0) {
+        auto address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            spdlog::error("Cannot map {}", file_name);
+            ::close(fd);
+            size = 0;
+            return false;
+        }
+        data = static_cast<const char *>(address);
+    }
+    ::close(fd);
+    is_mapped = true;
+    return true;
+}
+
+auto MappedFile::close() -> void {
+    if (data != nullptr) {
+        munmap(const_cast<char *>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+    is_mapped = false;
+}
+
+#endif
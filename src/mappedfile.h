@@ -0,0 +1,34 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// A whole file mapped read only into memory. Pages are read by the OS when first touched, and
+// can be dropped again under memory pressure, so huge files do not count as private memory.
+struct MappedFile {
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    auto operator=(const MappedFile &) -> MappedFile & = delete;
+    ~MappedFile() { close(); }
+
+    auto open(const std::string_view file_name) -> bool;
+    auto close() -> void;
+    auto is_open() const -> bool { return is_mapped; }
+    auto get_data() const -> std::string_view { return {data, size}; }
+
+  private:
+    const char *data = nullptr;
+    size_t size = 0;
+    bool is_mapped = false;
+#if defined(_WIN32)
+    void *file = nullptr;
+    void *mapping = nullptr;
+#endif
+};
@@ -10,6 +10,10 @@
 #include "image/loaders.hpp"
 #include "platform.h"
 #include "theme.h"
+#include "threadpool.h"
+
+#include <chrono>
+#include <filesystem>
 
 #if defined(SVISION_USE_FREETYPE)
 #include "fontproviderfreetype.h"
@@ -17,6 +21,12 @@
 #include "fontproviders/fontproviderstb.hpp"
 #endif
 
+Platform::~Platform() {
+    if (default_font) {
+        default_font->wait_for_prewarm();
+    }
+}
+
 void Platform::init() {
     platform_init();
 
@@ -28,6 +38,27 @@ void Platform::init() {
 #endif
     }
 
+    for (auto &font_file : fallback_font_files) {
+        // The list names fonts which may be installed, a missing one is not an error
+        auto error = std::error_code();
+        if (!std::filesystem::exists(font_file, error)) {
+            spdlog::debug("Fallback font {} is not installed, skipping", font_file);
+            continue;
+        }
+        if (default_font && !default_font->add_fallback(font_file)) {
+            spdlog::warn("Could not use fallback font {}", font_file);
+        }
+    }
+
+    if (prewarm_fonts && default_font) {
+        auto on_prewarm_done = [this](int glyphs, std::chrono::microseconds time) {
+            statistics.prewarm_glyphs = glyphs;
+            statistics.prewarm_micro_seconds = time.count();
+            spdlog::info("Font prewarm: {} glyphs in {}usec", glyphs, time.count());
+        };
+        default_font->prewarm(prewarm_code_points, on_prewarm_done);
+    }
+
     // TODO - detect GTK and use a GTK theme
     if (!this->default_theme) {
         default_theme = std::make_shared<ThemePlasma>(this->default_font);
@@ -39,3 +70,49 @@ void Platform::init() {
         image_loader = std::make_shared<ImageLoader>();
     }
 }
+
+void Platform::set_theme(std::shared_ptr<Theme> theme) {
+    if (theme && !theme->font) {
+        theme->font = default_font;
+    }
+    default_theme = theme;
+}
+
+auto Platform::post(std::function<void()> task) -> void {
+    {
+        auto guard = std::lock_guard(posted_lock);
+        posted_tasks.push_back(std::move(task));
+    }
+    wake_up();
+}
+
+auto Platform::run_posted() -> void {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(8);
+    while (true) {
+        auto task = std::function<void()>();
+        {
+            auto guard = std::lock_guard(posted_lock);
+            if (posted_tasks.empty()) {
+                return;
+            }
+            task = std::move(posted_tasks.front());
+            posted_tasks.pop_front();
+        }
+        task();
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            auto guard = std::lock_guard(posted_lock);
+            if (!posted_tasks.empty()) {
+                wake_up();
+            }
+            return;
+        }
+    }
+}
+
+auto Platform::get_thread_pool() -> ThreadPool & {
+    if (!thread_pool) {
+        thread_pool = std::make_shared<ThreadPool>();
+    }
+    return *thread_pool;
+}
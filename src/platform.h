@@ -9,23 +9,47 @@
 
 #include <mousecursors.h>
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <string_view>
+#include <vector>
 
 struct Theme;
 struct PlatformWindow;
 struct FontProvider;
 struct FileLoader;
 struct ImageLoader;
+struct ThreadPool;
+
+// Counters for profiling. These may be updated from worker threads.
+struct PlatformStatistics {
+    std::atomic<int> prewarm_glyphs = {0};
+    std::atomic<int64_t> prewarm_micro_seconds = {0};
+};
 
 struct Platform {
     bool exit_loop = false;
     bool close_on_last_window = true;
     std::string_view default_font_file = "";
+    std::vector<std::string> fallback_font_files = {};
     std::shared_ptr<Theme> default_theme = nullptr;
     std::shared_ptr<FontProvider> default_font = nullptr;
     std::shared_ptr<ImageLoader> image_loader = nullptr;
 
+    // Glyphs rasterized in the background while the first window is mapped. Empty means
+    // printable ASCII.
+    bool prewarm_fonts = true;
+    std::u32string prewarm_code_points = {};
+    PlatformStatistics statistics;
+
+    // Waits for the font prewarm, its callback writes the statistics
+    virtual ~Platform();
+
     auto init() -> void;
     virtual auto platform_init() -> void = 0;
     virtual auto done() -> void = 0;
@@ -33,9 +57,31 @@ struct Platform {
         -> std::shared_ptr<PlatformWindow> = 0;
     virtual auto show_window(std::shared_ptr<PlatformWindow> window) -> void = 0;
 
+    // Makes `theme` the default theme, and switches all open windows to it
+    virtual auto set_theme(std::shared_ptr<Theme> theme) -> void;
+
     // TODO: Should I pass the shared pointer, to keep API consistent?
     virtual auto clear_cursor_cache() -> void = 0;
     virtual auto set_cursor(PlatformWindow &window, MouseCursor cursor) -> void = 0;
     virtual auto invalidate(PlatformWindow &window) -> void = 0;
     virtual auto main_loop() -> void = 0;
+
+    // Runs `task` on the UI thread, from the main loop. Can be called from any thread.
+    auto post(std::function<void()> task) -> void;
+
+    // Called by the main loop. Stops after about half a frame, the remaining tasks run on the
+    // next iterations, so input and painting are not held back.
+    auto run_posted() -> void;
+
+    // Workers shared by the application, created on first use from the UI thread
+    auto get_thread_pool() -> ThreadPool &;
+
+  protected:
+    // Wakes the main loop from another thread, so it calls `run_posted()`
+    virtual auto wake_up() -> void {}
+
+  private:
+    std::mutex posted_lock;
+    std::deque<std::function<void()>> posted_tasks;
+    std::shared_ptr<ThreadPool> thread_pool;
 };
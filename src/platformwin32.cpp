@@ -16,6 +16,7 @@
 #include "platformwin32.h"
 #include "theme.h"
 #include "themes/fluent.h"
+#include "utf8.h"
 #include "widget.h"
 
 #if defined(SVISION_USE_FREETYPE)
@@ -26,6 +27,9 @@
 
 extern "C" int main(int, char **);
 
+// Sent to the UI thread by `Platform::post()`
+constexpr UINT svision_posted_message = WM_APP + 1;
+
 int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
     (void)(hInstance);
     (void)(hPrevInstance);
@@ -104,6 +108,12 @@ static auto convert_win32_mouse_event(UINT msg, WPARAM wParam, LPARAM lParam) ->
         break;
 
     case WM_MOUSEWHEEL:
+        // In screen coordinates, the window maps them to its client area
+        event.type = MouseEvents::Press;
+        event.pressed = true;
+        event.button = GET_WHEEL_DELTA_WPARAM(wParam) > 0 ? mouse_wheel_up : mouse_wheel_down;
+        event.y = static_cast<short>(HIWORD(lParam));
+        event.x = static_cast<short>(LOWORD(lParam));
         break;
 
     case WM_MOUSEMOVE:
@@ -113,6 +123,10 @@ static auto convert_win32_mouse_event(UINT msg, WPARAM wParam, LPARAM lParam) ->
         break;
     }
 
+    // The low word has the key state, also for the wheel
+    auto keys = LOWORD(wParam);
+    event.modifiers = (!!(keys & MK_CONTROL)) | (!!(keys & MK_SHIFT) << 1);
+
     //    spdlog::info("Mouse event at {}x{}", event.x, event.y);
     return event;
 }
@@ -209,6 +223,9 @@ static auto convert_mouse_cursor_to_win32(MouseCursor cursor) -> LPSTR {
 
 struct PlatformWindowWin32 : public PlatformWindow {
     HWND hwnd;
+
+    // Characters outside the BMP arrive as two WM_CHAR messages
+    Utf16Joiner typed_text;
 };
 
 static auto win32_paint_window(PlatformWindowWin32 *window) -> void {
@@ -303,7 +320,6 @@ static LRESULT CALLBACK svision_wndproc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
     case WM_MBUTTONDOWN:
     case WM_MBUTTONUP:
     case WM_MBUTTONDBLCLK:
-    case WM_MOUSEWHEEL:
     case WM_XBUTTONDOWN:
     case WM_XBUTTONUP:
     case WM_XBUTTONDBLCLK:
@@ -311,15 +327,31 @@ static LRESULT CALLBACK svision_wndproc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
         window->on_mouse(convert_win32_mouse_event(msg, wParam, lParam));
         break;
 
+    case WM_MOUSEWHEEL: {
+        auto event = convert_win32_mouse_event(msg, wParam, lParam);
+        auto point = POINT{event.x, event.y};
+        ScreenToClient(hwnd, &point);
+        event.x = point.x;
+        event.y = point.y;
+        window->on_mouse(event);
+    } break;
+
     case WM_KEYDOWN:
     case WM_KEYUP:
         window->on_keyboard(convert_win32_keyboard_event(msg, wParam, lParam));
         break;
 
     case WM_CHAR: {
+        auto code_point = window->typed_text.push(static_cast<char16_t>(wParam));
+        if (code_point == 0) {
+            break;
+        }
         auto event = EventKeyboard();
         event.keydown = true;
-        event.key = static_cast<KeyCodes>(wParam);
+        event.key = code_point < 0x10000 ? static_cast<KeyCodes>(code_point) : KeyCodes::Unknown;
+        if (code_point >= ' ' && code_point != 0x7F) {
+            utf8_append(event.text, code_point);
+        }
         window->on_keyboard(event);
     } break;
 
@@ -334,10 +366,17 @@ static LRESULT CALLBACK svision_wndproc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
 }
 static constexpr auto WINDOW_CLASS_NAME = L"svision2";
 
-PlatformWin32::PlatformWin32() { default_font_file = "c:\\Windows\\Fonts\\arial.ttf"; }
+PlatformWin32::PlatformWin32() {
+    default_font_file = "c:\\Windows\\Fonts\\arial.ttf";
+    fallback_font_files = {
+        "c:\\Windows\\Fonts\\segoeui.ttf",
+        "c:\\Windows\\Fonts\\seguisym.ttf",
+    };
+}
 
 auto PlatformWin32::platform_init() -> void {
     spdlog::set_level(spdlog::level::info);
+    ui_thread_id = GetCurrentThreadId();
 
     HINSTANCE hInstance = GetModuleHandle(NULL);
     WNDCLASSEXW wc = {};
@@ -372,7 +411,7 @@ auto PlatformWin32::open_window(int x, int y, int width, int height, const std::
         return nullptr;
     }
     SetWindowLongPtr(window->hwnd, GWLP_USERDATA, (LONG_PTR)window.get());
-    window->main_widget.theme = default_theme;
+    window->main_widget.set_theme(default_theme);
     window->platform = this;
     return window;
 }
@@ -383,6 +422,20 @@ auto PlatformWin32::show_window(std::shared_ptr<PlatformWindow> w) -> void {
     UpdateWindow(window->hwnd);
 }
 
+// Our windows keep a pointer to the PlatformWindow, there is no need for another list
+static BOOL CALLBACK set_window_theme(HWND hwnd, LPARAM lParam) {
+    auto window = (PlatformWindowWin32 *)GetWindowLongPtr(hwnd, GWLP_USERDATA);
+    if (window) {
+        window->set_theme(*reinterpret_cast<std::shared_ptr<Theme> *>(lParam));
+    }
+    return TRUE;
+}
+
+auto PlatformWin32::set_theme(std::shared_ptr<Theme> theme) -> void {
+    Platform::set_theme(theme);
+    EnumThreadWindows(GetCurrentThreadId(), set_window_theme, (LPARAM)&theme);
+}
+
 auto PlatformWin32::set_cursor(PlatformWindow &window, MouseCursor cursor) -> void {
     HCURSOR win32_cursor;
 
@@ -408,6 +461,10 @@ auto PlatformWin32::invalidate(PlatformWindow &w) -> void {
     InvalidateRect(window->hwnd, 0, 1);
 }
 
+auto PlatformWin32::wake_up() -> void {
+    PostThreadMessage(ui_thread_id, svision_posted_message, 0, 0);
+}
+
 auto PlatformWin32::main_loop() -> void {
     MSG msg;
     while (GetMessage(&msg, NULL, 0, 0) && !this->exit_loop) {
@@ -415,6 +472,10 @@ auto PlatformWin32::main_loop() -> void {
             spdlog::debug("Closing event loop, due to request from WM");
             return;
         }
+        if (msg.hwnd == NULL && msg.message == svision_posted_message) {
+            run_posted();
+            continue;
+        }
         TranslateMessage(&msg);
         DispatchMessage(&msg);
 
@@ -19,11 +19,18 @@ struct PlatformWin32 : Platform {
     virtual auto open_window(int x, int y, int width, int height, const std::string_view title)
         -> std::shared_ptr<PlatformWindow> override;
     virtual auto show_window(std::shared_ptr<PlatformWindow> window) -> void override;
+    virtual auto set_theme(std::shared_ptr<Theme> theme) -> void override;
 
     virtual auto set_cursor(PlatformWindow &window, MouseCursor cursor) -> void override;
     virtual auto clear_cursor_cache() -> void override;
     virtual auto invalidate(PlatformWindow &window) -> void override;
     virtual auto main_loop() -> void override;
+
+  protected:
+    virtual auto wake_up() -> void override;
+
+  private:
+    unsigned long ui_thread_id = 0;
 };
 
 using ThePlatform = PlatformWin32;
@@ -13,8 +13,14 @@
 
 #include <spdlog/spdlog.h>
 
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
 #include "events.h"
 #include "platformx11.h"
+#include "utf8.h"
 #include "widget.h"
 
 #include "platformx11-keycodes.h"
@@ -63,7 +69,15 @@ static auto convert_x11_key_event(XEvent &ev) -> EventKeyboard {
     auto event = EventKeyboard();
     char buf[20];
     KeySym keySym;
-    (void)XLookupString(reinterpret_cast<XKeyEvent *>(&ev), buf, 20, &keySym, nullptr);
+    auto length = XLookupString(reinterpret_cast<XKeyEvent *>(&ev), buf, 20, &keySym, nullptr);
+
+    // The lookup returns Latin-1, control characters type nothing
+    for (auto i = 0; i < length; i++) {
+        auto c = static_cast<unsigned char>(buf[i]);
+        if (c >= ' ' && c != 0x7F && (c < 0x80 || c >= 0xA0)) {
+            utf8_append(event.text, c);
+        }
+    }
 
     // TODO binary search could be nice.
     for (auto i = 0; X11_KEYCODES[i] != 0; i += 2) {
@@ -105,6 +119,11 @@ static auto convert_x11_mouse_event(const XEvent &ev) -> EventMouse {
         event.pressed = false;
         break;
     }
+    if (ev.type == ButtonPress || ev.type == ButtonRelease) {
+        auto m = ev.xbutton.state;
+        event.modifiers = (!!(m & ControlMask)) | (!!(m & ShiftMask) << 1) |
+                          (!!(m & Mod1Mask) << 2) | (!!(m & Mod4Mask) << 3);
+    }
     return event;
 }
 
@@ -177,7 +196,13 @@ struct PlatformWindowX11 : public PlatformWindow {
     }
 };
 
-PlatformX11::PlatformX11() { default_font_file = SVISION_X11_TTF_PATH SVISION_X11_TTF_FILENAME; }
+PlatformX11::PlatformX11() {
+    default_font_file = SVISION_X11_TTF_PATH SVISION_X11_TTF_FILENAME;
+    fallback_font_files = {
+        SVISION_X11_TTF_PATH "freefont/FreeSerif.ttf",
+        SVISION_X11_TTF_PATH "dejavu/DejaVuSans.ttf",
+    };
+}
 
 auto PlatformX11::platform_init() -> void {
     spdlog::set_level(spdlog::level::info);
@@ -190,6 +215,10 @@ auto PlatformX11::platform_init() -> void {
         return;
     }
 
+    if (pipe2(wake_pipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+        spdlog::error("Could not create the wake up pipe, posted tasks will not run");
+    }
+
     spdlog::info("PlatformX11 initialized");
 }
 
@@ -199,6 +228,12 @@ auto PlatformX11::done() -> void {
         XFreeGC(dpy, w.second->gc);
     }
     XCloseDisplay(dpy);
+    for (auto &fd : wake_pipe) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
 }
 
 auto PlatformX11::open_window(int x, int y, int width, int height, const std::string_view title)
@@ -217,7 +252,7 @@ auto PlatformX11::open_window(int x, int y, int width, int height, const std::st
     XSetWMProtocols(dpy, window->x11_window, &wmDeleteMessage, 1);
 
     window->main_widget.content.resize(width, height);
-    window->main_widget.theme = default_theme;
+    window->main_widget.set_theme(default_theme);
     window->platform = this;
     window->x11_image = XCreateImage(
         dpy, DefaultVisual(dpy, 0), 24, ZPixmap, 0,
@@ -235,6 +270,13 @@ auto PlatformX11::show_window(std::shared_ptr<PlatformWindow> w) -> void {
     XSync(dpy, window->x11_window);
 }
 
+auto PlatformX11::set_theme(std::shared_ptr<Theme> theme) -> void {
+    Platform::set_theme(theme);
+    for (auto &w : windows) {
+        w.second->set_theme(theme);
+    }
+}
+
 auto PlatformX11::set_cursor(PlatformWindow &window, MouseCursor cursor) -> void {
     auto x11_window = static_cast<PlatformWindowX11 *>(&window);
     Cursor x11_font_cursor;
@@ -270,12 +312,55 @@ auto PlatformX11::invalidate(PlatformWindow &window) -> void {
     XFlush(dpy);
 }
 
+auto PlatformX11::wake_up() -> void {
+    auto byte = char(1);
+    if (wake_pipe[1] >= 0) {
+        // A full pipe already wakes the loop
+        [[maybe_unused]] auto written = write(wake_pipe[1], &byte, 1);
+    }
+}
+
+auto PlatformX11::wait_for_event() -> bool {
+    if (wake_pipe[0] < 0) {
+        return true;
+    }
+
+    // Posted tasks and X events take turns, neither can hold back the other
+    pollfd fds[2] = {{ConnectionNumber(dpy), POLLIN, 0}, {wake_pipe[0], POLLIN, 0}};
+    auto has_events = XPending(dpy) > 0;
+    while (true) {
+        if (poll(fds, 2, has_events ? 0 : -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return true;
+        }
+        auto has_posted = (fds[1].revents & POLLIN) != 0;
+        has_events = has_events || XPending(dpy) > 0;
+        if (has_posted && !(has_events && posted_last)) {
+            char buffer[64];
+            while (read(wake_pipe[0], buffer, sizeof(buffer)) > 0) {
+            }
+            posted_last = true;
+            return false;
+        }
+        if (has_events) {
+            posted_last = false;
+            return true;
+        }
+    }
+}
+
 auto PlatformX11::main_loop() -> void {
     XEvent ev;
     int pending;
     Position last_mouse_position;
 
     while ((pending = XPending(dpy) || !this->exit_loop)) {
+        if (!wait_for_event()) {
+            run_posted();
+            continue;
+        }
         auto k = XNextEvent(dpy, &ev);
         if (k) {
             spdlog::error("Reading from X failed with error %d", k);
@@ -36,11 +36,23 @@ struct PlatformX11 : Platform {
     virtual auto open_window(int x, int y, int width, int height, const std::string_view title)
         -> std::shared_ptr<PlatformWindow> override;
     virtual auto show_window(std::shared_ptr<PlatformWindow> window) -> void override;
+    virtual auto set_theme(std::shared_ptr<Theme> theme) -> void override;
 
     virtual auto set_cursor(PlatformWindow &window, MouseCursor cursor) -> void override;
     virtual auto clear_cursor_cache() -> void override;
     virtual auto invalidate(PlatformWindow &window) -> void override;
     virtual auto main_loop() -> void override;
+
+  protected:
+    virtual auto wake_up() -> void override;
+
+  private:
+    // Blocks until there is an X event, returns false when woken for posted tasks instead
+    auto wait_for_event() -> bool;
+
+    // Written by `wake_up()`, read by the main loop
+    int wake_pipe[2] = {-1, -1};
+    bool posted_last = false;
 };
 
 using ThePlatform = PlatformX11;
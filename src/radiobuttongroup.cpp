@@ -34,7 +34,7 @@ RadioButtonGroup::RadioButtonGroup(Position position, int width,
     auto p = Position{0, 0};
     auto height = 0;
     this->layout = std::make_shared<VerticalLayout>();
-    mouse_cursor = MouseCursor::Link;
+    set_cursor(MouseCursor::Link);
 
     for (auto &item : items) {
         auto cb = add_new<Checkbox>(p, width, item);
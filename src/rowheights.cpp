@@ -0,0 +1,355 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "rowheights.h"
+
+#include <algorithm>
+#include <numeric>
+
+static auto lowest_bit(size_t i) -> size_t { return i & (~i + 1); }
+
+auto RowHeights::Block::sum(size_t from, size_t to) const -> int64_t {
+    if (!is_measured()) {
+        return static_cast<int64_t>(to - from) * height;
+    }
+    return std::accumulate(heights.begin() + from, heights.begin() + to, int64_t(0));
+}
+
+auto RowHeights::reset(size_t new_count, int height) -> void {
+    count = new_count;
+    uniform_height = height;
+    total = static_cast<int64_t>(count) * height;
+    blocks.clear();
+    blocks.shrink_to_fit();
+    row_tree.clear();
+    row_tree.shrink_to_fit();
+    height_tree.clear();
+    height_tree.shrink_to_fit();
+}
+
+auto RowHeights::set_height(size_t row, int height) -> void {
+    if (row >= count) {
+        return;
+    }
+    auto first = size_t(0);
+    auto block = size_t(0);
+    if (is_uniform()) {
+        if (height == uniform_height) {
+            return;
+        }
+        blocks.push_back({count, uniform_height, {}});
+    } else {
+        block = find_block(row, first);
+    }
+    auto index = row - first;
+    if (!blocks[block].is_measured()) {
+        if (blocks[block].height == height) {
+            return;
+        }
+
+        // Only the rows around `row` are measured, the rest of the run keeps its count
+        auto from = index - index % block_size;
+        auto to = std::min(from + block_size, blocks[block].rows);
+        split_block(block, to);
+        block = split_block(block, from);
+        index -= from;
+        blocks[block].heights.assign(blocks[block].rows, blocks[block].height);
+        build_tree();
+    }
+
+    auto &heights = blocks[block].heights;
+    auto delta = static_cast<int64_t>(height) - heights[index];
+    if (delta == 0) {
+        return;
+    }
+    heights[index] = height;
+    total += delta;
+    add_to_tree(block, 0, delta);
+}
+
+auto RowHeights::insert(size_t row, size_t rows, int height) -> void {
+    row = std::min(row, count);
+    if (rows == 0) {
+        return;
+    }
+    auto added = static_cast<int64_t>(rows) * height;
+    if (is_uniform() && height == uniform_height) {
+        count += rows;
+        total += added;
+        return;
+    }
+
+    // Rows appended go to the last block
+    auto first = size_t(0);
+    auto block = size_t(0);
+    if (is_uniform()) {
+        blocks.push_back({count, uniform_height, {}});
+    } else if (row == count) {
+        block = blocks.size() - 1;
+        first = count - blocks[block].rows;
+    } else {
+        block = find_block(row, first);
+    }
+    auto index = row - first;
+    auto &target = blocks[block];
+    count += rows;
+    total += added;
+
+    if (!target.is_measured() && target.height == height) {
+        target.rows += rows;
+        add_to_tree(block, static_cast<int64_t>(rows), added);
+        return;
+    }
+    if (target.is_measured() && rows <= block_size) {
+        target.heights.insert(target.heights.begin() + index, rows, height);
+        target.rows += rows;
+        if (target.rows <= block_size * 2) {
+            add_to_tree(block, static_cast<int64_t>(rows), added);
+            return;
+        }
+        split_block(block, target.rows / 2);
+        build_tree();
+        return;
+    }
+
+    // Otherwise the new rows are a run of their own
+    auto at = split_block(block, index);
+    blocks.insert(blocks.begin() + at, Block{rows, height, {}});
+    build_tree();
+}
+
+auto RowHeights::remove(size_t row, size_t rows) -> void {
+    if (row >= count) {
+        return;
+    }
+    rows = std::min(rows, count - row);
+    if (rows == 0) {
+        return;
+    }
+    if (is_uniform()) {
+        count -= rows;
+        total -= static_cast<int64_t>(rows) * uniform_height;
+        return;
+    }
+
+    auto first = size_t(0);
+    auto block = find_block(row, first);
+    auto index = row - first;
+    count -= rows;
+    if (index + rows < blocks[block].rows) {
+        auto &target = blocks[block];
+        auto removed = target.sum(index, index + rows);
+        total -= removed;
+        target.rows -= rows;
+        if (!target.is_measured()) {
+            add_to_tree(block, -static_cast<int64_t>(rows), -removed);
+            return;
+        }
+        target.heights.erase(target.heights.begin() + index,
+                             target.heights.begin() + index + rows);
+        settle_block(target);
+        build_tree();
+        return;
+    }
+
+    // The removed rows span blocks, they are cut at both ends and dropped
+    auto from = split_block(block, index);
+    auto to = from;
+    while (rows != 0) {
+        if (blocks[to].rows > rows) {
+            split_block(to, rows);
+        }
+        rows -= blocks[to].rows;
+        total -= blocks[to].sum(0, blocks[to].rows);
+        to++;
+    }
+    blocks.erase(blocks.begin() + from, blocks.begin() + to);
+    if (from != 0) {
+        settle_block(blocks[from - 1]);
+    }
+    if (from < blocks.size()) {
+        settle_block(blocks[from]);
+    }
+    build_tree();
+}
+
+auto RowHeights::get_height(size_t row) const -> int {
+    if (row >= count) {
+        return 0;
+    }
+    if (is_uniform()) {
+        return uniform_height;
+    }
+    auto first = size_t(0);
+    auto block = find_block(row, first);
+    return blocks[block].get_height(row - first);
+}
+
+auto RowHeights::offset_of(size_t row) const -> int64_t {
+    if (row >= count) {
+        return total;
+    }
+    if (is_uniform()) {
+        return static_cast<int64_t>(row) * uniform_height;
+    }
+    auto first = size_t(0);
+    auto block = find_block(row, first);
+    return block_offset(block) + blocks[block].sum(0, row - first);
+}
+
+auto RowHeights::row_at(int64_t offset) const -> size_t {
+    if (count == 0) {
+        return 0;
+    }
+    offset = std::max(offset, int64_t(0));
+    if (offset >= total) {
+        return count - 1;
+    }
+    if (is_uniform()) {
+        return static_cast<size_t>(offset / uniform_height);
+    }
+
+    // Descend the tree, skipping blocks which end before the offset
+    auto block = size_t(0);
+    auto row = size_t(0);
+    auto step = size_t(1);
+    while (step * 2 < height_tree.size()) {
+        step *= 2;
+    }
+    for (; step != 0; step /= 2) {
+        auto next = block + step;
+        if (next < height_tree.size() && height_tree[next] <= offset) {
+            block = next;
+            offset -= height_tree[next];
+            row += row_tree[next];
+        }
+    }
+    if (block >= blocks.size()) {
+        return count - 1;
+    }
+
+    // Then the rows of the block
+    auto &target = blocks[block];
+    if (!target.is_measured()) {
+        row += target.height == 0 ? target.rows : static_cast<size_t>(offset / target.height);
+    } else {
+        for (auto height : target.heights) {
+            if (offset < height) {
+                break;
+            }
+            offset -= height;
+            row++;
+        }
+    }
+    return row < count ? row : count - 1;
+}
+
+auto RowHeights::find_block(size_t row, size_t &first) const -> size_t {
+    auto block = size_t(0);
+    auto step = size_t(1);
+    first = 0;
+    while (step * 2 < row_tree.size()) {
+        step *= 2;
+    }
+    for (; step != 0; step /= 2) {
+        auto next = block + step;
+        if (next < row_tree.size() && first + row_tree[next] <= row) {
+            block = next;
+            first += row_tree[next];
+        }
+    }
+    return block;
+}
+
+auto RowHeights::block_offset(size_t block) const -> int64_t {
+    auto offset = int64_t(0);
+    for (auto i = block; i > 0; i -= lowest_bit(i)) {
+        offset += height_tree[i];
+    }
+    return offset;
+}
+
+auto RowHeights::split_block(size_t block, size_t row) -> size_t {
+    auto &target = blocks[block];
+    if (row == 0) {
+        return block;
+    }
+    if (row >= target.rows) {
+        return block + 1;
+    }
+    auto tail = Block{target.rows - row, target.height, {}};
+    if (target.is_measured()) {
+        tail.heights.assign(target.heights.begin() + row, target.heights.end());
+        target.heights.resize(row);
+    }
+    target.rows = row;
+    blocks.insert(blocks.begin() + block + 1, std::move(tail));
+    return block + 1;
+}
+
+auto RowHeights::settle_block(Block &block) -> void {
+    if (!block.is_measured()) {
+        return;
+    }
+    auto height = block.heights.front();
+    auto is_run = std::all_of(block.heights.begin(), block.heights.end(),
+                              [height](int h) { return h == height; });
+    if (is_run) {
+        block.height = height;
+        block.heights = {};
+    }
+}
+
+auto RowHeights::build_tree() -> void {
+    auto merged = size_t(0);
+    for (auto &block : blocks) {
+        if (block.rows == 0) {
+            continue;
+        }
+        if (merged != 0) {
+            auto &previous = blocks[merged - 1];
+            if (!previous.is_measured() && !block.is_measured() &&
+                previous.height == block.height) {
+                previous.rows += block.rows;
+                continue;
+            }
+        }
+        if (&blocks[merged] != &block) {
+            blocks[merged] = std::move(block);
+        }
+        merged++;
+    }
+    blocks.resize(merged);
+    if (blocks.empty() || (blocks.size() == 1 && !blocks.front().is_measured() &&
+                           blocks.front().height == uniform_height)) {
+        reset(count, uniform_height);
+        return;
+    }
+
+    row_tree.assign(blocks.size() + 1, 0);
+    height_tree.assign(blocks.size() + 1, 0);
+    total = 0;
+    for (size_t i = 1; i < row_tree.size(); i++) {
+        auto &block = blocks[i - 1];
+        auto sum = block.sum(0, block.rows);
+        total += sum;
+        row_tree[i] += block.rows;
+        height_tree[i] += sum;
+        auto parent = i + lowest_bit(i);
+        if (parent < row_tree.size()) {
+            row_tree[parent] += row_tree[i];
+            height_tree[parent] += height_tree[i];
+        }
+    }
+}
+
+auto RowHeights::add_to_tree(size_t block, int64_t rows, int64_t height) -> void {
+    for (auto i = block + 1; i < row_tree.size(); i += lowest_bit(i)) {
+        row_tree[i] += rows;
+        height_tree[i] += height;
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Heights of the rows of a view, and their offsets from the top, in 64 bit pixels.
+// While all rows have the same height nothing is stored. Otherwise the rows are split in
+// blocks: runs of rows of the same height keep only their count, measured blocks keep the
+// height of each of their rows. Fenwick trees over the rows and heights of the blocks give
+// offsets and lookups in O(log blocks). Memory grows with the rows which were given a height,
+// not with the size of the list.
+struct RowHeights {
+    auto reset(size_t count, int height) -> void;
+    auto set_height(size_t row, int height) -> void;
+    auto get_height(size_t row) const -> int;
+
+    // Rows after `row` move. Inserting rows of the height of the run they land in is
+    // O(log blocks), otherwise blocks are split or removed, which costs O(blocks). Rows are
+    // never copied one by one, except inside a measured block.
+    auto insert(size_t row, size_t rows, int height) -> void;
+    auto remove(size_t row, size_t rows) -> void;
+
+    // Offset of the top of `row`, `size()` gives the total height
+    auto offset_of(size_t row) const -> int64_t;
+
+    // The row containing `offset`, clamped to the valid rows
+    auto row_at(int64_t offset) const -> size_t;
+
+    auto size() const -> size_t { return count; }
+    auto total_height() const -> int64_t { return total; }
+    auto is_uniform() const -> bool { return blocks.empty(); }
+
+  private:
+    // Rows measured together, measured blocks grow up to twice this by inserts
+    static constexpr size_t block_size = 256;
+
+    struct Block {
+        size_t rows = 0;
+
+        // Height of all the rows, unless they are measured
+        int height = 0;
+        std::vector<int> heights;
+
+        auto is_measured() const -> bool { return !heights.empty(); }
+        auto get_height(size_t row) const -> int { return is_measured() ? heights[row] : height; }
+        auto sum(size_t from, size_t to) const -> int64_t;
+    };
+
+    // The block containing `row`, and the first row of that block
+    auto find_block(size_t row, size_t &first) const -> size_t;
+    auto block_offset(size_t block) const -> int64_t;
+
+    // Splits a block before its row `row`, returns the index of the block starting there
+    auto split_block(size_t block, size_t row) -> size_t;
+
+    // A measured block whose rows have the same height becomes a run
+    auto settle_block(Block &block) -> void;
+
+    // Merges runs of the same height, and drops the blocks when all rows have the uniform
+    // height again. Then builds the trees, in O(blocks).
+    auto build_tree() -> void;
+    auto add_to_tree(size_t block, int64_t rows, int64_t height) -> void;
+
+    size_t count = 0;
+    int uniform_height = 0;
+    int64_t total = 0;
+
+    // Empty while all rows have the uniform height
+    std::vector<Block> blocks;
+
+    // Sums of the rows and heights of the blocks, 1 based
+    std::vector<size_t> row_tree;
+    std::vector<int64_t> height_tree;
+};
@@ -9,6 +9,8 @@
 #include "theme.h"
 #include <button.h>
 
+#include <algorithm>
+
 auto make_buttons(ScrollBar &sb, int length, bool horizontal) {
     // TODO button text should be images (?). However - buttons do not support
     // images yet.
@@ -141,7 +143,8 @@ auto ScrollBar::set_value(int new_value) -> void {
     }
 }
 
-auto ScrollBar::set_values(int min, int max, int new_value, int new_step) -> void {
+auto ScrollBar::set_values(int min, int max, int new_value, int new_step, int new_page_size)
+    -> void {
     if (new_value < min) {
         new_value = min;
     }
@@ -154,6 +157,7 @@ auto ScrollBar::set_values(int min, int max, int new_value, int new_step) -> voi
     this->minimum = min;
     this->maximum = max;
     this->step = new_step;
+    this->page_size = new_page_size;
     this->value = new_value;
     update_thumb_size();
     up_button->invalidate();
@@ -200,6 +204,20 @@ auto ScrollBar::update_thumb_size() -> void {
                              : up_button->content.size.height + down_button->content.size.height;
     auto length = is_horizontal ? content.size.width : content.size.height;
     auto range = maximum - minimum;
+    auto offset = static_cast<int64_t>(value - minimum);
+
+    if (page_size > 0) {
+        auto available_size = std::max(length - thumb_padding, 0);
+        auto minimum_thumb_size =
+            is_horizontal ? down_button->content.size.width : down_button->content.size.height;
+        auto total = static_cast<int64_t>(range) + page_size;
+        auto proportional_size = available_size * static_cast<int64_t>(page_size) / total;
+        thumb_size = std::clamp(static_cast<int>(proportional_size),
+                                std::min(minimum_thumb_size, available_size), available_size);
+        auto thumb_range = available_size - thumb_size;
+        thumb_position = range == 0 ? 0 : static_cast<int>(offset * thumb_range / range);
+        return;
+    }
 
     auto draw_area = is_horizontal ? content.size.width - down_button->content.size.width * 2
                                    : content.size.height - down_button->content.size.height * 2;
@@ -227,7 +245,7 @@ auto ScrollBar::update_thumb_size() -> void {
                          ? maximum_thumb_size
                          : std::max(minimum_thumb_size, available_size * (visible_range / range));
         thumb_range = available_size - thumb_size;
-        thumb_position = range == 0 ? 0 : (value - minimum) * thumb_range / range;
+        thumb_position = range == 0 ? 0 : static_cast<int>(offset * thumb_range / range);
     }
     // technically - `invalidate()` should be called, but it is called usually
     // right after this function
@@ -23,12 +23,17 @@ struct ScrollBar : Widget {
     int value = maximum;
     int step = (maximum - minimum) / 10;
 
+    // Size of the visible part, in the units of the value. When set the thumb is proportional to
+    // it, otherwise its size is derived from the step.
+    int page_size = 0;
+
     auto draw() -> void override;
     auto on_resize() -> void override;
     auto size_hint() const -> Size override;
 
     auto set_value(int value) -> void;
-    auto set_values(int minimum, int maximum, int value, int step = 0) -> void;
+    auto set_values(int minimum, int maximum, int value, int step = 0, int page_size = 0)
+        -> void;
     auto step_up() -> void;
     auto step_down() -> void;
 
@@ -0,0 +1,198 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "selectionmodel.h"
+
+#include <algorithm>
+
+// Adds `range` to the end of `ranges`, merging it with the last one when they touch
+static auto append(std::vector<RowRange> &ranges, RowRange range) -> void {
+    if (range.first >= range.last) {
+        return;
+    }
+    if (!ranges.empty() && ranges.back().last >= range.first) {
+        ranges.back().last = std::max(ranges.back().last, range.last);
+        return;
+    }
+    ranges.push_back(range);
+}
+
+// Rows in exactly one of the two lists
+static auto difference(const std::vector<RowRange> &ranges1,
+                       const std::vector<RowRange> &ranges2)
+    -> std::vector<RowRange> {
+    // Walks the boundaries of both lists in order, each one flips the state of its list
+    auto bounds = std::vector<size_t>();
+    bounds.reserve((ranges1.size() + ranges2.size()) * 2);
+    auto bounds1 = std::vector<size_t>();
+    for (auto &range : ranges1) {
+        bounds1.push_back(range.first);
+        bounds1.push_back(range.last);
+    }
+    auto bounds2 = std::vector<size_t>();
+    for (auto &range : ranges2) {
+        bounds2.push_back(range.first);
+        bounds2.push_back(range.last);
+    }
+    std::merge(bounds1.begin(), bounds1.end(), bounds2.begin(), bounds2.end(),
+               std::back_inserter(bounds));
+
+    // A boundary found in both lists flips twice, pairs of equal values cancel out
+    auto result = std::vector<RowRange>();
+    auto is_inside = false;
+    auto start = size_t(0);
+    for (size_t i = 0; i < bounds.size(); i++) {
+        if (i + 1 < bounds.size() && bounds[i] == bounds[i + 1]) {
+            i++;
+            continue;
+        }
+        if (!is_inside) {
+            start = bounds[i];
+        } else {
+            append(result, {start, bounds[i]});
+        }
+        is_inside = !is_inside;
+    }
+    return result;
+}
+
+auto SelectionModel::is_selected(size_t row) const -> bool {
+    auto found = std::upper_bound(ranges.begin(), ranges.end(), row,
+                                  [](size_t row, const RowRange &r) { return row < r.first; });
+    return found != ranges.begin() && row < std::prev(found)->last;
+}
+
+auto SelectionModel::get_selected_count() const -> size_t {
+    auto count = size_t(0);
+    for (auto &range : ranges) {
+        count += range.size();
+    }
+    return count;
+}
+
+auto SelectionModel::select(size_t first, size_t last) -> void {
+    if (first >= last) {
+        return;
+    }
+    auto new_ranges = std::vector<RowRange>();
+    new_ranges.reserve(ranges.size() + 1);
+    auto is_added = false;
+    for (auto &range : ranges) {
+        if (!is_added && first <= range.first) {
+            append(new_ranges, {first, last});
+            is_added = true;
+        }
+        append(new_ranges, range);
+    }
+    if (!is_added) {
+        append(new_ranges, {first, last});
+    }
+    replace(std::move(new_ranges));
+}
+
+auto SelectionModel::deselect(size_t first, size_t last) -> void {
+    if (first >= last) {
+        return;
+    }
+    auto new_ranges = std::vector<RowRange>();
+    new_ranges.reserve(ranges.size() + 1);
+    for (auto &range : ranges) {
+        append(new_ranges, {range.first, std::min(range.last, first)});
+        append(new_ranges, {std::max(range.first, last), range.last});
+    }
+    replace(std::move(new_ranges));
+}
+
+auto SelectionModel::toggle(size_t row) -> void {
+    if (is_selected(row)) {
+        deselect(row, row + 1);
+    } else {
+        select(row, row + 1);
+    }
+}
+
+auto SelectionModel::set_selection(const std::vector<RowRange> &new_ranges) -> void {
+    auto merged = std::vector<RowRange>();
+    merged.reserve(new_ranges.size());
+    for (auto &range : new_ranges) {
+        append(merged, range);
+    }
+    replace(std::move(merged));
+}
+
+auto SelectionModel::select_only(size_t first, size_t last) -> void {
+    auto new_ranges = std::vector<RowRange>();
+    append(new_ranges, {first, last});
+    replace(std::move(new_ranges));
+}
+
+auto SelectionModel::select_all(size_t count) -> void { select_only(0, count); }
+
+auto SelectionModel::invert(size_t count) -> void {
+    auto new_ranges = std::vector<RowRange>();
+    new_ranges.reserve(ranges.size() + 1);
+    auto start = size_t(0);
+    for (auto &range : ranges) {
+        append(new_ranges, {start, std::min(range.first, count)});
+        start = range.last;
+    }
+    append(new_ranges, {start, count});
+    replace(std::move(new_ranges));
+}
+
+auto SelectionModel::clear() -> void { replace({}); }
+
+auto SelectionModel::insert_rows(size_t first, size_t count) -> void {
+    auto new_ranges = std::vector<RowRange>();
+    new_ranges.reserve(ranges.size() + 1);
+    for (auto range : ranges) {
+        if (range.last <= first) {
+            new_ranges.push_back(range);
+        } else if (range.first >= first) {
+            new_ranges.push_back({range.first + count, range.last + count});
+        } else {
+            // New rows inside a range are not selected
+            new_ranges.push_back({range.first, first});
+            new_ranges.push_back({first + count, range.last + count});
+        }
+    }
+    ranges = std::move(new_ranges);
+}
+
+auto SelectionModel::remove_rows(size_t first, size_t count) -> void {
+    auto last = first + count;
+    auto shift = [first, last, count](size_t row) {
+        return row <= first ? row : row < last ? first : row - count;
+    };
+    auto new_ranges = std::vector<RowRange>();
+    new_ranges.reserve(ranges.size());
+    for (auto &range : ranges) {
+        append(new_ranges, {shift(range.first), shift(range.last)});
+    }
+    ranges = std::move(new_ranges);
+}
+
+auto SelectionModel::add_observer(SelectionObserver *observer) -> void {
+    if (std::find(observers.begin(), observers.end(), observer) == observers.end()) {
+        observers.push_back(observer);
+    }
+}
+
+auto SelectionModel::remove_observer(SelectionObserver *observer) -> void {
+    observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+}
+
+auto SelectionModel::replace(std::vector<RowRange> &&new_ranges) -> void {
+    auto changed = difference(ranges, new_ranges);
+    ranges = std::move(new_ranges);
+    if (changed.empty()) {
+        return;
+    }
+    for (auto observer : observers) {
+        observer->on_selection_changed(changed);
+    }
+}
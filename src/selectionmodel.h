@@ -0,0 +1,64 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Rows [first, last)
+struct RowRange {
+    size_t first = 0;
+    size_t last = 0;
+
+    auto size() const -> size_t { return last - first; }
+    auto operator==(const RowRange &other) const -> bool {
+        return first == other.first && last == other.last;
+    }
+};
+
+struct SelectionObserver {
+    virtual ~SelectionObserver() = default;
+
+    // The rows which were selected or deselected, as sorted ranges
+    virtual auto on_selection_changed(const std::vector<RowRange> &changed) -> void = 0;
+};
+
+// Selected rows, kept as sorted ranges which do not touch each other. Memory and the cost of
+// every change depend on the number of ranges, not on the number of rows, so selecting all
+// the rows of a huge list is a single range.
+struct SelectionModel {
+    auto is_selected(size_t row) const -> bool;
+    auto get_ranges() const -> const std::vector<RowRange> & { return ranges; }
+    auto get_selected_count() const -> size_t;
+    auto is_empty() const -> bool { return ranges.empty(); }
+
+    auto select(size_t first, size_t last) -> void;
+    auto deselect(size_t first, size_t last) -> void;
+    auto toggle(size_t row) -> void;
+
+    // Replaces the selection, `new_ranges` must be sorted
+    auto set_selection(const std::vector<RowRange> &new_ranges) -> void;
+    auto select_only(size_t first, size_t last) -> void;
+    auto select_all(size_t count) -> void;
+    auto invert(size_t count) -> void;
+    auto clear() -> void;
+
+    // Keeps the selection on the same rows when rows are inserted or removed. Observers are
+    // not told, the rows did not change their state.
+    auto insert_rows(size_t first, size_t count) -> void;
+    auto remove_rows(size_t first, size_t count) -> void;
+
+    auto add_observer(SelectionObserver *observer) -> void;
+    auto remove_observer(SelectionObserver *observer) -> void;
+
+  private:
+    auto replace(std::vector<RowRange> &&new_ranges) -> void;
+
+    std::vector<RowRange> ranges;
+    std::vector<SelectionObserver *> observers;
+};
@@ -53,6 +53,12 @@ struct Position {
         p.y -= delta;
         return p;
     }
+
+    auto inline operator==(const Position &other) const -> bool {
+        return x == other.x && y == other.y;
+    }
+
+    auto inline operator!=(const Position &other) const -> bool { return !(*this == other); }
 };
 
 struct Size {
@@ -0,0 +1,300 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "sortfilteradapter.h"
+#include "platform.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+
+struct SortFilterProxyAdapter::Job {
+    uint64_t number = 0;
+    std::shared_ptr<std::atomic<uint64_t>> current_job;
+    std::weak_ptr<SortFilterProxyAdapter> adapter;
+    std::shared_ptr<ItemAdapter> source;
+    Platform *platform = nullptr;
+
+    // Rows to check, all the source rows when null
+    std::shared_ptr<const std::vector<size_t>> candidates;
+    size_t source_count = 0;
+    SortOrder sort_order = SortOrder::None;
+    bool sort = false;
+    std::string filter;
+    Less less;
+    Matches matches;
+    size_t chunk_size = 0;
+
+    auto is_cancelled() const -> bool { return *current_job != number; }
+};
+
+static auto contains_ignoring_case(std::string_view text, std::string_view filter) -> bool {
+    auto same = [](char c1, char c2) {
+        return std::tolower(static_cast<unsigned char>(c1)) ==
+               std::tolower(static_cast<unsigned char>(c2));
+    };
+    return std::search(text.begin(), text.end(), filter.begin(), filter.end(), same) != text.end();
+}
+
+// Parts are sorted on the workers, then merged in pairs, each level in parallel
+template <typename Compare>
+static auto parallel_sort(ThreadPool &pool, std::vector<size_t> &rows, Compare compare) -> void {
+    constexpr size_t min_part_size = 4096;
+    auto count = rows.size();
+    auto parts = std::max(std::min(pool.size(), count / min_part_size), size_t(1));
+    auto bounds = std::vector<size_t>(parts + 1);
+    for (size_t i = 0; i <= parts; i++) {
+        bounds[i] = count * i / parts;
+    }
+
+    pool.parallel_for(parts, [&](size_t part) {
+        std::stable_sort(rows.begin() + bounds[part], rows.begin() + bounds[part + 1], compare);
+    });
+
+    auto merged = std::vector<size_t>(count);
+    for (size_t width = 1; width < parts; width *= 2) {
+        auto merges = (parts + width * 2 - 1) / (width * 2);
+        pool.parallel_for(merges, [&](size_t merge) {
+            auto first = bounds[merge * width * 2];
+            auto middle = bounds[std::min(merge * width * 2 + width, parts)];
+            auto last = bounds[std::min(merge * width * 2 + width * 2, parts)];
+            std::merge(rows.begin() + first, rows.begin() + middle, rows.begin() + middle,
+                       rows.begin() + last, merged.begin() + first, compare);
+        });
+        rows.swap(merged);
+    }
+}
+
+SortFilterProxyAdapter::SortFilterProxyAdapter(std::shared_ptr<ItemAdapter> source,
+                                               Platform &platform)
+    : source(source), platform(platform) {
+    less = [](std::string_view a, std::string_view b) { return a < b; };
+    matches = contains_ignoring_case;
+    passed_rows.resize(source->get_count());
+    std::iota(passed_rows.begin(), passed_rows.end(), size_t(0));
+}
+
+SortFilterProxyAdapter::~SortFilterProxyAdapter() { (*current_job)++; }
+
+auto SortFilterProxyAdapter::get_count() const -> size_t {
+    auto pending_count = pending_rows ? pending_rows->size() - pending_first : 0;
+    return passed_rows.size() + pending_count;
+}
+
+auto SortFilterProxyAdapter::map_to_source(size_t position) const -> size_t {
+    if (position < passed_rows.size()) {
+        return passed_rows[position];
+    }
+    position -= passed_rows.size();
+    if (pending_rows && pending_first + position < pending_rows->size()) {
+        return (*pending_rows)[pending_first + position];
+    }
+
+    // Views measure the first row of empty lists
+    return position;
+}
+
+auto SortFilterProxyAdapter::get_widget(size_t position, Theme &theme) -> PWidget {
+    return source->get_widget(map_to_source(position), theme);
+}
+
+auto SortFilterProxyAdapter::set_content(PWidget widget, size_t position, ItemStatus status)
+    -> void {
+    source->set_content(widget, map_to_source(position), status);
+}
+
+auto SortFilterProxyAdapter::get_item_height(size_t position, Theme &theme) -> int {
+    return source->get_item_height(map_to_source(position), theme);
+}
+
+auto SortFilterProxyAdapter::has_uniform_height() const -> bool {
+    return source->has_uniform_height();
+}
+
+auto SortFilterProxyAdapter::get_view_type(size_t position) const -> int {
+    return source->get_view_type(map_to_source(position));
+}
+
+auto SortFilterProxyAdapter::get_text(size_t position) const -> std::string_view {
+    return source->get_text(map_to_source(position));
+}
+
+auto SortFilterProxyAdapter::set_sort_order(SortOrder new_order) -> void {
+    if (new_order == sort_order) {
+        return;
+    }
+    sort_order = new_order;
+    if (sort_order == SortOrder::None) {
+        order.reset();
+    }
+    start(sort_order != SortOrder::None);
+}
+
+auto SortFilterProxyAdapter::set_filter(std::string_view text) -> void {
+    if (text == filter) {
+        return;
+    }
+
+    // Rows which did not pass the previous filter cannot pass a narrower one
+    auto is_narrowing = is_complete && text.find(filter) != std::string_view::npos;
+    filter = text;
+    if (!is_narrowing) {
+        start(false);
+        return;
+    }
+
+    // Nothing changes on screen, the rows are checked again in place
+    auto job = make_job();
+    replace_on_first_chunk = false;
+    pending_rows = std::make_shared<const std::vector<size_t>>(std::move(passed_rows));
+    pending_first = 0;
+    passed_rows.clear();
+    job->candidates = pending_rows;
+    platform.get_thread_pool().submit([job]() { run(job); });
+}
+
+auto SortFilterProxyAdapter::refresh() -> void { start(sort_order != SortOrder::None); }
+
+auto SortFilterProxyAdapter::start(bool sort) -> void {
+    auto job = make_job();
+    replace_on_first_chunk = true;
+    job->candidates = sort ? nullptr : order;
+    job->sort = sort;
+    platform.get_thread_pool().submit([job]() { run(job); });
+}
+
+// A new job cancels the running one
+auto SortFilterProxyAdapter::make_job() -> std::shared_ptr<Job> {
+    auto job = std::make_shared<Job>();
+    job->number = ++(*current_job);
+    job->current_job = current_job;
+    job->adapter = weak_from_this();
+    job->source = source;
+    job->platform = &platform;
+    job->source_count = source->get_count();
+    job->sort_order = sort_order;
+    job->filter = filter;
+    job->less = less;
+    job->matches = matches;
+    job->chunk_size = std::max(chunk_size, size_t(1));
+    is_complete = false;
+    return job;
+}
+
+// Runs on a worker, everything it shows is posted to the UI thread
+auto SortFilterProxyAdapter::run(std::shared_ptr<Job> job) -> void {
+    auto &pool = job->platform->get_thread_pool();
+    auto post = [job](std::function<void(SortFilterProxyAdapter &)> apply) {
+        job->platform->post([job, apply = std::move(apply)]() {
+            if (auto adapter = job->adapter.lock()) {
+                apply(*adapter);
+            }
+        });
+    };
+
+    auto candidates = job->candidates;
+    if (!candidates) {
+        auto rows = std::vector<size_t>(job->source_count);
+        std::iota(rows.begin(), rows.end(), size_t(0));
+        if (job->sort) {
+            auto &source = *job->source;
+            auto &less = job->less;
+            if (job->sort_order == SortOrder::Descending) {
+                parallel_sort(pool, rows, [&](size_t a, size_t b) {
+                    return less(source.get_text(b), source.get_text(a));
+                });
+            } else {
+                parallel_sort(pool, rows, [&](size_t a, size_t b) {
+                    return less(source.get_text(a), source.get_text(b));
+                });
+            }
+            if (job->is_cancelled()) {
+                return;
+            }
+            candidates = std::make_shared<const std::vector<size_t>>(std::move(rows));
+            post([number = job->number, candidates](SortFilterProxyAdapter &adapter) {
+                adapter.apply_order(number, candidates);
+            });
+        } else {
+            candidates = std::make_shared<const std::vector<size_t>>(std::move(rows));
+        }
+    }
+
+    // Each round checks one chunk per worker, then posts them in order
+    auto &rows = *candidates;
+    auto chunk_size = job->chunk_size;
+    auto chunk_count = std::max((rows.size() + chunk_size - 1) / chunk_size, size_t(1));
+    auto chunks_per_round = std::max(pool.size(), size_t(1));
+    for (size_t first_chunk = 0; first_chunk < chunk_count; first_chunk += chunks_per_round) {
+        if (job->is_cancelled()) {
+            return;
+        }
+        auto round = std::min(chunks_per_round, chunk_count - first_chunk);
+        auto results = std::vector<std::vector<size_t>>(round);
+        pool.parallel_for(round, [&](size_t i) {
+            auto first = (first_chunk + i) * chunk_size;
+            auto last = std::min(first + chunk_size, rows.size());
+            auto &source = *job->source;
+            auto &passed = results[i];
+            for (auto row = first; row < last; row++) {
+                if (job->filter.empty() || job->matches(source.get_text(rows[row]), job->filter)) {
+                    passed.push_back(rows[row]);
+                }
+            }
+        });
+
+        for (size_t i = 0; i < round; i++) {
+            auto first = (first_chunk + i) * chunk_size;
+            auto checked = std::min(first + chunk_size, rows.size()) - std::min(first, rows.size());
+            auto is_last = first_chunk + i + 1 == chunk_count;
+            post([number = job->number, checked, passed = std::move(results[i]),
+                  is_last](SortFilterProxyAdapter &adapter) mutable {
+                adapter.apply_chunk(number, checked, std::move(passed), is_last);
+            });
+        }
+    }
+}
+
+auto SortFilterProxyAdapter::apply_order(uint64_t job,
+                                         std::shared_ptr<const std::vector<size_t>> new_order)
+    -> void {
+    if (job == *current_job) {
+        order = new_order;
+    }
+}
+
+auto SortFilterProxyAdapter::apply_chunk(uint64_t job, size_t checked, std::vector<size_t> passed,
+                                         bool is_last) -> void {
+    if (job != *current_job) {
+        return;
+    }
+    if (replace_on_first_chunk) {
+        replace_on_first_chunk = false;
+        passed_rows.clear();
+        pending_rows.reset();
+        pending_first = 0;
+        reset();
+    }
+
+    auto position = passed_rows.size();
+    passed_rows.insert(passed_rows.end(), passed.begin(), passed.end());
+    if (pending_rows) {
+        // The checked rows are replaced by those which passed
+        pending_first += checked;
+        rows_removed(position + passed.size(), checked - passed.size());
+        rows_changed(position, passed.size());
+    } else {
+        rows_inserted(position, passed.size());
+    }
+
+    if (is_last) {
+        pending_rows.reset();
+        pending_first = 0;
+        is_complete = true;
+    }
+}
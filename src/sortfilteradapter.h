@@ -0,0 +1,102 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <listview.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Platform;
+
+// Shows the rows of another adapter sorted and filtered, through a permutation of its indices.
+// Sorting and filtering run on the thread pool of the platform, results are posted back to the
+// UI thread in chunks and shown as they arrive. A filter which contains the previous one only
+// checks again the rows which passed it.
+//
+// Rows are compared and matched by `get_text()` of the source, from worker threads. The source
+// must not change while a job runs, call `refresh()` after changing it. This adapter must be
+// owned by a `std::shared_ptr`, results for an adapter which was destroyed are dropped.
+struct SortFilterProxyAdapter : ItemAdapter,
+                                std::enable_shared_from_this<SortFilterProxyAdapter> {
+    enum class SortOrder {
+        None,
+        Ascending,
+        Descending,
+    };
+
+    using Less = std::function<bool(std::string_view, std::string_view)>;
+    using Matches = std::function<bool(std::string_view text, std::string_view filter)>;
+
+    SortFilterProxyAdapter(std::shared_ptr<ItemAdapter> source, Platform &platform);
+    virtual ~SortFilterProxyAdapter();
+
+    virtual auto get_count() const -> size_t override;
+    virtual auto get_widget(size_t position, Theme &theme) -> PWidget override;
+    virtual auto set_content(PWidget widget, size_t position, ItemStatus status) -> void override;
+    virtual auto get_item_height(size_t position, Theme &theme) -> int override;
+    virtual auto has_uniform_height() const -> bool override;
+    virtual auto get_view_type(size_t position) const -> int override;
+    virtual auto get_text(size_t position) const -> std::string_view override;
+
+    auto map_to_source(size_t position) const -> size_t;
+    auto get_source() const -> std::shared_ptr<ItemAdapter> { return source; }
+
+    auto set_sort_order(SortOrder order) -> void;
+    auto set_filter(std::string_view text) -> void;
+    auto get_filter() const -> std::string_view { return filter; }
+
+    // Sorts and filters all the rows of the source again
+    auto refresh() -> void;
+
+    // True until the last chunk of the running job is shown
+    auto is_busy() const -> bool { return !is_complete; }
+
+    // Both are called from worker threads. Matching must keep working for narrowed filters:
+    // a text which matches a filter must also match every part of it.
+    Less less;
+    Matches matches;
+
+    // Rows checked per task, each one is posted to the UI thread when done
+    size_t chunk_size = 4096;
+
+  private:
+    struct Job;
+    auto start(bool sort) -> void;
+    auto make_job() -> std::shared_ptr<Job>;
+    static auto run(std::shared_ptr<Job> job) -> void;
+    auto apply_order(uint64_t job, std::shared_ptr<const std::vector<size_t>> new_order) -> void;
+    auto apply_chunk(uint64_t job, size_t checked, std::vector<size_t> passed, bool is_last)
+        -> void;
+
+    std::shared_ptr<ItemAdapter> source;
+    Platform &platform;
+    SortOrder sort_order = SortOrder::None;
+    std::string filter;
+
+    // The sorted source, null while not sorted
+    std::shared_ptr<const std::vector<size_t>> order;
+
+    // Rows shown are the rows which passed so far, followed by the rows still to be checked
+    // again while narrowing a filter
+    std::vector<size_t> passed_rows;
+    std::shared_ptr<const std::vector<size_t>> pending_rows;
+    size_t pending_first = 0;
+
+    // The rows shown before a new job are kept until its first chunk arrives
+    bool replace_on_first_chunk = false;
+    bool is_complete = true;
+
+    // Jobs stop when this no longer matches their own number
+    std::shared_ptr<std::atomic<uint64_t>> current_job = std::make_shared<std::atomic<uint64_t>>(0);
+};
@@ -0,0 +1,127 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "stringpooladapter.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+StringPoolAdapter::StringPoolAdapter(std::string text, ThreadPool *pool)
+    : owned_text(std::move(text)) {
+    this->text = owned_text;
+    split_lines(pool);
+}
+
+StringPoolAdapter::StringPoolAdapter(const std::vector<std::string> &strings) {
+    auto size = size_t(0);
+    for (auto &s : strings) {
+        size += s.size() + 1;
+    }
+    owned_text.reserve(size);
+    line_starts.reserve(strings.size() + 1);
+    for (auto &s : strings) {
+        owned_text += s;
+        owned_text += '\n';
+        line_starts.push_back(owned_text.size());
+    }
+    text = owned_text;
+}
+
+auto StringPoolAdapter::open(const std::string_view file_name, ThreadPool *pool)
+    -> std::shared_ptr<StringPoolAdapter> {
+    auto adapter = std::shared_ptr<StringPoolAdapter>(new StringPoolAdapter());
+    if (!adapter->file.open(file_name)) {
+        return {};
+    }
+    adapter->text = adapter->file.get_data();
+    adapter->split_lines(pool);
+    return adapter;
+}
+
+// Each part counts its lines, then writes their starts at its place in the index. Reading
+// the text twice is cheaper than keeping a copy of the index for every part.
+auto StringPoolAdapter::split_lines(ThreadPool *pool) -> void {
+    constexpr size_t min_part_size = 1 << 20;
+    auto size = text.size();
+    auto parts = size_t(1);
+    if (pool != nullptr) {
+        parts = std::max(std::min(pool->size() * 4, size / min_part_size), size_t(1));
+    }
+    auto bounds = std::vector<size_t>(parts + 1);
+    for (size_t i = 0; i <= parts; i++) {
+        bounds[i] = size * i / parts;
+    }
+
+    auto for_each_line_end = [this, &bounds](size_t part, auto callback) {
+        auto data = text.data();
+        auto position = bounds[part];
+        auto last = bounds[part + 1];
+        while (position < last) {
+            auto found =
+                static_cast<const char *>(std::memchr(data + position, '\n', last - position));
+            if (found == nullptr) {
+                break;
+            }
+            position = static_cast<size_t>(found - data) + 1;
+            callback(position);
+        }
+    };
+    auto run = [pool, parts](const std::function<void(size_t)> &task) {
+        if (pool != nullptr && parts > 1) {
+            pool->parallel_for(parts, task);
+        } else {
+            task(0);
+        }
+    };
+
+    auto counts = std::vector<size_t>(parts + 1);
+    run([&](size_t part) {
+        auto count = size_t(0);
+        for_each_line_end(part, [&count](size_t) { count++; });
+        counts[part + 1] = count;
+    });
+    for (size_t i = 1; i <= parts; i++) {
+        counts[i] += counts[i - 1];
+    }
+
+    // A last line without a newline ends after the text, as if it had one
+    auto has_last_line = size != 0 && text.back() != '\n';
+    line_starts.resize(1 + counts[parts] + (has_last_line ? 1 : 0));
+    line_starts[0] = 0;
+    run([&](size_t part) {
+        auto index = counts[part] + 1;
+        for_each_line_end(part, [&](size_t position) { line_starts[index++] = position; });
+    });
+    if (has_last_line) {
+        line_starts.back() = size + 1;
+    }
+}
+
+auto StringPoolAdapter::get_text(size_t position) const -> std::string_view {
+    auto first = line_starts[position];
+    auto last = line_starts[position + 1] - 1;
+    if (last > first && text[last - 1] == '\r') {
+        last--;
+    }
+    return text.substr(first, last - first);
+}
+
+auto StringPoolAdapter::get_widget(size_t /*position*/, Theme &theme) -> PWidget {
+    return ListItemWidget::create(theme);
+}
+
+auto StringPoolAdapter::get_item_height(size_t /*position*/, Theme &theme) -> int {
+    return ListItemWidget::get_height(theme);
+}
+
+auto StringPoolAdapter::set_content(PWidget widget, size_t position, ItemStatus status) -> void {
+    auto item = std::dynamic_pointer_cast<ListItemWidget>(widget);
+    item->text = get_text(position);
+    item->status = status;
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <listview.h>
+#include <mappedfile.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ThreadPool;
+
+// Shows the lines of a text, kept as one block of bytes and the offset of each line. Rows cost
+// 8 bytes on top of their text, and are given to the widgets as views into the block. The text
+// can be a mapped file, so a huge file costs about its own size, paged in by the OS.
+//
+// The text cannot change after construction. Lines end in "\n" or "\r\n".
+struct StringPoolAdapter : ItemAdapter {
+    // Lines are split on the workers of `pool` when given
+    explicit StringPoolAdapter(std::string text, ThreadPool *pool = nullptr);
+    explicit StringPoolAdapter(const std::vector<std::string> &strings);
+
+    // Returns null when the file cannot be read
+    static auto open(const std::string_view file_name, ThreadPool *pool = nullptr)
+        -> std::shared_ptr<StringPoolAdapter>;
+
+    virtual auto get_count() const -> size_t override { return line_starts.size() - 1; }
+    virtual auto get_widget(size_t position, Theme &theme) -> PWidget override;
+    virtual auto set_content(PWidget widget, size_t position, ItemStatus status) -> void override;
+    virtual auto get_item_height(size_t position, Theme &theme) -> int override;
+    virtual auto get_text(size_t position) const -> std::string_view override;
+
+  private:
+    StringPoolAdapter() = default;
+    auto split_lines(ThreadPool *pool) -> void;
+
+    std::string owned_text;
+    MappedFile file;
+    std::string_view text;
+
+    // Where each line starts, followed by the start of a line after the last one
+    std::vector<uint64_t> line_starts = {0};
+};
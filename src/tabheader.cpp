@@ -20,6 +20,9 @@ auto TabHeader::add_tab(const std::string_view name) -> int {
 
 auto TabHeader::remove_tab(int index) -> void {
     this->names.erase(this->names.begin() + index);
+    if (index < static_cast<int>(text_runs.size())) {
+        this->text_runs.erase(this->text_runs.begin() + index);
+    }
     this->needs_redraw = true;
 }
 
@@ -44,8 +47,8 @@ auto TabHeader::get_tab_string(int index) const -> std::string_view {
 auto TabHeader::draw() -> void {
     auto my_theme = get_theme();
     auto hover_tab_index = mouse_over ? hover_tab : -1;
-    tab_offset =
-        my_theme->draw_tabs(content, has_focus, active_tab, hover_tab_index, get_padding(), names);
+    tab_offset = my_theme->draw_tabs(content, has_focus, active_tab, hover_tab_index,
+                                     get_padding(), names, cache_text ? &text_runs : nullptr);
 }
 
 auto TabHeader::on_mouse_click(const EventMouse &event) -> EventPropagation {
@@ -13,6 +13,9 @@ struct TabHeader : Widget {
     std::vector<std::string> names;
     std::function<void(TabHeader &, int)> on_item_selected = {};
 
+    // Keep the rendered tab names between redraws
+    bool cache_text = false;
+
     TabHeader();
 
     auto add_tab(const std::string_view name) -> int;
@@ -28,6 +31,7 @@ struct TabHeader : Widget {
 
   private:
     std::vector<TabHeaderOffsets> tab_offset;
+    std::vector<TextRun> text_runs;
 
     int active_tab = 0;
     int hover_tab = -1;
@@ -0,0 +1,636 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "tableview.h"
+#include "scrollbar.h"
+#include "theme.h"
+
+#include <algorithm>
+
+// Scroll bars work with int values, longer ranges are mapped onto them proportionally
+static constexpr int64_t max_scrollbar_value = 1 << 30;
+
+static auto to_scrollbar(int64_t offset, int64_t max_offset) -> int {
+    if (max_offset <= max_scrollbar_value) {
+        return static_cast<int>(offset);
+    }
+    return static_cast<int>(static_cast<double>(offset) * max_scrollbar_value / max_offset);
+}
+
+static auto from_scrollbar(int value, int64_t max_offset) -> int64_t {
+    if (max_offset <= max_scrollbar_value) {
+        return value;
+    }
+    if (value >= max_scrollbar_value) {
+        return max_offset;
+    }
+    return static_cast<int64_t>(static_cast<double>(value) * max_offset / max_scrollbar_value);
+}
+
+auto TableAdapter::get_column_width(size_t /*column*/, Theme &theme) -> int {
+    return theme.font->text_size("X").width * 12 +
+           theme.get_padding(PaddingStyle::Label).get_horizontal();
+}
+
+auto TableAdapter::draw_cell(Bitmap &content, size_t row, size_t column, ItemStatus status,
+                             Theme &theme) -> void {
+    theme.draw_listview_item(content, get_cell_text(row, column), status, false);
+}
+
+auto TableAdapter::get_widget(size_t /*position*/, Theme &theme) -> PWidget {
+    return ListItemWidget::create(theme);
+}
+
+auto TableAdapter::set_content(PWidget widget, size_t position, ItemStatus status) -> void {
+    auto item = std::dynamic_pointer_cast<ListItemWidget>(widget);
+    item->text = get_cell_text(position, 0);
+    item->status = status;
+}
+
+auto TableAdapter::get_item_height(size_t /*position*/, Theme &theme) -> int {
+    return ListItemWidget::get_height(theme);
+}
+
+TableView::TableView() : TableView({}, {}) {}
+
+TableView::TableView(Position position, Size size) : Widget(position, size, 0) {
+    this->vertical_scrollbar = add_new<ScrollBar>(Position{0, 0}, size.height, false);
+    this->vertical_scrollbar->did_change = [this](auto *, int value) {
+        if (value != to_scrollbar(scroll_y, max_scroll_y)) {
+            scroll_y = from_scrollbar(value, max_scroll_y);
+        }
+        this->invalidate();
+    };
+    this->horizontal_scrollbar = add_new<ScrollBar>(Position{0, 0}, size.width, true);
+    this->horizontal_scrollbar->did_change = [this](auto *, int value) {
+        if (value != to_scrollbar(scroll_x, max_scroll_x)) {
+            scroll_x = from_scrollbar(value, max_scroll_x);
+        }
+        this->invalidate();
+    };
+
+    // Cells cover the whole view, the theme only draws the frame
+    this->draw_background = false;
+    this->can_focus = true;
+    this->frame = {FrameStyles::Reversed, FrameSize::SingleFrame};
+}
+
+TableView::~TableView() {
+    if (auto observed = observed_adapter.lock()) {
+        observed->remove_observer(this);
+    }
+}
+
+auto TableView::draw() -> void {
+    // Without an adapter nothing covers the background
+    auto t = get_theme();
+    t->draw_listview_background(content, has_focus, !adapter);
+    if (adapter) {
+        update_metrics();
+        if (needs_scroll_range) {
+            update_scroll_range();
+        }
+        update_header(*t);
+        update_cells(*t);
+        content.blit({0, 0}, header, {0, 0}, header.size);
+        content.blit({0, header_height}, viewport, {0, 0}, viewport.size);
+    }
+
+    for (auto &scrollbar : {vertical_scrollbar, horizontal_scrollbar}) {
+        scrollbar->draw_if_needed();
+        content.draw(scrollbar->position, scrollbar->content);
+    }
+    auto corner = Position{vertical_scrollbar->position.x, horizontal_scrollbar->position.y};
+    content.fill_rect(corner.x, corner.y, content.size.width - corner.x,
+                      content.size.height - corner.y, t->colors.window_background);
+
+    auto frame_proxy = this->frame;
+    if (can_focus && t->modify_frame_on_hover()) {
+        if (frame_proxy.style == FrameStyles::Normal ||
+            frame_proxy.style == FrameStyles::Reversed) {
+            if (this->has_focus || this->mouse_over) {
+                frame_proxy.style = FrameStyles::Hover;
+            }
+        }
+    }
+    if (frame_proxy.style != FrameStyles::NoFrame) {
+        t->draw_frame(content, {0, 0}, content.size, frame_proxy.style, frame_proxy.size);
+    }
+}
+
+auto TableView::update_metrics() -> void {
+    auto t = get_theme();
+    auto is_new_adapter = measured_adapter != adapter.get();
+    if (measured_theme == t && !is_new_adapter) {
+        return;
+    }
+    if (is_new_adapter) {
+        observe_adapter();
+        row_count = adapter->get_count();
+
+        // Columns of the same width as the first one cost no memory
+        auto column_width = [this, t](size_t column) {
+            return std::max(adapter->get_column_width(column, *t), minimum_column_width);
+        };
+        auto column_count = adapter->get_column_count();
+        column_widths.reset(column_count, column_count == 0 ? 0 : column_width(0));
+        for (size_t column = 1; column < column_count; column++) {
+            auto width = column_width(column);
+            if (width != column_widths.get_height(column)) {
+                column_widths.set_height(column, width);
+            }
+        }
+    }
+    row_height = std::max(adapter->get_item_height(0, *t), 1);
+    header_height = row_height;
+    measured_theme = t;
+    measured_adapter = adapter.get();
+    needs_scroll_range = true;
+    needs_full_redraw = true;
+    header_x = -1;
+}
+
+auto TableView::get_viewport_size() const -> Size {
+    auto width = content.size.width - vertical_scrollbar->content.size.width;
+    auto height =
+        content.size.height - header_height - horizontal_scrollbar->content.size.height;
+    return {std::max(width, 0), std::max(height, 0)};
+}
+
+auto TableView::update_scroll_range() -> void {
+    needs_scroll_range = false;
+    auto size = get_viewport_size();
+    max_scroll_x = std::max(column_widths.total_height() - size.width, int64_t(0));
+    auto total_height = static_cast<int64_t>(row_count) * row_height;
+    max_scroll_y = std::max(total_height - size.height, int64_t(0));
+    scroll_x = std::min(scroll_x, max_scroll_x);
+    scroll_y = std::min(scroll_y, max_scroll_y);
+
+    auto step = std::max(to_scrollbar(row_height, max_scroll_y), 1);
+    auto page = std::max(to_scrollbar(size.height, max_scroll_y), 1);
+    vertical_scrollbar->set_values(0, to_scrollbar(max_scroll_y, max_scroll_y),
+                                   to_scrollbar(scroll_y, max_scroll_y), step, page);
+    step = std::max(to_scrollbar(row_height, max_scroll_x), 1);
+    page = std::max(to_scrollbar(size.width, max_scroll_x), 1);
+    horizontal_scrollbar->set_values(0, to_scrollbar(max_scroll_x, max_scroll_x),
+                                     to_scrollbar(scroll_x, max_scroll_x), step, page);
+}
+
+auto TableView::update_header(Theme &theme) -> void {
+    auto width = get_viewport_size().width;
+    if (header.size.width != width || header.size.height != header_height) {
+        header.resize(width, header_height);
+        header_x = -1;
+    }
+    if (header_x == scroll_x && painted_hover_column == hover_column && !needs_full_redraw) {
+        return;
+    }
+    header_x = scroll_x;
+    painted_hover_column = hover_column;
+
+    header.fill(theme.colors.window_background);
+    auto column_count = column_widths.size();
+    if (column_count == 0) {
+        return;
+    }
+    for (auto column = column_widths.row_at(scroll_x); column < column_count; column++) {
+        auto x = column_widths.offset_of(column) - scroll_x;
+        if (x >= width) {
+            break;
+        }
+        cell.resize(column_widths.get_height(column), header_height);
+        theme.draw_table_header(cell, adapter->get_column_title(column),
+                                static_cast<int>(column) == hover_column);
+        header.blit({static_cast<int>(x), 0}, cell, {0, 0}, cell.size);
+    }
+}
+
+auto TableView::update_cells(Theme &theme) -> void {
+    auto size = get_viewport_size();
+    if (viewport.size != size) {
+        viewport.resize(size);
+        needs_full_redraw = true;
+    }
+
+    // The current row is highlighted, rows it moved from and to are drawn again
+    if (painted_current_row != current_row) {
+        if (painted_current_row >= 0) {
+            mark_dirty(painted_current_row, painted_current_row + 1);
+        }
+        mark_dirty(current_row, current_row + 1);
+        painted_current_row = current_row;
+    }
+
+    auto dx = scroll_x - viewport_x;
+    auto dy = scroll_y - viewport_y;
+    if (std::abs(dx) >= size.width || std::abs(dy) >= size.height) {
+        needs_full_redraw = true;
+    }
+    viewport_x = scroll_x;
+    viewport_y = scroll_y;
+
+    if (needs_full_redraw) {
+        draw_cells(theme, {0, 0}, size);
+    } else {
+        // Pixels still valid are moved, the strips scrolled into view are drawn
+        auto delta_x = static_cast<int>(dx);
+        auto delta_y = static_cast<int>(dy);
+        viewport.scroll_vertically(delta_y);
+        viewport.scroll_horizontally(delta_x);
+        if (delta_y > 0) {
+            draw_cells(theme, {0, size.height - delta_y}, {size.width, delta_y});
+        } else if (delta_y < 0) {
+            draw_cells(theme, {0, 0}, {size.width, -delta_y});
+        }
+        if (delta_x > 0) {
+            draw_cells(theme, {size.width - delta_x, 0}, {delta_x, size.height});
+        } else if (delta_x < 0) {
+            draw_cells(theme, {0, 0}, {-delta_x, size.height});
+        }
+
+        if (dirty_first < dirty_last && row_count != 0) {
+            auto first_visible = static_cast<size_t>(scroll_y / row_height);
+            auto last_visible = static_cast<size_t>((scroll_y + size.height) / row_height) + 1;
+            auto first = std::max(dirty_first, first_visible);
+            auto last = std::min(dirty_last, last_visible);
+            if (first < last) {
+                auto y = static_cast<int64_t>(first) * row_height - scroll_y;
+                auto height = static_cast<int64_t>(last - first) * row_height;
+                auto top = static_cast<int>(std::max(y, int64_t(0)));
+                auto bottom = static_cast<int>(std::min(y + height, int64_t(size.height)));
+                draw_cells(theme, {0, top}, {size.width, bottom - top});
+            }
+        }
+    }
+    needs_full_redraw = false;
+    dirty_first = 0;
+    dirty_last = 0;
+}
+
+auto TableView::draw_cells(Theme &theme, Position position, Size size) -> void {
+    auto right = std::min(position.x + size.width, viewport.size.width);
+    auto bottom = std::min(position.y + size.height, viewport.size.height);
+    position.x = std::max(position.x, 0);
+    position.y = std::max(position.y, 0);
+    if (right <= position.x || bottom <= position.y) {
+        return;
+    }
+    viewport.fill_rect(position.x, position.y, right - position.x, bottom - position.y,
+                       theme.colors.input_background_normal);
+
+    auto column_count = column_widths.size();
+    if (row_count == 0 || column_count == 0) {
+        return;
+    }
+    auto first_row = static_cast<size_t>((scroll_y + position.y) / row_height);
+    auto first_column = column_widths.row_at(scroll_x + position.x);
+    for (auto row = first_row; row < row_count; row++) {
+        auto y = static_cast<int>(static_cast<int64_t>(row) * row_height - scroll_y);
+        if (y >= bottom) {
+            break;
+        }
+        auto status = ItemStatus{};
+        status.is_active = static_cast<int>(row) == current_row;
+        status.is_selected = status.is_active;
+        for (auto column = first_column; column < column_count; column++) {
+            auto x = static_cast<int>(column_widths.offset_of(column) - scroll_x);
+            if (x >= right) {
+                break;
+            }
+            cell.resize(column_widths.get_height(column), row_height);
+            adapter->draw_cell(cell, row, column, status, theme);
+
+            // Only the requested pixels are copied, the ones around them are still valid
+            auto from = Position{std::max(x, position.x), std::max(y, position.y)};
+            auto to = Position{std::min(x + cell.size.width, right),
+                               std::min(y + row_height, bottom)};
+            viewport.blit(from, cell, {from.x - x, from.y - y}, {to.x - from.x, to.y - from.y});
+        }
+    }
+}
+
+auto TableView::column_at(int x) const -> int {
+    auto offset = scroll_x + x;
+    if (column_widths.size() == 0 || offset < 0 || offset >= column_widths.total_height()) {
+        return -1;
+    }
+    return static_cast<int>(column_widths.row_at(offset));
+}
+
+auto TableView::resize_handle_at(int x) const -> int {
+    auto column = column_at(x);
+    if (column < 0) {
+        column = static_cast<int>(column_widths.size()) - 1;
+    }
+    if (column < 0) {
+        return -1;
+    }
+    auto offset = scroll_x + x;
+    if (std::abs(column_widths.offset_of(column + 1) - offset) <= resize_handle_width) {
+        return column;
+    }
+    if (column > 0 && std::abs(offset - column_widths.offset_of(column)) <= resize_handle_width) {
+        return column - 1;
+    }
+    return -1;
+}
+
+auto TableView::on_hover(const EventMouse &event) -> void {
+    Widget::on_hover(event);
+    if (!adapter) {
+        return;
+    }
+    if (resizing_column >= 0) {
+        set_column_width(resizing_column, resize_start_width + event.x - resize_start_x);
+        return;
+    }
+
+    auto column = -1;
+    if (event.y < header_height && event.x < get_viewport_size().width) {
+        column = column_at(event.x);
+    }
+    if (column != hover_column) {
+        hover_column = column;
+        invalidate();
+    }
+}
+
+auto TableView::on_mouse_leave() -> void {
+    hover_column = -1;
+    Widget::on_mouse_leave();
+}
+
+auto TableView::on_mouse_click(const EventMouse &event) -> EventPropagation {
+    if (event.button == mouse_wheel_up || event.button == mouse_wheel_down) {
+        if (event.pressed) {
+            auto delta = int64_t(row_height) * wheel_rows;
+            delta = event.button == mouse_wheel_up ? -delta : delta;
+            if (event.is_shift_pressed()) {
+                set_scroll_offset(scroll_x + delta, scroll_y);
+            } else {
+                set_scroll_offset(scroll_x, scroll_y + delta);
+            }
+        }
+        return EventPropagation::handled;
+    }
+
+    if (!event.pressed) {
+        resizing_column = -1;
+        return Widget::on_mouse(event);
+    }
+
+    auto p = Widget::on_mouse_click(event);
+    if (p == EventPropagation::handled || !adapter) {
+        return p;
+    }
+
+    auto size = get_viewport_size();
+    if (event.x >= size.width || event.y >= header_height + size.height) {
+        return EventPropagation::propagate;
+    }
+    if (event.y < header_height) {
+        resizing_column = resize_handle_at(event.x);
+        if (resizing_column >= 0) {
+            resize_start_x = event.x;
+            resize_start_width = get_column_width(resizing_column);
+        }
+        return EventPropagation::handled;
+    }
+
+    auto row = (scroll_y + event.y - header_height) / row_height;
+    if (row >= static_cast<int64_t>(row_count)) {
+        return EventPropagation::handled;
+    }
+    current_row = static_cast<int>(row);
+    ensure_row_visible(current_row);
+    invalidate();
+    if (on_row_selected) {
+        on_row_selected(*this, current_row);
+    }
+    return EventPropagation::handled;
+}
+
+auto TableView::on_keyboard(const EventKeyboard &event) -> EventPropagation {
+    if (!adapter) {
+        return EventPropagation::propagate;
+    }
+    update_metrics();
+    auto last_row = std::max(static_cast<int>(row_count) - 1, 0);
+    auto page_rows = std::max(get_viewport_size().height / row_height, 1);
+    auto old_row = current_row;
+    switch (event.key) {
+    case KeyCodes::ArrowDown:
+        current_row = std::min(current_row + 1, last_row);
+        break;
+    case KeyCodes::ArrowUp:
+        current_row = std::max(current_row - 1, 0);
+        break;
+    case KeyCodes::PageDown:
+        current_row = std::min(current_row + page_rows, last_row);
+        break;
+    case KeyCodes::PageUp:
+        current_row = std::max(current_row - page_rows, 0);
+        break;
+    case KeyCodes::Home:
+        current_row = 0;
+        break;
+    case KeyCodes::End:
+        current_row = last_row;
+        break;
+    case KeyCodes::ArrowLeft:
+        set_scroll_offset(scroll_x - int64_t(row_height) * wheel_rows, scroll_y);
+        return EventPropagation::handled;
+    case KeyCodes::ArrowRight:
+        set_scroll_offset(scroll_x + int64_t(row_height) * wheel_rows, scroll_y);
+        return EventPropagation::handled;
+    default:
+        return EventPropagation::propagate;
+    }
+
+    if (old_row != current_row) {
+        ensure_row_visible(current_row);
+        invalidate();
+        if (on_row_selected) {
+            on_row_selected(*this, current_row);
+        }
+    }
+    return EventPropagation::handled;
+}
+
+auto TableView::on_resize() -> void {
+    auto bar_size = vertical_scrollbar->get_padding().get_horizontal();
+    auto width = std::max(content.size.width - bar_size, 0);
+    auto height = std::max(content.size.height - bar_size, 0);
+    vertical_scrollbar->position = {width, 0};
+    vertical_scrollbar->content.resize(bar_size, height);
+    vertical_scrollbar->on_resize();
+    horizontal_scrollbar->position = {0, height};
+    horizontal_scrollbar->content.resize(width, bar_size);
+    horizontal_scrollbar->on_resize();
+    needs_scroll_range = true;
+    needs_full_redraw = true;
+}
+
+auto TableView::on_theme_changed() -> void {
+    // Row heights depend on the font, they are measured again on the next draw
+    measured_theme = nullptr;
+    needs_full_redraw = true;
+}
+
+auto TableView::did_adapter_update() -> void {
+    if (measured_adapter == adapter.get() && adapter) {
+        row_count = adapter->get_count();
+        if (column_widths.size() != adapter->get_column_count()) {
+            measured_adapter = nullptr;
+        }
+    }
+    current_row = std::clamp(current_row, 0, std::max(static_cast<int>(row_count) - 1, 0));
+    needs_scroll_range = true;
+    needs_full_redraw = true;
+    invalidate();
+}
+
+auto TableView::get_column_width(size_t column) -> int {
+    update_metrics();
+    return column < column_widths.size() ? column_widths.get_height(column) : 0;
+}
+
+auto TableView::set_column_width(size_t column, int width) -> void {
+    update_metrics();
+    width = std::max(width, minimum_column_width);
+    if (column >= column_widths.size() || column_widths.get_height(column) == width) {
+        return;
+    }
+    column_widths.set_height(column, width);
+    needs_scroll_range = true;
+    needs_full_redraw = true;
+    invalidate();
+}
+
+auto TableView::set_scroll_offset(int64_t x, int64_t y) -> void {
+    x = std::clamp(x, int64_t(0), max_scroll_x);
+    y = std::clamp(y, int64_t(0), max_scroll_y);
+    if (x == scroll_x && y == scroll_y) {
+        return;
+    }
+    scroll_x = x;
+    scroll_y = y;
+    vertical_scrollbar->set_value(to_scrollbar(scroll_y, max_scroll_y));
+    horizontal_scrollbar->set_value(to_scrollbar(scroll_x, max_scroll_x));
+    invalidate();
+}
+
+auto TableView::ensure_row_visible(size_t row) -> void {
+    update_metrics();
+    if (needs_scroll_range) {
+        update_scroll_range();
+    }
+    auto top = static_cast<int64_t>(row) * row_height;
+    auto bottom = top + row_height;
+    auto height = get_viewport_size().height;
+    if (top < scroll_y) {
+        set_scroll_offset(scroll_x, top);
+    } else if (bottom > scroll_y + height) {
+        set_scroll_offset(scroll_x, bottom - height);
+    }
+}
+
+auto TableView::observe_adapter() -> void {
+    auto previous = observed_adapter.lock();
+    if (previous == adapter) {
+        return;
+    }
+    if (previous) {
+        previous->remove_observer(this);
+    }
+    if (adapter) {
+        adapter->add_observer(this);
+    }
+    observed_adapter = adapter;
+}
+
+auto TableView::mark_dirty(size_t first, size_t last) -> void {
+    if (first >= last) {
+        return;
+    }
+    if (dirty_first >= dirty_last) {
+        dirty_first = first;
+        dirty_last = last;
+        return;
+    }
+    dirty_first = std::min(dirty_first, first);
+    dirty_last = std::max(dirty_last, last);
+}
+
+auto TableView::on_rows_inserted(size_t first, size_t count) -> void {
+    if (count == 0) {
+        return;
+    }
+    if (measured_adapter != adapter.get() || row_count + count != adapter->get_count()) {
+        on_reset();
+        return;
+    }
+
+    // Rows inserted above the view push its content down, the view moves along
+    first = std::min(first, row_count);
+    auto top = static_cast<size_t>(scroll_y / row_height);
+    if (first <= top && scroll_y > 0) {
+        auto height = static_cast<int64_t>(count) * row_height;
+        scroll_y += height;
+        viewport_y += height;
+    } else {
+        mark_dirty(first, row_count + count);
+    }
+    if (row_count != 0 && static_cast<size_t>(current_row) >= first) {
+        current_row += static_cast<int>(count);
+        painted_current_row += static_cast<int>(count);
+    }
+    row_count += count;
+    needs_scroll_range = true;
+    invalidate();
+}
+
+auto TableView::on_rows_removed(size_t first, size_t count) -> void {
+    if (count == 0 || first >= row_count) {
+        return;
+    }
+    count = std::min(count, row_count - first);
+    if (measured_adapter != adapter.get() || row_count - count != adapter->get_count()) {
+        on_reset();
+        return;
+    }
+
+    auto top = static_cast<size_t>(scroll_y / row_height);
+    if (first + count <= top && scroll_y > 0) {
+        auto height = static_cast<int64_t>(count) * row_height;
+        scroll_y -= height;
+        viewport_y -= height;
+    } else {
+        mark_dirty(first, row_count);
+    }
+    row_count -= count;
+
+    auto row = static_cast<size_t>(current_row);
+    if (row >= first + count) {
+        current_row -= static_cast<int>(count);
+        painted_current_row -= static_cast<int>(count);
+    } else if (row >= first) {
+        current_row = static_cast<int>(row_count == 0 ? 0 : std::min(first, row_count - 1));
+    }
+    needs_scroll_range = true;
+    invalidate();
+}
+
+auto TableView::on_rows_changed(size_t first, size_t count) -> void {
+    if (first >= row_count) {
+        return;
+    }
+    mark_dirty(first, first + std::min(count, row_count - first));
+    invalidate();
+}
+
+auto TableView::on_reset() -> void { did_adapter_update(); }
@@ -0,0 +1,133 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <listview.h>
+#include <rowheights.h>
+
+#include <functional>
+#include <memory>
+#include <string_view>
+
+// Rows of cells. Rows are also items, so a table can be shown by list views and wrapped by
+// the sort and filter proxy, both see the text of the first column.
+struct TableAdapter : ItemAdapter {
+    virtual auto get_column_count() const -> size_t = 0;
+    virtual auto get_column_title(size_t column) const -> std::string_view = 0;
+    virtual auto get_cell_text(size_t row, size_t column) const -> std::string_view = 0;
+
+    // Width of a column until the user resizes it
+    virtual auto get_column_width(size_t column, Theme &theme) -> int;
+
+    // Renders one cell, `content` has the size of the cell
+    virtual auto draw_cell(Bitmap &content, size_t row, size_t column, ItemStatus status,
+                           Theme &theme) -> void;
+
+    virtual auto get_widget(size_t position, Theme &theme) -> PWidget override;
+    virtual auto set_content(PWidget widget, size_t position, ItemStatus status) -> void override;
+    virtual auto get_item_height(size_t position, Theme &theme) -> int override;
+    virtual auto get_text(size_t position) const -> std::string_view override {
+        return get_cell_text(position, 0);
+    }
+};
+
+// Shows a table adapter, scrolled in both directions. Only the cells on screen are drawn,
+// directly into the view without a widget per cell. When scrolling the pixels still valid are
+// moved, and only the strips scrolled into view are drawn, so the cost of a frame depends on
+// the size of the view and not on the size of the table. All rows have the same height.
+struct TableView : Widget, private ItemAdapterObserver {
+    std::shared_ptr<ScrollBar> vertical_scrollbar = {};
+    std::shared_ptr<ScrollBar> horizontal_scrollbar = {};
+    std::shared_ptr<TableAdapter> adapter = {};
+
+    std::function<void(TableView &, int row)> on_row_selected;
+    int current_row = 0;
+
+    TableView();
+    TableView(Position position, Size size);
+    virtual ~TableView();
+    virtual auto draw() -> void override;
+    virtual auto on_hover(const EventMouse &event) -> void override;
+    virtual auto on_mouse_leave() -> void override;
+    virtual auto on_mouse_click(const EventMouse &event) -> EventPropagation override;
+    virtual auto on_keyboard(const EventKeyboard &) -> EventPropagation override;
+    virtual auto on_resize() -> void override;
+    virtual auto on_theme_changed() -> void override;
+
+    // Same as `ItemAdapter::reset()`, for adapters which do not notify their changes
+    auto did_adapter_update() -> void;
+
+    // Columns are resized by dragging the right edge of their title
+    auto get_column_width(size_t column) -> int;
+    auto set_column_width(size_t column, int width) -> void;
+
+    auto get_horizontal_offset() const -> int64_t { return scroll_x; }
+    auto get_vertical_offset() const -> int64_t { return scroll_y; }
+    auto set_scroll_offset(int64_t x, int64_t y) -> void;
+    auto ensure_row_visible(size_t row) -> void;
+
+  private:
+    virtual auto on_rows_inserted(size_t first, size_t count) -> void override;
+    virtual auto on_rows_removed(size_t first, size_t count) -> void override;
+    virtual auto on_rows_changed(size_t first, size_t count) -> void override;
+    virtual auto on_reset() -> void override;
+    auto observe_adapter() -> void;
+
+    // Measures rows and columns when the theme or the adapter changes
+    auto update_metrics() -> void;
+    auto update_scroll_range() -> void;
+    auto mark_dirty(size_t first, size_t last) -> void;
+
+    // Draws the cells which cover the given pixels of the viewport
+    auto update_cells(Theme &theme) -> void;
+    auto draw_cells(Theme &theme, Position position, Size size) -> void;
+    auto update_header(Theme &theme) -> void;
+
+    auto get_viewport_size() const -> Size;
+    auto column_at(int x) const -> int;
+    auto resize_handle_at(int x) const -> int;
+
+    static constexpr int wheel_rows = 3;
+    static constexpr int resize_handle_width = 4;
+    static constexpr int minimum_column_width = 16;
+
+    std::weak_ptr<ItemAdapter> observed_adapter;
+    const Theme *measured_theme = nullptr;
+    const TableAdapter *measured_adapter = nullptr;
+    size_t row_count = 0;
+    int row_height = 0;
+    int header_height = 0;
+
+    // A prefix sum of the column widths, the columns are the rows of this
+    RowHeights column_widths;
+
+    int64_t scroll_x = 0;
+    int64_t scroll_y = 0;
+    int64_t max_scroll_x = 0;
+    int64_t max_scroll_y = 0;
+    bool needs_scroll_range = true;
+
+    Bitmap viewport;
+    Bitmap header;
+    Bitmap cell;
+    int64_t viewport_x = 0;
+    int64_t viewport_y = 0;
+    int64_t header_x = -1;
+    bool needs_full_redraw = true;
+    int painted_current_row = -1;
+
+    // Rows whose content changed, drawn again on the next frame
+    size_t dirty_first = 0;
+    size_t dirty_last = 0;
+
+    int hover_column = -1;
+    int painted_hover_column = -1;
+    int resizing_column = -1;
+    int resize_start_x = 0;
+    int resize_start_width = 0;
+};
@@ -40,7 +40,7 @@ auto TabWidget::set_buttons(std::shared_ptr<Button> start, std::shared_ptr<Butto
         start->window = window;
         top_layout->add(start);
         Widget::widgets.add(start, window);
-        start->parent = this;
+        start->set_parent(this);
     }
     top_layout->add(headers);
 
@@ -48,7 +48,7 @@ auto TabWidget::set_buttons(std::shared_ptr<Button> start, std::shared_ptr<Butto
         end->window = window;
         top_layout->add(end);
         Widget::widgets.add(end, window);
-        end->parent = this;
+        end->set_parent(this);
     }
     invalidate();
 }
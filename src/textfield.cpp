@@ -8,6 +8,7 @@
 #include "textfield.h"
 #include <spdlog/spdlog.h>
 #include <theme.h>
+#include <utf8.h>
 
 #include <spdlog/spdlog.h>
 
@@ -24,36 +25,62 @@ TextField::TextField(Position position, Size size) : Widget(position, size, 0) {
     this->can_focus = true;
     this->draw_background = false;
     this->frame = {FrameStyles::Reversed, FrameSize::SingleFrame};
-    this->mouse_cursor = MouseCursor::Edit;
+    set_cursor(MouseCursor::Edit);
 }
 
 TextField::~TextField() { timer.stop(); }
 
+// Longest prefix of `text` which fits in `width` pixels, ending on a code point boundary
+static auto fitting_prefix(FontProvider &font, std::string_view text, int width) -> size_t {
+    if (font.text_size(text).width <= width) {
+        return text.size();
+    }
+    auto low = size_t{0};
+    auto high = text.size();
+    while (utf8_next(text, low) < high) {
+        auto middle = (low + high) / 2;
+        while (middle > low && (static_cast<unsigned char>(text[middle]) & 0xC0) == 0x80) {
+            middle--;
+        }
+        if (middle == low) {
+            middle = utf8_next(text, low);
+        }
+        if (font.text_size(text.substr(0, middle)).width <= width) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
 auto TextField::draw() -> void {
-    theme->draw_input_background(content, has_focus);
+    auto my_theme = get_theme();
+    my_theme->draw_input_background(content, has_focus);
     Widget::draw();
 
-    auto text_size = theme->font->text_size(text);
+    auto text_size = my_theme->font->text_size(text);
     auto p = get_padding();
-
-    // TODO - we need to find where the text clips - properly
-    auto display_text_logical = (content.size.width - p.get_horizontal()) / 8;
-    auto display_text = this->text.substr(display_from, display_from + display_text_logical);
+    auto available_width = content.size.width - p.get_horizontal();
+    auto display_text = std::string_view(text).substr(display_from);
+    auto display_length = fitting_prefix(*my_theme->font, display_text, available_width);
+    display_text = display_text.substr(0, display_length);
     auto center_y = (content.size.height - text_size.height) / 2;
-    auto selection_width = (selection.end - selection.start) - display_from;
-    selection_width *= 8;
 
     // TODO - unmanaged color writing in a widget
-    // TODO handle partial selection
-    if (selection_width != 0) {
-        content.fill_rect(p.start, p.top, selection_width, content.size.height - p.get_vertical(),
-                          theme->colors.text_selection_background);
+    if (has_selection()) {
+        auto from = std::max(selection.start, display_from);
+        auto to = std::max(selection.end, display_from);
+        auto selection_x = p.start + text_width(display_from, from);
+        content.fill_rect(selection_x, p.top, text_width(from, to),
+                          content.size.height - p.get_vertical(),
+                          my_theme->colors.text_selection_background);
     }
-    theme->font->write(content, Position{p.start, center_y}, display_text,
-                       theme->colors.text_color);
+    my_theme->font->write(content, Position{p.start, center_y}, display_text,
+                          my_theme->colors.text_color);
 
     if (this->cursor_on && this->has_focus) {
-        auto position_x = p.start + (cursor_position - display_from) * 8;
+        auto position_x = p.start + text_width(display_from, cursor_position);
         content.draw_rectangle(position_x, p.top, 1, content.size.height - p.get_vertical(), 0, 0);
     }
 }
@@ -68,7 +95,7 @@ auto TextField::on_keyboard(const EventKeyboard &event) -> EventPropagation {
         if (cursor_position > 0) {
             // TODO - move to next word
             // TODO - change selection
-            cursor_position--;
+            cursor_position = utf8_prev(text, cursor_position);
             cursor_on = true;
             select_none();
             ensure_cursor_visible();
@@ -80,7 +107,7 @@ auto TextField::on_keyboard(const EventKeyboard &event) -> EventPropagation {
         if (cursor_position < text.length()) {
             // TODO - move to next word
             // TODO - change selection
-            cursor_position++;
+            cursor_position = utf8_next(text, cursor_position);
             cursor_on = true;
             select_none();
             ensure_cursor_visible();
@@ -109,9 +136,9 @@ auto TextField::on_keyboard(const EventKeyboard &event) -> EventPropagation {
         return EventPropagation::handled;
     case KeyCodes::Delete:
         if (has_selection()) {
-            text.erase(selection.start, selection.end);
+            text.erase(selection.start, selection.end - selection.start);
         } else {
-            text.erase(cursor_position, 1);
+            text.erase(cursor_position, utf8_next(text, cursor_position) - cursor_position);
         }
         cursor_on = true;
         ensure_cursor_visible();
@@ -121,15 +148,16 @@ auto TextField::on_keyboard(const EventKeyboard &event) -> EventPropagation {
         break;
     case KeyCodes::Backspace:
         if (has_selection()) {
-            text.erase(selection.start, selection.end);
+            text.erase(selection.start, selection.end - selection.start);
             cursor_on = true;
             ensure_cursor_visible();
             select_none();
             invalidate();
         } else {
             if (cursor_position > 0) {
-                text.erase(cursor_position - 1, 1);
-                cursor_position--;
+                auto previous = static_cast<int>(utf8_prev(text, cursor_position));
+                text.erase(previous, cursor_position - previous);
+                cursor_position = previous;
                 cursor_on = true;
                 ensure_cursor_visible();
                 select_none();
@@ -185,8 +213,7 @@ auto TextField::on_mouse_click(const EventMouse &event) -> EventPropagation {
         return EventPropagation::propagate;
     }
 
-    auto pos = (event.x - padding.start) / 8;
-    cursor_position = display_from + pos;
+    cursor_position = display_from + offset_at(event.x - padding.start);
     cursor_position = std::min((size_t)cursor_position, text.length());
     cursor_on = true;
     invalidate();
@@ -229,32 +256,52 @@ auto TextField::select_none() -> void {
 }
 
 auto TextField::get_selected_text() -> const std::string {
-    return this->text.substr(selection.start, selection.end);
+    return this->text.substr(selection.start, selection.end - selection.start);
 }
 
 auto TextField::ensure_cursor_visible() -> void {
-    auto padding_y = this->padding.get_horizontal();
-    auto max_x_position = content.size.width - padding_y;
-    auto cursor_visual_position = (cursor_position - display_from) * 8 + padding_y;
+    auto max_x_position = content.size.width - padding.get_horizontal();
 
-    while (cursor_visual_position > max_x_position) {
-        display_from++;
-        cursor_visual_position = (cursor_position - display_from) * 8 + padding_y;
-    }
-    while (display_from > cursor_position) {
-        display_from = cursor_position - 1;
-    }
     if (cursor_position > text.length()) {
         cursor_position = text.length();
     }
-    if (display_from < 0) {
-        display_from = 0;
+    if (display_from > cursor_position) {
+        display_from = utf8_prev(text, cursor_position);
+    }
+    while (display_from < cursor_position &&
+           text_width(display_from, cursor_position) > max_x_position) {
+        display_from = utf8_next(text, display_from);
     }
     if (selection.end < selection.start) {
         selection.end = selection.start;
     }
 }
 
+auto TextField::text_width(size_t from, size_t to) const -> int {
+    if (to <= from) {
+        return 0;
+    }
+    return get_theme()->font->text_size(std::string_view(text).substr(from, to - from)).width;
+}
+
+auto TextField::offset_at(int x) const -> size_t {
+    // Pick the code point boundary nearest to x, measuring from display_from
+    auto visible = std::string_view(text).substr(display_from);
+    auto font = get_theme()->font;
+    auto offset = size_t{0};
+    auto previous_width = 0;
+    while (offset < visible.size()) {
+        auto next = utf8_next(visible, offset);
+        auto width = font->text_size(visible.substr(0, next)).width;
+        if (x < (previous_width + width) / 2) {
+            break;
+        }
+        offset = next;
+        previous_width = width;
+    }
+    return offset;
+}
+
 auto TextField::set_text(const std::string_view new_text) -> void {
     if (validator) {
         if (!validator->is_string_valid(new_text)) {
@@ -42,10 +42,13 @@ struct TextField : Widget {
 
   private:
     auto ensure_cursor_visible() -> void;
+    auto text_width(size_t from, size_t to) const -> int;
+    auto offset_at(int x) const -> size_t;
 
     std::string text = "";
     SelectionRange selection = {0, 0};
 
+    // Cursor, selection and scrolling are byte offsets into `text`, always on a code point
     Timer timer;
     bool cursor_on = false;
     int cursor_position = 0;
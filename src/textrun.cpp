@@ -0,0 +1,76 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "textrun.h"
+
+#include <algorithm>
+
+auto TextRun::text_size(FontProvider &font, const std::string_view text) -> Size {
+    update(font, text);
+    return size;
+}
+
+auto TextRun::draw(Bitmap &bitmap, Position position, FontProvider &font,
+                   const std::string_view text, uint32_t color) -> void {
+    update(font, text);
+    if (!rasterized) {
+        // Glyphs may hang outside of the text size (descenders, italics), so leave a margin
+        auto margin = size.height;
+        auto canvas = Bitmap();
+        canvas.resize(size.width + margin * 2, size.height + margin * 2);
+        canvas.fill(0);
+        font.write(canvas, {margin, margin}, text, 0xffffff);
+
+        auto left = canvas.size.width;
+        auto top = canvas.size.height;
+        auto right = 0;
+        auto bottom = 0;
+        for (auto y = 0; y < canvas.size.height; y++) {
+            for (auto x = 0; x < canvas.size.width; x++) {
+                if (GetBlue(canvas.buffer[y * canvas.size.width + x]) != 0) {
+                    left = std::min(left, x);
+                    right = std::max(right, x + 1);
+                    top = std::min(top, y);
+                    bottom = std::max(bottom, y + 1);
+                }
+            }
+        }
+
+        mask.resize(std::max(0, right - left), std::max(0, bottom - top));
+        for (auto y = 0; y < mask.size.height; y++) {
+            for (auto x = 0; x < mask.size.width; x++) {
+                auto pixel = canvas.buffer[(y + top) * canvas.size.width + x + left];
+                mask.buffer[y * mask.size.width + x] = GetBlue(pixel);
+            }
+        }
+        origin = {left - margin, top - margin};
+        rasterized = true;
+    }
+    bitmap.blend_mask(mask, {position.x + origin.x, position.y + origin.y}, color);
+}
+
+auto TextRun::clear() -> void {
+    text.clear();
+    font_id = 0;
+    font_generation = 0;
+    font_size = 0;
+    rasterized = false;
+    mask = {};
+}
+
+auto TextRun::update(FontProvider &font, const std::string_view text) -> void {
+    if (this->font_id == font.get_id() && this->font_generation == font.get_generation() &&
+        this->font_size == font.get_size() && this->text == text) {
+        return;
+    }
+    this->text = text;
+    this->font_id = font.get_id();
+    this->font_generation = font.get_generation();
+    this->font_size = font.get_size();
+    this->size = font.text_size(text);
+    this->rasterized = false;
+}
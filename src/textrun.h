@@ -0,0 +1,37 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <bitmap.h>
+#include <fontprovider.h>
+#include <string>
+
+// A rasterized run of text, kept as coverage so it can be drawn in any color. The mask is
+// rebuilt only when the text, the font, its generation or the font size change - static text
+// becomes a single masked blit.
+struct TextRun {
+    auto text_size(FontProvider &font, const std::string_view text) -> Size;
+    auto draw(Bitmap &bitmap, Position position, FontProvider &font, const std::string_view text,
+              uint32_t color) -> void;
+    auto clear() -> void;
+
+  private:
+    auto update(FontProvider &font, const std::string_view text) -> void;
+
+    std::string text;
+    uint64_t font_id = 0;
+    uint32_t font_generation = 0;
+    int font_size = 0;
+    bool rasterized = false;
+    Size size = {};
+
+    // The mask is cropped to the painted pixels, origin is where it starts relative to
+    // the text position
+    AlphaMask mask;
+    Position origin = {};
+};
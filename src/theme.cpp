@@ -6,8 +6,40 @@
  */
 
 #include "theme.h"
+#include <algorithm>
+#include <cstring>
 #include <string>
 
+// Cache entries are dropped when there are more than this, resizing windows can make a lot of
+// size classes
+static constexpr size_t max_cached_elements = 1024;
+
+// Copies `source` into `target`, stretching its middle row and column so it fills `size`.
+// On an axis without a border, `source` should already have the final size.
+static auto draw_nine_patch(Bitmap &target, Position position, Size size, const Bitmap &source,
+                            Size slices) -> void {
+    auto stretch = Size{size.width - source.size.width, size.height - source.size.height};
+    auto x0 = std::max(0, -position.x);
+    auto x1 = std::min(size.width, target.size.width - position.x);
+    auto y0 = std::max(0, -position.y);
+    auto y1 = std::min(size.height, target.size.height - position.y);
+
+    for (auto y = y0; y < y1; y++) {
+        auto source_y = y < slices.height ? y : std::max(slices.height, y - stretch.height);
+        auto source_row = &source.buffer[source_y * source.size.width];
+        auto target_row = &target.buffer[(position.y + y) * target.size.width + position.x];
+
+        if (stretch.width == 0) {
+            std::copy(source_row + x0, source_row + x1, target_row + x0);
+            continue;
+        }
+        for (auto x = x0; x < x1; x++) {
+            auto source_x = x < slices.width ? x : std::max(slices.width, x - stretch.width);
+            target_row[x] = source_row[source_x];
+        }
+    }
+}
+
 auto Theme::draw_frame(Bitmap &content, Position position, Size size, FrameStyles style,
                        FrameSize frame_size) -> void {
 
@@ -88,8 +120,8 @@ auto Theme::draw_frame(Bitmap &content, Position position, Size size, FrameStyle
 }
 
 auto Theme::draw_tabs(Bitmap &content, bool has_focus, int selected_index, int hover_index,
-                      const LayoutParams &padding, const std::vector<std::string> &names)
-    -> std::vector<TabHeaderOffsets> {
+                      const LayoutParams &padding, const std::vector<std::string> &names,
+                      std::vector<TextRun> *text_runs) -> std::vector<TabHeaderOffsets> {
     auto tab_offset = std::vector<TabHeaderOffsets>();
 
     auto offset = 0;
@@ -101,11 +133,16 @@ auto Theme::draw_tabs(Bitmap &content, bool has_focus, int selected_index, int h
     content.fill_rect(0, content.size.height - 3, content.size.width, 1, bottom_frame_color1);
     tab_offset.clear();
     tab_offset.resize(names.size());
+    if (text_runs) {
+        text_runs->resize(names.size());
+    }
     auto i = 0;
     for (auto &tab_name : names) {
         auto is_active_tab = i == selected_index;
         auto is_hover = i == hover_index;
-        auto size = draw_single_tab(content, offset, is_active_tab, is_hover, padding, tab_name);
+        auto text_run = text_runs ? &(*text_runs)[i] : nullptr;
+        auto size = draw_single_tab(content, offset, is_active_tab, is_hover, padding, tab_name,
+                                    text_run);
         tab_offset[i] = {offset, size};
         offset += size;
         i++;
@@ -114,6 +151,83 @@ auto Theme::draw_tabs(Bitmap &content, bool has_focus, int selected_index, int h
     return tab_offset;
 }
 
+auto Theme::measure_text(const std::string_view text, TextRun *text_run) -> Size {
+    if (text_run) {
+        return text_run->text_size(*font, text);
+    }
+    return font->text_size(text);
+}
+
+auto Theme::draw_text(Bitmap &content, Position position, const std::string_view text,
+                      uint32_t color, TextRun *text_run) -> void {
+    if (text_run) {
+        text_run->draw(content, position, *font, text, color);
+    } else {
+        font->write(content, position, text, color);
+    }
+}
+
+auto Theme::draw_table_header(Bitmap &content, const std::string_view text, const bool is_hover)
+    -> void {
+    content.fill(is_hover ? colors.text_selection_background_hover : colors.window_background);
+    content.line(0, content.size.height - 1, content.size.width - 1, content.size.height - 1,
+                 colors.frame_normal_color1);
+    content.line(content.size.width - 1, 0, content.size.width - 1, content.size.height - 1,
+                 colors.frame_normal_color1);
+
+    auto text_padding = 5;
+    auto text_size = font->text_size(text);
+    auto centered = content.size.centeredY(text_size, text_padding);
+    font->write(content, centered, text, colors.text_color);
+}
+
+auto Theme::invalidate_cache() -> void { element_cache.clear(); }
+
+auto Theme::draw_element(Bitmap &content, Position position, Size size, const ThemeElementKey &key,
+                         Size slices, const std::function<void(Bitmap &)> &paint) -> void {
+    if (size.width <= 0 || size.height <= 0) {
+        return;
+    }
+    if (std::memcmp(&colors, &cached_colors, sizeof(ColorStyle)) != 0) {
+        cached_colors = colors;
+        element_cache.clear();
+    }
+
+    // Too small to stretch, the element is cached at its real size on that axis
+    if (size.width <= slices.width * 2) {
+        slices.width = 0;
+    }
+    if (size.height <= slices.height * 2) {
+        slices.height = 0;
+    }
+    auto element_size = Size{slices.width != 0 ? slices.width * 2 + 1 : size.width,
+                             slices.height != 0 ? slices.height * 2 + 1 : size.height};
+    if (element_size.width > 0xffff || element_size.height > 0xffff) {
+        auto element = Bitmap();
+        element.resize(element_size);
+        paint(element);
+        draw_nine_patch(content, position, size, element, slices);
+        return;
+    }
+
+    auto id = static_cast<uint64_t>(key.element) | static_cast<uint64_t>(key.state) << 4 |
+              static_cast<uint64_t>(key.has_focus) << 8 |
+              static_cast<uint64_t>(key.is_enabled) << 9 |
+              static_cast<uint64_t>(key.variant & 0x3fff) << 10 |
+              static_cast<uint64_t>(element_size.width) << 24 |
+              static_cast<uint64_t>(element_size.height) << 40;
+    auto cached = element_cache.find(id);
+    if (cached == element_cache.end()) {
+        if (element_cache.size() >= max_cached_elements) {
+            element_cache.clear();
+        }
+        cached = element_cache.emplace(id, Bitmap()).first;
+        cached->second.resize(element_size);
+        paint(cached->second);
+    }
+    draw_nine_patch(content, position, size, cached->second, slices);
+}
+
 auto ThemeRedmond::get_light_colors() -> ColorStyle {
     auto colors = ColorStyle();
     auto constexpr white = 0xFFFFFF;
@@ -197,7 +311,7 @@ auto ThemeRedmond::draw_scrollbar_background(Bitmap &content) -> void {
 
 auto ThemeRedmond::draw_button(Bitmap &content, bool has_focus, bool is_default, bool is_enabled,
                                bool has_frame, ButtonStates state, const std::string_view text,
-                               const std::shared_ptr<Bitmap> bitmap) -> void {
+                               const std::shared_ptr<Bitmap> bitmap, TextRun *text_run) -> void {
     (void)(has_focus);
     auto text_padding = 5;
     auto background_color = 0;
@@ -244,19 +358,20 @@ auto ThemeRedmond::draw_button(Bitmap &content, bool has_focus, bool is_default,
         break;
     }
 
-    if (!is_default) {
-        content.fill(background_color);
-    } else {
-        content.fill(background_color);
-    }
-    draw_frame(content, topleft, content.size, frame_style, frame_size);
+    auto key = ThemeElementKey{ThemeElement::ButtonBackground, state, has_focus, is_enabled,
+                               is_default | has_frame << 1};
+    draw_cached_element(
+        content, topleft, content.size, key, {button_slice, 0}, [&](Bitmap &element) {
+            element.fill(background_color);
+            draw_frame(element, topleft, element.size, frame_style, frame_size);
+        });
 
-    auto text_size = font->text_size(text);
+    auto text_size = measure_text(text, text_run);
     auto content_rect = content.size - (text_padding);
     auto centered = content_rect.centered(text_size);
 
-    font->write(content, centered - shadow_offset, text, 0x00);
-    font->write(content, centered, text, 0xffffff);
+    draw_text(content, centered - shadow_offset, text, 0x00, text_run);
+    draw_text(content, centered, text, 0xffffff, text_run);
 }
 
 auto ThemeRedmond::draw_checkbox(Bitmap &content, bool has_focus, bool is_enabled, bool is_checked,
@@ -294,26 +409,51 @@ auto ThemeRedmond::draw_checkbox(Bitmap &content, bool has_focus, bool is_enable
 
     content.fill(colors.window_background);
 
-    switch (shape) {
-    case CheckboxShape::Checkbox:
-        content.fill_rect(icon_padding, icon_padding, checkbox_size - icon_padding * 2,
-                          checkbox_size - icon_padding * 2, background_color);
-        draw_frame(content, {0, 0}, {checkbox_size, checkbox_size}, FrameStyles::Normal,
-                   FrameSize::SingleFrame);
-        break;
-    case CheckboxShape::RadioButton:
-        content.fill_circle(m, m, checkbox_size / 2 - icon_padding, background_color);
+    auto indicator_size = Size{std::min(checkbox_size, content.size.width), checkbox_size};
+    auto key = ThemeElementKey{ThemeElement::CheckboxIndicator, state, has_focus, is_enabled,
+                               is_checked | static_cast<int>(shape) << 1};
+    draw_cached_element(content, {0, 0}, indicator_size, key, {0, 0}, [&](Bitmap &element) {
+        element.fill(colors.window_background);
 
-        if (is_enabled) {
-            content.draw_circle(m, m, checkbox_size / 2 - icon_padding, colors.frame_normal_color1);
-            content.draw_circle(m, m, checkbox_size / 2 - icon_padding - 1,
-                                colors.frame_normal_color2);
-        } else {
-            content.draw_circle(m, m, checkbox_size / 2 - icon_padding,
-                                colors.frame_disabled_color1);
+        switch (shape) {
+        case CheckboxShape::Checkbox:
+            element.fill_rect(icon_padding, icon_padding, checkbox_size - icon_padding * 2,
+                              checkbox_size - icon_padding * 2, background_color);
+            draw_frame(element, {0, 0}, {checkbox_size, checkbox_size}, FrameStyles::Normal,
+                       FrameSize::SingleFrame);
+            break;
+        case CheckboxShape::RadioButton:
+            element.fill_circle(m, m, checkbox_size / 2 - icon_padding, background_color);
+
+            if (is_enabled) {
+                element.draw_circle(m, m, checkbox_size / 2 - icon_padding,
+                                    colors.frame_normal_color1);
+                element.draw_circle(m, m, checkbox_size / 2 - icon_padding - 1,
+                                    colors.frame_normal_color2);
+            } else {
+                element.draw_circle(m, m, checkbox_size / 2 - icon_padding,
+                                    colors.frame_disabled_color1);
+            }
+            break;
         }
-        break;
-    }
+
+        if (is_checked) {
+            auto padding = 4;
+
+            switch (shape) {
+            case CheckboxShape::Checkbox:
+                element.line_thikness(padding, padding, checkbox_size - padding,
+                                      checkbox_size - padding, 2, foreground_color);
+                element.line_thikness(checkbox_size - padding, padding, padding,
+                                      checkbox_size - padding, 2, foreground_color);
+                break;
+            case CheckboxShape::RadioButton:
+                element.fill_circle(m + 1, m + 1, checkbox_size / 2 - padding - 3,
+                                    colors.frame_normal_color2);
+                break;
+            }
+        }
+    });
 
     auto text_size = font->text_size(text);
     auto content_rect = content.size;
@@ -323,25 +463,6 @@ auto ThemeRedmond::draw_checkbox(Bitmap &content, bool has_focus, bool is_enable
     centered.x += checkbox_size + padding.start;
     font->write(content, centered, text,
                 is_enabled ? foreground_color : colors.text_color_disabled);
-
-    if (is_checked) {
-        auto padding = 4;
-
-        switch (shape) {
-        case CheckboxShape::Checkbox:
-            content.line_thikness(padding, padding, checkbox_size - padding,
-                                  checkbox_size - padding, 2, foreground_color);
-            content.line_thikness(checkbox_size - padding, padding, padding,
-                                  checkbox_size - padding, 2, foreground_color);
-            break;
-        case CheckboxShape::RadioButton:
-            content.fill_circle(m + 1, m + 1, checkbox_size / 2 - padding - 3,
-                                colors.frame_normal_color2);
-            //            content.fill_circle(m+2, m+2, checkbox_size/2 - padding-4,
-            //            ThemeRedmond::line_color2);
-            break;
-        }
-    }
 }
 
 auto ThemeRedmond::draw_input_background(Bitmap &content, const bool has_focus) -> void {
@@ -363,21 +484,34 @@ auto ThemeRedmond::draw_listview_background(Bitmap &content, const bool has_focu
 void ThemeRedmond::draw_listview_item(Bitmap &content, const std::string_view text,
                                       const ItemStatus status, const bool is_hover) {
     auto padding = Position{defaultPadding.start, defaultPadding.top};
-    auto text_color = status.is_active ? colors.text_selection_color : colors.text_color;
+    auto text_color = status.is_selected ? colors.text_selection_color : colors.text_color;
     auto background_color =
-        status.is_active ? colors.text_selection_background : colors.input_background_normal;
-    if (is_hover && !status.is_active) {
+        status.is_selected ? colors.text_selection_background : colors.input_background_normal;
+    if (is_hover && !status.is_selected) {
         background_color = colors.input_background_hover;
     }
     content.fill(background_color);
+    if (status.is_active && !status.is_selected) {
+        auto focus_color = colors.text_selection_background;
+        content.draw_rectangle(0, 0, content.size.width, content.size.height, focus_color,
+                               focus_color);
+    }
     font->write(content, padding, text, text_color);
 }
 
+auto ThemeRedmond::draw_table_header(Bitmap &content, const std::string_view text,
+                                     const bool is_hover) -> void {
+    auto padding = Position{defaultPadding.start, defaultPadding.top};
+    content.fill(is_hover ? colors.input_background_hover : colors.window_background);
+    draw_frame(content, {0, 0}, content.size, FrameStyles::Normal, FrameSize::SingleFrame);
+    font->write(content, padding, text, colors.text_color);
+}
+
 auto ThemeRedmond::draw_single_tab(Bitmap &content, const int offset, const bool is_active,
                                    const bool is_hover, const LayoutParams &padding,
-                                   const std::string_view name) -> int {
+                                   const std::string_view name, TextRun *text_run) -> int {
     auto active_bg = (colors.window_background);
-    auto tab_size = font->text_size(name);
+    auto tab_size = measure_text(name, text_run);
 
     tab_size.width += padding.get_horizontal();
     tab_size.height += padding.get_vertical();
@@ -394,7 +528,7 @@ auto ThemeRedmond::draw_single_tab(Bitmap &content, const int offset, const bool
                               Lighter(active_bg, 0.05));
         }
     }
-    font->write(content, {offset + padding.start, padding.top}, name, colors.text_color);
+    draw_text(content, {offset + padding.start, padding.top}, name, colors.text_color, text_run);
     return tab_size.width;
 }
 
@@ -519,7 +653,7 @@ auto ThemePlasma::draw_scrollbar_background(Bitmap &content) -> void {}
 
 auto ThemePlasma::draw_button(Bitmap &content, bool has_focus, bool is_default, bool is_enabled,
                               bool has_frame, ButtonStates state, const std::string_view text,
-                              const std::shared_ptr<Bitmap> icon) -> void {
+                              const std::shared_ptr<Bitmap> icon, TextRun *text_run) -> void {
     auto background1 = colors.button_background_1;
     auto background2 = colors.button_background_2;
     auto border = colors.frame_normal_color1;
@@ -561,24 +695,30 @@ auto ThemePlasma::draw_button(Bitmap &content, bool has_focus, bool is_default,
         }
     }
 
-    if (background1 == background2) {
-        content.fill(background1);
-    } else {
-        content.fill_rect_gradient(0, 0, content.size.width, content.size.height, background1,
-                                   background2);
-    }
+    auto key = ThemeElementKey{ThemeElement::ButtonBackground, state, has_focus, is_enabled,
+                               is_default | has_frame << 1};
+    draw_cached_element(
+        content, {0, 0}, content.size, key, {button_slice, 0}, [&](Bitmap &element) {
+            auto size = element.size;
+            if (background1 == background2) {
+                element.fill(background1);
+            } else {
+                element.fill_rect_gradient(0, 0, size.width, size.height, background1,
+                                           background2);
+            }
 
-    if (has_frame || state != ButtonStates::Normal) {
-        content.draw_rounded_rectangle(0, 0, content.size.width, content.size.height - 1, 5, border,
-                                       border);
-        content.line(2, content.size.height - 1, content.size.width - 2, content.size.height - 1,
-                     colors.frame_disabled_color1);
-    }
+            if (has_frame || state != ButtonStates::Normal) {
+                element.draw_rounded_rectangle(0, 0, size.width, size.height - 1, 5, border,
+                                               border);
+                element.line(2, size.height - 1, size.width - 2, size.height - 1,
+                             colors.frame_disabled_color1);
+            }
 
-    // TODO - widget should be filled with real content from parent
-    content.put_pixel(0, content.size.height - 1, colors.window_background);
-    content.put_pixel(1, content.size.height - 1, colors.window_background);
-    content.put_pixel(content.size.width - 1, content.size.height - 1, colors.window_background);
+            // TODO - widget should be filled with real content from parent
+            element.put_pixel(0, size.height - 1, colors.window_background);
+            element.put_pixel(1, size.height - 1, colors.window_background);
+            element.put_pixel(size.width - 1, size.height - 1, colors.window_background);
+        });
 
     if (is_enabled) {
         // TODO properly center
@@ -588,9 +728,9 @@ auto ThemePlasma::draw_button(Bitmap &content, bool has_focus, bool is_default,
             auto centered = content.size.centered(icon->size, text_padding);
             content.draw(centered, *icon.get(), true);
         } else {
-            auto text_size = font->text_size(text);
+            auto text_size = measure_text(text, text_run);
             auto centered = content.size.centered(text_size, text_padding);
-            font->write(content, centered, text, color);
+            draw_text(content, centered, text, color, text_run);
         }
     }
 }
@@ -622,53 +762,62 @@ auto ThemePlasma::draw_checkbox(Bitmap &content, bool has_focus, bool is_enabled
     }
 
     content.fill(background_color);
-    {
-        auto icon_padding = 3;
-        auto p = Position{icon_padding, icon_padding};
-        auto w = Size{checkbox_size - icon_padding * 2, checkbox_size - icon_padding * 2};
-        auto m = checkbox_size / 2;
 
-        switch (shape) {
-        case CheckboxShape::Checkbox:
-            content.draw_rounded_rectangle(p.x, p.y, w.width, w.height, 1, checkbox_border,
-                                           checkbox_border);
-            break;
-        case CheckboxShape::RadioButton:
-            if (is_checked) {
-                if (is_enabled) {
-                    content.fill_circle(m, m, checkbox_size / 2 - icon_padding,
-                                        colors.button_selected_background);
-                    content.draw_circle(m, m, checkbox_size / 2 - icon_padding,
-                                        colors.frame_hover_color1);
+    auto indicator_size = Size{std::min(checkbox_size, content.size.width), checkbox_size};
+    auto key = ThemeElementKey{ThemeElement::CheckboxIndicator, state, has_focus, is_enabled,
+                               is_checked | static_cast<int>(shape) << 1};
+    draw_cached_element(content, {0, 0}, indicator_size, key, {0, 0}, [&](Bitmap &element) {
+        element.fill(background_color);
+        {
+            auto icon_padding = 3;
+            auto p = Position{icon_padding, icon_padding};
+            auto w = Size{checkbox_size - icon_padding * 2, checkbox_size - icon_padding * 2};
+            auto m = checkbox_size / 2;
+
+            switch (shape) {
+            case CheckboxShape::Checkbox:
+                element.draw_rounded_rectangle(p.x, p.y, w.width, w.height, 1, checkbox_border,
+                                               checkbox_border);
+                break;
+            case CheckboxShape::RadioButton:
+                if (is_checked) {
+                    if (is_enabled) {
+                        element.fill_circle(m, m, checkbox_size / 2 - icon_padding,
+                                            colors.button_selected_background);
+                        element.draw_circle(m, m, checkbox_size / 2 - icon_padding,
+                                            colors.frame_hover_color1);
+                    } else {
+                        element.fill_circle(m, m, checkbox_size / 2 - icon_padding,
+                                            checkbox_border);
+                        element.draw_circle(m, m, checkbox_size / 2 - icon_padding,
+                                            colors.text_color_disabled);
+                    }
                 } else {
-                    content.fill_circle(m, m, checkbox_size / 2 - icon_padding, checkbox_border);
-                    content.draw_circle(m, m, checkbox_size / 2 - icon_padding,
-                                        colors.text_color_disabled);
+                    element.draw_circle(m, m, checkbox_size / 2 - icon_padding,
+                                        checkbox_border);
                 }
-            } else {
-                content.draw_circle(m, m, checkbox_size / 2 - icon_padding, checkbox_border);
+                break;
             }
-            break;
         }
-    }
-
-    {
-        auto icon_padding = 5;
-        auto p = Position{icon_padding, icon_padding};
-        auto w = Size{checkbox_size - icon_padding * 2, checkbox_size - icon_padding * 2};
-        auto m = checkbox_size / 2;
 
-        switch (shape) {
-        case CheckboxShape::Checkbox:
-            content.fill_rect(p.x, p.y, w.width, w.height, checkbox_border);
-            break;
-        case CheckboxShape::RadioButton:
-            if (is_checked) {
-                content.fill_circle(m, m, 4, checkbox_border);
+        {
+            auto icon_padding = 5;
+            auto p = Position{icon_padding, icon_padding};
+            auto w = Size{checkbox_size - icon_padding * 2, checkbox_size - icon_padding * 2};
+            auto m = checkbox_size / 2;
+
+            switch (shape) {
+            case CheckboxShape::Checkbox:
+                element.fill_rect(p.x, p.y, w.width, w.height, checkbox_border);
+                break;
+            case CheckboxShape::RadioButton:
+                if (is_checked) {
+                    element.fill_circle(m, m, 4, checkbox_border);
+                }
+                break;
             }
-            break;
         }
-    }
+    });
 
     {
         auto text_size = font->text_size(text);
@@ -701,14 +850,19 @@ auto ThemePlasma::draw_listview_background(Bitmap &content, const bool has_focus
 void ThemePlasma::draw_listview_item(Bitmap &content, const std::string_view text,
                                      const ItemStatus status, const bool is_hover) {
 
-    auto text_color = status.is_active ? colors.text_selection_color : colors.text_color;
+    auto text_color = status.is_selected ? colors.text_selection_color : colors.text_color;
     auto background_color =
-        status.is_active ? colors.text_selection_background : colors.input_background_normal;
-    if (is_hover && !status.is_active) {
+        status.is_selected ? colors.text_selection_background : colors.input_background_normal;
+    if (is_hover && !status.is_selected) {
         background_color = colors.text_selection_background_hover;
     }
 
     content.fill(background_color);
+    if (status.is_active && !status.is_selected) {
+        auto focus_color = colors.text_selection_background;
+        content.draw_rectangle(0, 0, content.size.width, content.size.height, focus_color,
+                               focus_color);
+    }
     auto text_padding = 5;
     auto text_size = font->text_size(text);
     auto centered = content.size.centeredY(text_size, text_padding);
@@ -717,10 +871,10 @@ void ThemePlasma::draw_listview_item(Bitmap &content, const std::string_view tex
 
 auto ThemePlasma::draw_single_tab(Bitmap &content, const int offset, const bool is_active,
                                   const bool is_hover, const LayoutParams &padding,
-                                  const std::string_view name) -> int {
+                                  const std::string_view name, TextRun *text_run) -> int {
     auto is_tab_hover = is_hover;
     auto active_bg = colors.window_background;
-    auto tab_size = font->text_size(name);
+    auto tab_size = measure_text(name, text_run);
     tab_size.width += padding.get_horizontal();
     tab_size.height += padding.get_vertical();
 
@@ -748,9 +902,10 @@ auto ThemePlasma::draw_single_tab(Bitmap &content, const int offset, const bool
     if (is_active) {
         is_tab_hover = false;
     }
-    font->write(content, {offset + padding.start, padding.top}, name,
-                is_tab_hover ? Lighter(colors.button_selected_text, 0.3)
-                             : colors.button_selected_text);
+    draw_text(content, {offset + padding.start, padding.top}, name,
+              is_tab_hover ? Lighter(colors.button_selected_text, 0.3)
+                           : colors.button_selected_text,
+              text_run);
     return tab_size.width;
 }
 
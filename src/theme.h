@@ -11,7 +11,10 @@
 #include <buttonstates.h>
 #include <checkboxshape.h>
 #include <fontprovider.h>
+#include <functional>
 #include <memory>
+#include <textrun.h>
+#include <unordered_map>
 
 struct ColorStyle {
     int32_t window_background = 0;
@@ -61,6 +64,18 @@ struct TabHeaderOffsets {
 
 enum class PaddingStyle { Label, Button, Checkbox, ScrollBar, TabHeader };
 
+// Elements which themes render once, and then draw from the element cache
+enum class ThemeElement { ButtonBackground, CheckboxIndicator };
+
+struct ThemeElementKey {
+    ThemeElement element = ThemeElement::ButtonBackground;
+    ButtonStates state = ButtonStates::Normal;
+    bool has_focus = false;
+    bool is_enabled = true;
+    // Element specific flags, like default or frameless buttons, or checked boxes
+    int variant = 0;
+};
+
 struct Theme {
     ColorStyle colors = {};
     std::shared_ptr<FontProvider> font;
@@ -72,8 +87,13 @@ struct Theme {
     auto draw_frame(Bitmap &content, Position position, Size size, FrameStyles style,
                     FrameSize frame_size) -> void;
     auto draw_tabs(Bitmap &content, bool has_focus, int selected_index, int hover_index,
-                   const LayoutParams &padding, const std::vector<std::string> &names)
-        -> std::vector<TabHeaderOffsets>;
+                   const LayoutParams &padding, const std::vector<std::string> &names,
+                   std::vector<TextRun> *text_runs = nullptr) -> std::vector<TabHeaderOffsets>;
+
+    // Text is drawn through the widget's cached run, when the widget provides one
+    auto measure_text(const std::string_view text, TextRun *text_run = nullptr) -> Size;
+    auto draw_text(Bitmap &content, Position position, const std::string_view text,
+                   uint32_t color, TextRun *text_run = nullptr) -> void;
 
     virtual auto init() -> void = 0;
     virtual auto draw_widget_background(Bitmap &content, bool has_focus) -> void = 0;
@@ -81,7 +101,8 @@ struct Theme {
     virtual auto draw_scrollbar_background(Bitmap &content) -> void = 0;
     virtual auto draw_button(Bitmap &content, bool has_focus, bool is_default, bool is_enabled,
                              bool has_frame, ButtonStates state, const std::string_view text,
-                             const std::shared_ptr<Bitmap> bitmap) -> void = 0;
+                             const std::shared_ptr<Bitmap> bitmap,
+                             TextRun *text_run = nullptr) -> void = 0;
     virtual auto draw_checkbox(Bitmap &content, bool has_focus, bool is_enabled, bool is_checked,
                                ButtonStates state, const std::string_view text, CheckboxShape shape,
                                const LayoutParams &padding) -> void = 0;
@@ -93,9 +114,15 @@ struct Theme {
                                           bool draw_background) -> void = 0;
     virtual auto draw_listview_item(Bitmap &content, const std::string_view text,
                                     const ItemStatus status, const bool is_hover) -> void = 0;
+
+    // A column title of a table view, `content` has the size of the column. Drawn as a flat
+    // cell with a line on its bottom and right edges, unless the theme overrides it.
+    virtual auto draw_table_header(Bitmap &content, const std::string_view text,
+                                   const bool is_hover) -> void;
     virtual auto draw_single_tab(Bitmap &content, const int offset, const bool is_active,
                                  const bool is_hover, const LayoutParams &padding,
-                                 const std::string_view name) -> int = 0;
+                                 const std::string_view name, TextRun *text_run = nullptr)
+        -> int = 0;
 
     virtual auto needs_frame_for_focus() const -> bool = 0;
     virtual auto scrollbar_size() const -> int = 0;
@@ -106,6 +133,31 @@ struct Theme {
         (void)(t);
         return defaultPadding;
     }
+
+    // Drops all cached elements. Changes to `colors` are detected without this.
+    auto invalidate_cache() -> void;
+
+  protected:
+    // Nine-patch border of button backgrounds, wide enough for the rounded frames of all themes
+    static constexpr int button_slice = 6;
+
+    // Draws an element from the cache, calling `paint` to render it on a miss. `slices` are the
+    // nine-patch borders: on an axis with a border the element is rendered at its smallest
+    // size, and the middle row or column is stretched to `size`. On an axis without one, the
+    // size is part of the key (the "size class" of the element).
+    template <typename Paint>
+    auto draw_cached_element(Bitmap &content, Position position, Size size,
+                             const ThemeElementKey &key, Size slices, Paint &&paint) -> void {
+        // A reference wrapper fits in std::function without a heap allocation
+        draw_element(content, position, size, key, slices, std::ref(paint));
+    }
+
+  private:
+    auto draw_element(Bitmap &content, Position position, Size size, const ThemeElementKey &key,
+                      Size slices, const std::function<void(Bitmap &)> &paint) -> void;
+
+    std::unordered_map<uint64_t, Bitmap> element_cache;
+    ColorStyle cached_colors = {};
 };
 
 // A windows 9x look and feel based theme
@@ -121,7 +173,8 @@ struct ThemeRedmond : Theme {
     virtual auto draw_scrollbar_background(Bitmap &content) -> void override;
     virtual auto draw_button(Bitmap &content, bool has_focus, bool is_default, bool is_enabled,
                              bool has_frame, ButtonStates state, const std::string_view text,
-                             const std::shared_ptr<Bitmap> bitmap) -> void override;
+                             const std::shared_ptr<Bitmap> bitmap,
+                             TextRun *text_run = nullptr) -> void override;
     virtual auto draw_checkbox(Bitmap &content, bool has_focus, bool is_enabled, bool is_checked,
                                ButtonStates state, const std::string_view text, CheckboxShape shape,
                                const LayoutParams &padding) -> void override;
@@ -130,10 +183,13 @@ struct ThemeRedmond : Theme {
                                           bool draw_background) -> void override;
     virtual auto draw_listview_item(Bitmap &content, const std::string_view text,
                                     const ItemStatus status, const bool is_hover) -> void override;
+    virtual auto draw_table_header(Bitmap &content, const std::string_view text,
+                                   const bool is_hover) -> void override;
 
     virtual auto draw_single_tab(Bitmap &content, const int offset, const bool is_active,
                                  const bool is_hover, const LayoutParams &padding,
-                                 const std::string_view name) -> int override;
+                                 const std::string_view name, TextRun *text_run = nullptr)
+        -> int override;
 
     virtual auto needs_frame_for_focus() const -> bool override { return true; };
     virtual auto scrollbar_size() const -> int override { return 24; };
@@ -158,7 +214,8 @@ struct ThemePlasma : Theme {
     virtual auto draw_scrollbar_background(Bitmap &content) -> void override;
     virtual auto draw_button(Bitmap &content, bool has_focus, bool is_default, bool is_enabled,
                              bool has_frame, ButtonStates state, const std::string_view text,
-                             const std::shared_ptr<Bitmap> icon) -> void override;
+                             const std::shared_ptr<Bitmap> icon,
+                             TextRun *text_run = nullptr) -> void override;
     virtual auto draw_checkbox(Bitmap &content, bool has_focus, bool is_enabled, bool is_checked,
                                ButtonStates state, const std::string_view text, CheckboxShape shape,
                                const LayoutParams &padding) -> void override;
@@ -169,7 +226,8 @@ struct ThemePlasma : Theme {
                                     const ItemStatus status, const bool is_hover) -> void override;
     virtual auto draw_single_tab(Bitmap &content, const int offset, const bool is_active,
                                  const bool is_hover, const LayoutParams &padding,
-                                 const std::string_view name) -> int override;
+                                 const std::string_view name, TextRun *text_run = nullptr)
+        -> int override;
 
     virtual auto needs_frame_for_focus() const -> bool override { return false; };
     virtual auto scrollbar_size() const -> int override { return 16; };
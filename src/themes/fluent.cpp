@@ -6,6 +6,7 @@
  */
 
 #include "themes/fluent.h"
+#include <algorithm>
 
 auto ThemeFluent::get_light_colors(int32_t accent) -> ColorStyle {
     auto background = MakeColor(243, 243, 243);
@@ -76,7 +77,7 @@ auto ThemeFluent::draw_scrollbar_background(Bitmap &content) -> void {
 
 auto ThemeFluent::draw_button(Bitmap &content, bool has_focus, bool is_default, bool is_enabled,
                               bool has_frame, ButtonStates state, const std::string_view text,
-                              const std::shared_ptr<Bitmap> bitmap) -> void {
+                              const std::shared_ptr<Bitmap> bitmap, TextRun *text_run) -> void {
 
     auto text_padding = 5;
     auto background = !is_default ? colors.button_background_1 : colors.button_selected_background;
@@ -105,17 +106,23 @@ auto ThemeFluent::draw_button(Bitmap &content, bool has_focus, bool is_default,
         break;
     }
 
-    content.fill(background);
-    if (has_frame || state != ButtonStates::Normal) {
-        draw_frame(content, {0, 0}, content.size, frame,
-                   is_default ? FrameSize::DoubleFrame : FrameSize::SingleFrame);
-
-        content.line(2, content.size.height - 1, content.size.width - 4, content.size.height - 1,
-                     Darker(background, is_default ? 0.1 : 0.5));
-    }
-    auto text_size = font->text_size(text);
+    auto key = ThemeElementKey{ThemeElement::ButtonBackground, state, has_focus, is_enabled,
+                               is_default | has_frame << 1};
+    draw_cached_element(
+        content, {0, 0}, content.size, key, {button_slice, 0}, [&](Bitmap &element) {
+            auto size = element.size;
+            element.fill(background);
+            if (has_frame || state != ButtonStates::Normal) {
+                draw_frame(element, {0, 0}, size, frame,
+                           is_default ? FrameSize::DoubleFrame : FrameSize::SingleFrame);
+
+                element.line(2, size.height - 1, size.width - 4, size.height - 1,
+                             Darker(background, is_default ? 0.1 : 0.5));
+            }
+        });
+    auto text_size = measure_text(text, text_run);
     auto centered = content.size.centered(text_size, text_padding);
-    font->write(content, centered, text, color);
+    draw_text(content, centered, text, color, text_run);
 }
 
 auto ThemeFluent::draw_checkbox(Bitmap &content, bool has_focus, bool is_enabled, bool is_checked,
@@ -179,61 +186,71 @@ auto ThemeFluent::draw_checkbox(Bitmap &content, bool has_focus, bool is_enabled
 
     content.fill(background_color);
 
-    // this part draws the borders
-    {
-        auto margin_top = 2;
-        auto p = Position{0, 0};
-        auto w = Size{checkbox_size, checkbox_size};
-        auto m = (checkbox_size) / 2;
-
-        switch (shape) {
-        case CheckboxShape::Checkbox:
-            if (is_checked) {
-                content.fill_rounded_rect(p.x, p.y, w.width, w.height, checkbox_background);
-            } else {
-                if (state == ButtonStates::ClickedInside) {
-                    content.fill_rect(p.x, p.y, w.width, w.height, checkbox_background);
+    // The check mark is drawn at fixed offsets, and can be wider than small boxes
+    auto indicator_size = Size{std::min(std::max(checkbox_size, 16), content.size.width),
+                               checkbox_size};
+    auto key = ThemeElementKey{ThemeElement::CheckboxIndicator, state, has_focus, is_enabled,
+                               is_checked | static_cast<int>(shape) << 1};
+    draw_cached_element(content, {0, 0}, indicator_size, key, {0, 0}, [&](Bitmap &element) {
+        element.fill(background_color);
+
+        // this part draws the borders
+        {
+            auto margin_top = 2;
+            auto p = Position{0, 0};
+            auto w = Size{checkbox_size, checkbox_size};
+            auto m = (checkbox_size) / 2;
+
+            switch (shape) {
+            case CheckboxShape::Checkbox:
+                if (is_checked) {
+                    element.fill_rounded_rect(p.x, p.y, w.width, w.height, checkbox_background);
                 } else {
-                    content.draw_rounded_rectangle(p.x, p.y, w.width, w.height, 1,
-                                                   checkbox_background, checkbox_background);
+                    if (state == ButtonStates::ClickedInside) {
+                        element.fill_rect(p.x, p.y, w.width, w.height, checkbox_background);
+                    } else {
+                        element.draw_rounded_rectangle(p.x, p.y, w.width, w.height, 1,
+                                                       checkbox_background,
+                                                       checkbox_background);
+                    }
                 }
+                break;
+            case CheckboxShape::RadioButton:
+                element.draw_circle(checkbox_size / 2, checkbox_size / 2, m - margin_top,
+                                    checkbox_background);
+                break;
             }
-            break;
-        case CheckboxShape::RadioButton:
-            content.draw_circle(checkbox_size / 2, checkbox_size / 2, m - margin_top,
-                                checkbox_background);
-            break;
         }
-    }
 
-    // this part draws the checked center
-    {
-        auto margin_top = 2;
-        switch (shape) {
-        case CheckboxShape::Checkbox: {
-            auto p = Position{margin_top, margin_top};
-            auto w = Size{checkbox_size - margin_top * 2, checkbox_size - margin_top * 2};
-            if (is_checked) {
-                content.line(p.x + 5, p.y + w.height - 10, p.x + 8, p.y + w.height - 5,
-                             checkbox_color);
-                content.line(p.x + 8, p.y + w.height - 5, p.x + 13, p.y + w.height - 15,
-                             checkbox_color);
-            } else {
+        // this part draws the checked center
+        {
+            auto margin_top = 2;
+            switch (shape) {
+            case CheckboxShape::Checkbox: {
+                auto p = Position{margin_top, margin_top};
+                auto w = Size{checkbox_size - margin_top * 2, checkbox_size - margin_top * 2};
+                if (is_checked) {
+                    element.line(p.x + 5, p.y + w.height - 10, p.x + 8, p.y + w.height - 5,
+                                 checkbox_color);
+                    element.line(p.x + 8, p.y + w.height - 5, p.x + 13, p.y + w.height - 15,
+                                 checkbox_color);
+                } else {
+                }
+                break;
             }
-            break;
-        }
-        case CheckboxShape::RadioButton:
-            if (is_checked) {
-                auto m2 = checkbox_size / 2;
-                auto m3 = checkbox_size / 3.1;
-                content.fill_circle(checkbox_size / 2, checkbox_size / 2, m2 - margin_top,
-                                    checkbox_background);
-                content.fill_circle(checkbox_size / 2, checkbox_size / 2, m3 - margin_top,
-                                    checkbox_color);
+            case CheckboxShape::RadioButton:
+                if (is_checked) {
+                    auto m2 = checkbox_size / 2;
+                    auto m3 = checkbox_size / 3.1;
+                    element.fill_circle(checkbox_size / 2, checkbox_size / 2, m2 - margin_top,
+                                        checkbox_background);
+                    element.fill_circle(checkbox_size / 2, checkbox_size / 2, m3 - margin_top,
+                                        checkbox_color);
+                }
+                break;
             }
-            break;
         }
-    }
+    });
 
     auto text_margin = 5;
     auto text_size = font->text_size(text);
@@ -269,13 +286,18 @@ auto ThemeFluent::draw_listview_background(Bitmap &content, const bool has_focus
 
 void ThemeFluent::draw_listview_item(Bitmap &content, const std::string_view text,
                                      const ItemStatus status, const bool is_hover) {
-    auto text_color = status.is_active ? colors.text_selection_color : colors.text_color;
+    auto text_color = status.is_selected ? colors.text_selection_color : colors.text_color;
     auto background_color =
-        status.is_active ? colors.text_selection_background : colors.input_background_normal;
-    if (is_hover && !status.is_active) {
+        status.is_selected ? colors.text_selection_background : colors.input_background_normal;
+    if (is_hover && !status.is_selected) {
         background_color = colors.text_selection_background_hover;
     }
     content.fill(background_color);
+    if (status.is_active && !status.is_selected) {
+        auto focus_color = colors.text_selection_background;
+        content.draw_rectangle(0, 0, content.size.width, content.size.height, focus_color,
+                               focus_color);
+    }
 
     auto text_padding = 5;
     auto text_size = font->text_size(text);
@@ -285,9 +307,9 @@ void ThemeFluent::draw_listview_item(Bitmap &content, const std::string_view tex
 
 auto ThemeFluent::draw_single_tab(Bitmap &content, const int offset, const bool is_active,
                                   const bool is_hover, const LayoutParams &padding,
-                                  const std::string_view name) -> int {
+                                  const std::string_view name, TextRun *text_run) -> int {
     // https://learn.microsoft.com/en-us/microsoftteams/platform/tabs/design/tabs
-    auto tab_width = font->text_size(name).width;
+    auto tab_width = measure_text(name, text_run).width;
     auto text_color = colors.text_color;
     auto margin_bottom = 1;
     auto line_height = 5;
@@ -303,7 +325,7 @@ auto ThemeFluent::draw_single_tab(Bitmap &content, const int offset, const bool
         content.fill_rect(offset, content.size.height - 3, content.size.width, 1,
                           bottom_frame_color1);
     }
-    font->write(content, {offset + padding.start, padding.top}, name, text_color);
+    draw_text(content, {offset + padding.start, padding.top}, name, text_color, text_run);
     return tab_width;
 }
 
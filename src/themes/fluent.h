@@ -27,7 +27,8 @@ struct ThemeFluent : Theme {
     virtual auto draw_scrollbar_background(Bitmap &content) -> void override;
     virtual auto draw_button(Bitmap &content, bool has_focus, bool is_default, bool is_enabled,
                              bool has_frame, ButtonStates state, const std::string_view text,
-                             const std::shared_ptr<Bitmap> bitmap) -> void override;
+                             const std::shared_ptr<Bitmap> bitmap,
+                             TextRun *text_run = nullptr) -> void override;
     virtual auto draw_checkbox(Bitmap &content, bool has_focus, bool is_enabled, bool is_checked,
                                ButtonStates state, const std::string_view text, CheckboxShape shape,
                                const LayoutParams &padding) -> void override;
@@ -38,7 +39,8 @@ struct ThemeFluent : Theme {
                                     const ItemStatus status, const bool is_hover) -> void override;
     virtual auto draw_single_tab(Bitmap &content, const int offset, const bool is_active,
                                  const bool is_hover, const LayoutParams &padding,
-                                 const std::string_view name) -> int override;
+                                 const std::string_view name, TextRun *text_run = nullptr)
+        -> int override;
 
     virtual auto needs_frame_for_focus() const -> bool override { return false; };
     virtual auto scrollbar_size() const -> int override { return 16; };
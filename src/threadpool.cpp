@@ -0,0 +1,90 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "threadpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back([this]() { run(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        auto guard = std::lock_guard(lock);
+        is_stopping = true;
+    }
+    has_tasks.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+auto ThreadPool::submit(std::function<void()> task) -> void {
+    {
+        auto guard = std::lock_guard(lock);
+        tasks.push_back(std::move(task));
+    }
+    has_tasks.notify_one();
+}
+
+auto ThreadPool::parallel_for(size_t count, const std::function<void(size_t)> &task) -> void {
+    // Helpers which start after all indices were taken find nothing to do, the batch is
+    // shared so it outlives this call
+    struct Batch {
+        std::atomic<size_t> next = {0};
+        std::atomic<size_t> done = {0};
+        size_t count = 0;
+        const std::function<void(size_t)> *task = nullptr;
+        std::mutex lock;
+        std::condition_variable finished;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->count = count;
+    batch->task = &task;
+
+    auto work = [batch]() {
+        for (auto i = batch->next++; i < batch->count; i = batch->next++) {
+            (*batch->task)(i);
+            if (++batch->done == batch->count) {
+                auto guard = std::lock_guard(batch->lock);
+                batch->finished.notify_all();
+            }
+        }
+    };
+    auto helpers = std::min(count, workers.size()) - (count > 0 ? 1 : 0);
+    for (size_t i = 0; i < helpers; i++) {
+        submit(work);
+    }
+    work();
+
+    auto guard = std::unique_lock(batch->lock);
+    batch->finished.wait(guard, [&batch]() { return batch->done == batch->count; });
+}
+
+auto ThreadPool::run() -> void {
+    while (true) {
+        auto task = std::function<void()>();
+        {
+            auto guard = std::unique_lock(lock);
+            has_tasks.wait(guard, [this]() { return is_stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,42 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads, for work which must not run on the UI thread. Results are
+// handed back to the UI thread with `Platform::post()`.
+struct ThreadPool {
+    // Zero means one thread per core
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    auto submit(std::function<void()> task) -> void;
+
+    // Calls `task` for every index in [0, count), on the workers and on the calling thread.
+    // Returns when all are done. The caller takes part in the work, so this can also be used
+    // from inside a task without waiting for a free worker.
+    auto parallel_for(size_t count, const std::function<void(size_t)> &task) -> void;
+
+    auto size() const -> size_t { return workers.size(); }
+
+  private:
+    auto run() -> void;
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex lock;
+    std::condition_variable has_tasks;
+    bool is_stopping = false;
+};
@@ -0,0 +1,371 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "treeview.h"
+#include "theme.h"
+
+#include <algorithm>
+
+TreeRows::TreeRows(std::shared_ptr<TreeModel> model) : model(model) {
+    auto root = NodeState{};
+    root.is_expanded = true;
+    states.push_back(root);
+}
+
+auto TreeRows::create(std::shared_ptr<TreeModel> model) -> std::shared_ptr<TreeRows> {
+    auto rows = std::shared_ptr<TreeRows>(new TreeRows(model));
+    rows->fetch(0);
+    return rows;
+}
+
+auto TreeRows::get_widget(size_t /*position*/, Theme &theme) -> PWidget {
+    auto size = Size{theme.font->text_size("X").width, ListItemWidget::get_height(theme)};
+    auto p = std::make_shared<TreeItemWidget>(Position{0, 0}, size, "");
+    p->can_focus = true;
+    p->draw_background = false;
+    return p;
+}
+
+auto TreeRows::get_item_height(size_t /*position*/, Theme &theme) -> int {
+    return ListItemWidget::get_height(theme);
+}
+
+auto TreeRows::set_content(PWidget widget, size_t position, ItemStatus status) -> void {
+    auto item = std::dynamic_pointer_cast<TreeItemWidget>(widget);
+    auto &state = states[state_at(position)];
+    item->text = model->get_text(state.node);
+    item->depth = state.depth;
+    item->has_children = state.is_loaded ? state.child_count != 0 : model->has_children(state.node);
+    item->is_expanded = state.is_expanded;
+    item->is_loading = state.is_loading;
+    item->status = status;
+}
+
+auto TreeRows::get_text(size_t position) const -> std::string_view {
+    return model->get_text(get_node(position));
+}
+
+auto TreeRows::get_node(size_t row) const -> TreeModel::Node {
+    return states[state_at(row)].node;
+}
+
+auto TreeRows::get_depth(size_t row) const -> int { return states[state_at(row)].depth; }
+
+auto TreeRows::is_expanded(size_t row) const -> bool {
+    return states[state_at(row)].is_expanded;
+}
+
+auto TreeRows::is_loading(size_t row) const -> bool { return states[state_at(row)].is_loading; }
+
+auto TreeRows::get_parent_row(size_t row) const -> int64_t {
+    auto parent = states[state_at(row)].parent;
+    if (parent == 0) {
+        return -1;
+    }
+    return static_cast<int64_t>(row_of(parent));
+}
+
+auto TreeRows::expand(size_t row) -> void {
+    if (row >= get_count()) {
+        return;
+    }
+    auto state = state_at(row);
+    if (states[state].is_expanded || !model->has_children(states[state].node)) {
+        return;
+    }
+
+    // Children still loading are shown when they arrive
+    states[state].is_expanded = true;
+    rows_changed(row, 1);
+    if (!states[state].is_loaded) {
+        if (!states[state].is_loading) {
+            fetch(state);
+        }
+        return;
+    }
+    auto rows = states[state].rows;
+    if (rows != 0 && add_rows(state, static_cast<int64_t>(rows))) {
+        rows_inserted(row + 1, rows);
+    }
+}
+
+auto TreeRows::collapse(size_t row) -> void {
+    if (row >= get_count()) {
+        return;
+    }
+    auto state = state_at(row);
+    if (!states[state].is_expanded) {
+        return;
+    }
+    auto rows = states[state].rows;
+    if (rows != 0) {
+        add_rows(state, -static_cast<int64_t>(rows));
+    }
+    states[state].is_expanded = false;
+    if (rows != 0) {
+        rows_removed(row + 1, rows);
+    }
+    rows_changed(row, 1);
+}
+
+auto TreeRows::fetch(uint32_t state) -> void {
+    states[state].is_loading = true;
+    auto weak = weak_from_this();
+    auto done = [weak, state](std::vector<TreeModel::Node> children) {
+        if (auto rows = weak.lock()) {
+            rows->set_children(state, children);
+        }
+    };
+    model->fetch_children(states[state].node, done);
+}
+
+auto TreeRows::set_children(uint32_t state, const std::vector<TreeModel::Node> &children)
+    -> void {
+    if (states[state].is_loaded) {
+        return;
+    }
+
+    // Every child takes a single row, the Fenwick tree is built in one pass
+    auto first = static_cast<uint32_t>(states.size());
+    auto count = static_cast<uint32_t>(children.size());
+    auto depth = states[state].depth + 1;
+    states.reserve(states.size() + count);
+    for (auto node : children) {
+        auto child = NodeState{};
+        child.node = node;
+        child.parent = state;
+        child.depth = depth;
+        states.push_back(child);
+    }
+    for (uint32_t i = 1; i <= count; i++) {
+        states[first + i - 1].fenwick += 1;
+        auto next = i + (i & (~i + 1));
+        if (next <= count) {
+            states[first + next - 1].fenwick += states[first + i - 1].fenwick;
+        }
+    }
+
+    auto &parent = states[state];
+    parent.first_child = first;
+    parent.child_count = count;
+    parent.is_loaded = true;
+    parent.is_loading = false;
+    parent.rows = count;
+    if (!parent.is_expanded) {
+        return;
+    }
+    if (state == 0) {
+        rows_inserted(0, count);
+        return;
+    }
+
+    // The parent was expanded while loading, its rows appear now
+    if (!add_rows(state, count)) {
+        return;
+    }
+    auto row = row_of(state);
+    rows_changed(row, 1);
+    if (count != 0) {
+        rows_inserted(row + 1, count);
+    }
+}
+
+auto TreeRows::prefix(uint32_t parent, uint32_t child) const -> size_t {
+    auto first = states[parent].first_child;
+    auto sum = size_t(0);
+    for (auto i = child; i > 0; i -= i & (~i + 1)) {
+        sum += states[first + i - 1].fenwick;
+    }
+    return sum;
+}
+
+// Each level finds the child which holds the row by walking down the Fenwick tree
+auto TreeRows::state_at(size_t row) const -> uint32_t {
+    auto state = uint32_t(0);
+    while (true) {
+        auto &node = states[state];
+        auto count = node.child_count;
+        if (count == 0) {
+            return state;
+        }
+        auto step = uint32_t(1);
+        while (step * 2 <= count) {
+            step *= 2;
+        }
+        auto position = uint32_t(0);
+        for (; step > 0; step /= 2) {
+            auto next = position + step;
+            if (next <= count && states[node.first_child + next - 1].fenwick <= row) {
+                position = next;
+                row -= states[node.first_child + next - 1].fenwick;
+            }
+        }
+        auto child = node.first_child + std::min(position, count - 1);
+        if (row == 0) {
+            return child;
+        }
+        row--;
+        state = child;
+    }
+}
+
+auto TreeRows::row_of(uint32_t state) const -> size_t {
+    auto row = size_t(0);
+    while (state != 0) {
+        auto parent = states[state].parent;
+        row += prefix(parent, state - states[parent].first_child);
+        if (parent != 0) {
+            row++;
+        }
+        state = parent;
+    }
+    return row;
+}
+
+// The size of `state` in its parent changed, and so did the rows of every parent up to the
+// first collapsed one
+auto TreeRows::add_rows(uint32_t state, int64_t delta) -> bool {
+    while (state != 0) {
+        auto parent = states[state].parent;
+        auto first = states[parent].first_child;
+        auto count = states[parent].child_count;
+        for (auto i = state - first + 1; i <= count; i += i & (~i + 1)) {
+            states[first + i - 1].fenwick += delta;
+        }
+        states[parent].rows += delta;
+        if (!states[parent].is_expanded) {
+            return false;
+        }
+        state = parent;
+    }
+    return true;
+}
+
+auto TreeItemWidget::draw() -> void {
+    auto t = get_theme();
+    t->draw_listview_item(content, {}, status, mouse_over);
+
+    auto indent = content.size.height;
+    auto x = depth * indent;
+    auto color = status.is_selected ? t->colors.text_selection_color : t->colors.text_color;
+    if (has_children) {
+        auto center = Position{x + indent / 2, content.size.height / 2};
+        auto half = std::max(indent / 4, 3);
+        content.draw_rectangle(center.x - half, center.y - half, half * 2 + 1, half * 2 + 1,
+                               color, color);
+        content.line(center.x - half + 2, center.y, center.x + half - 2, center.y, color);
+        if (!is_expanded) {
+            content.line(center.x, center.y - half + 2, center.x, center.y + half - 2, color);
+        }
+    }
+
+    auto text_size = t->font->text_size(text);
+    auto position = content.size.centeredY(text_size, x + indent);
+    t->draw_text(content, position, text, color);
+    if (is_loading) {
+        position.x += text_size.width;
+        t->draw_text(content, position, " ...", color);
+    }
+}
+
+TreeView::TreeView() : TreeView({}, {}) {}
+
+TreeView::TreeView(Position position, Size size) : ListView(position, size) {}
+
+auto TreeView::set_model(std::shared_ptr<TreeModel> model) -> void {
+    rows = TreeRows::create(model);
+    adapter = rows;
+    current_item = 0;
+    did_adapter_update();
+}
+
+auto TreeView::expand(size_t row) -> void {
+    if (rows) {
+        rows->expand(row);
+    }
+}
+
+auto TreeView::collapse(size_t row) -> void {
+    if (!rows) {
+        return;
+    }
+
+    // The current row moves to the collapsed node, instead of the row after it
+    auto current = static_cast<size_t>(current_item);
+    auto count = rows->get_count();
+    rows->collapse(row);
+    auto removed = count - rows->get_count();
+    if (current > row && current <= row + removed) {
+        current_item = static_cast<int>(row);
+        if (selection_mode == SelectionMode::Single) {
+            selection.select_only(row, row + 1);
+        }
+    }
+}
+
+auto TreeView::on_mouse_click(const EventMouse &event) -> EventPropagation {
+    auto result = ListView::on_mouse_click(event);
+    if (!rows || !event.pressed || event.button != 1 || !event.is_local) {
+        return result;
+    }
+
+    // Clicking the expander of a row toggles it
+    auto height = get_item_height();
+    if (get_scroll_offset() + event.y >= static_cast<int64_t>(rows->get_count()) * height) {
+        return result;
+    }
+    auto row = static_cast<size_t>(current_item);
+    auto x = rows->get_depth(row) * height;
+    if (event.x >= x && event.x < x + height) {
+        if (rows->is_expanded(row)) {
+            collapse(row);
+        } else {
+            expand(row);
+        }
+    }
+    return result;
+}
+
+auto TreeView::on_keyboard(const EventKeyboard &event) -> EventPropagation {
+    if (!rows || rows->get_count() == 0) {
+        return ListView::on_keyboard(event);
+    }
+
+    auto row = static_cast<size_t>(current_item);
+    switch (event.key) {
+    case KeyCodes::ArrowRight: {
+        if (!rows->is_expanded(row)) {
+            expand(row);
+            return EventPropagation::handled;
+        }
+        auto down = event;
+        down.key = KeyCodes::ArrowDown;
+        return ListView::on_keyboard(down);
+    }
+    case KeyCodes::ArrowLeft: {
+        if (rows->is_expanded(row)) {
+            collapse(row);
+            return EventPropagation::handled;
+        }
+        auto parent = rows->get_parent_row(row);
+        if (parent >= 0) {
+            current_item = static_cast<int>(parent);
+            if (selection_mode == SelectionMode::Single) {
+                selection.select_only(current_item, current_item + 1);
+            }
+            ensure_item_visible(current_item);
+            invalidate();
+            if (on_item_selected) {
+                on_item_selected(*this, current_item, SelectionReason::KeyboardMove);
+            }
+        }
+        return EventPropagation::handled;
+    }
+    default:
+        return ListView::on_keyboard(event);
+    }
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <listview.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// A hierarchy whose children are only asked for when their parent is first expanded.
+// Nodes are ids chosen by the model, `root` is the hidden parent of the top level nodes.
+struct TreeModel {
+    using Node = uint64_t;
+    using Children = std::function<void(std::vector<Node> children)>;
+    static constexpr Node root = 0;
+
+    virtual ~TreeModel() = default;
+    virtual auto get_text(Node node) const -> std::string_view = 0;
+    virtual auto has_children(Node node) const -> bool = 0;
+
+    // Called once per node. `done` may be called right away, or later from the UI thread,
+    // for example after loading the children on a worker and posting them back.
+    virtual auto fetch_children(Node node, Children done) -> void = 0;
+};
+
+// The rows of a tree, as a list: every node whose parents are all expanded, in order.
+// Each loaded node keeps a Fenwick tree over the rows taken by each of its children, so
+// expanding or collapsing a node costs O(depth * log(children)), and finding the node of a
+// row costs the same. Children are kept after collapsing, expanding again is immediate.
+struct TreeRows : ItemAdapter, std::enable_shared_from_this<TreeRows> {
+    // Starts loading the top level nodes
+    static auto create(std::shared_ptr<TreeModel> model) -> std::shared_ptr<TreeRows>;
+
+    virtual auto get_count() const -> size_t override { return states.front().rows; }
+    virtual auto get_widget(size_t position, Theme &theme) -> PWidget override;
+    virtual auto set_content(PWidget widget, size_t position, ItemStatus status) -> void override;
+    virtual auto get_item_height(size_t position, Theme &theme) -> int override;
+    virtual auto get_text(size_t position) const -> std::string_view override;
+
+    auto get_model() const -> std::shared_ptr<TreeModel> { return model; }
+    auto get_node(size_t row) const -> TreeModel::Node;
+    auto get_depth(size_t row) const -> int;
+    auto is_expanded(size_t row) const -> bool;
+    auto is_loading(size_t row) const -> bool;
+
+    // The row of the parent of `row`, or -1 for top level nodes
+    auto get_parent_row(size_t row) const -> int64_t;
+
+    // Rows below are inserted or removed, views are told about it as with any adapter
+    auto expand(size_t row) -> void;
+    auto collapse(size_t row) -> void;
+
+  private:
+    struct NodeState {
+        TreeModel::Node node = TreeModel::root;
+        uint32_t parent = 0;
+        uint32_t first_child = 0;
+        uint32_t child_count = 0;
+        int depth = -1;
+
+        // Rows under this node while it is expanded
+        size_t rows = 0;
+
+        // Slot of this node in the Fenwick tree of its parent
+        size_t fenwick = 0;
+
+        bool is_expanded = false;
+        bool is_loaded = false;
+        bool is_loading = false;
+    };
+
+    explicit TreeRows(std::shared_ptr<TreeModel> model);
+
+    // Rows taken by a node in its parent, itself and its children when expanded
+    auto get_size(const NodeState &state) const -> size_t {
+        return 1 + (state.is_expanded ? state.rows : 0);
+    }
+    auto prefix(uint32_t parent, uint32_t child) const -> size_t;
+    auto state_at(size_t row) const -> uint32_t;
+    auto row_of(uint32_t state) const -> size_t;
+
+    // The rows taken by `state` changed, its parents are updated up to the first collapsed one.
+    // Returns false if one of them is collapsed, the rows of the list did not change.
+    auto add_rows(uint32_t state, int64_t delta) -> bool;
+    auto fetch(uint32_t state) -> void;
+    auto set_children(uint32_t state, const std::vector<TreeModel::Node> &children) -> void;
+
+    std::shared_ptr<TreeModel> model;
+
+    // The first one is the root. Children of a node are stored next to each other.
+    std::vector<NodeState> states;
+};
+
+struct TreeItemWidget : ListItemWidget {
+    int depth = 0;
+    bool has_children = false;
+    bool is_expanded = false;
+    bool is_loading = false;
+
+    using ListItemWidget::ListItemWidget;
+    virtual auto draw() -> void override;
+};
+
+// A list view of the rows of a tree model. Rows are virtualized and recycled by the list
+// view, expanding or collapsing a node inserts or removes only the rows under it.
+struct TreeView : ListView {
+    TreeView();
+    TreeView(Position position, Size size);
+
+    auto set_model(std::shared_ptr<TreeModel> model) -> void;
+    auto get_rows() const -> std::shared_ptr<TreeRows> { return rows; }
+
+    auto expand(size_t row) -> void;
+    auto collapse(size_t row) -> void;
+
+    virtual auto on_mouse_click(const EventMouse &event) -> EventPropagation override;
+    virtual auto on_keyboard(const EventKeyboard &) -> EventPropagation override;
+
+  private:
+    std::shared_ptr<TreeRows> rows;
+};
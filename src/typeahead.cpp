@@ -0,0 +1,120 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "typeahead.h"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+static auto to_lower(char c) -> char { return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c; }
+
+// Compares at most the length of `prefix`, so all the texts starting with it are equal to it
+static auto compare_prefix(std::string_view text, std::string_view prefix) -> int {
+    auto length = std::min(text.size(), prefix.size());
+    for (size_t i = 0; i < length; i++) {
+        auto c1 = static_cast<unsigned char>(to_lower(text[i]));
+        auto c2 = static_cast<unsigned char>(to_lower(prefix[i]));
+        if (c1 != c2) {
+            return c1 < c2 ? -1 : 1;
+        }
+    }
+    return text.size() < prefix.size() ? -1 : 0;
+}
+
+static auto is_before(std::string_view text1, size_t row1, std::string_view text2, size_t row2)
+    -> bool {
+    auto length = std::min(text1.size(), text2.size());
+    auto result = compare_prefix(text1.substr(0, length), text2.substr(0, length));
+    if (result != 0) {
+        return result < 0;
+    }
+    if (text1.size() != text2.size()) {
+        return text1.size() < text2.size();
+    }
+    return row1 < row2;
+}
+
+auto TypeAhead::on_key(std::string_view text, size_t count, const GetText &get_text,
+                       int current_row) -> int {
+    if (text.empty()) {
+        return -1;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_key > timeout) {
+        typed.clear();
+    }
+    if (text == " " && typed.empty()) {
+        return -1;
+    }
+    last_key = now;
+    typed += text;
+    if (!is_valid || sorted_rows.size() != count) {
+        build(count, get_text);
+    }
+
+    auto current = static_cast<size_t>(current_row);
+    auto [first, last] = find(typed, get_text);
+    if (first != last) {
+        // Refining keeps the current row while it still matches
+        auto position = current < count ? position_of(current, get_text) : last;
+        if (position >= first && position < last) {
+            return current_row;
+        }
+        return static_cast<int>(sorted_rows[first]);
+    }
+
+    // The same letter typed again cycles between the rows starting with it
+    auto is_repeated = std::all_of(typed.begin(), typed.end(),
+                                   [this](char c) { return to_lower(c) == to_lower(typed[0]); });
+    if (!is_repeated) {
+        return -1;
+    }
+    std::tie(first, last) = find(typed.substr(0, 1), get_text);
+    if (first == last) {
+        return -1;
+    }
+    auto position = current < count ? position_of(current, get_text) : last;
+    if (position < first || position + 1 >= last) {
+        return static_cast<int>(sorted_rows[first]);
+    }
+    return static_cast<int>(sorted_rows[position + 1]);
+}
+
+auto TypeAhead::invalidate() -> void {
+    is_valid = false;
+    typed.clear();
+}
+
+auto TypeAhead::build(size_t count, const GetText &get_text) -> void {
+    sorted_rows.resize(count);
+    std::iota(sorted_rows.begin(), sorted_rows.end(), size_t(0));
+    std::sort(sorted_rows.begin(), sorted_rows.end(), [&get_text](size_t row1, size_t row2) {
+        return is_before(get_text(row1), row1, get_text(row2), row2);
+    });
+    is_valid = true;
+}
+
+auto TypeAhead::find(std::string_view prefix, const GetText &get_text) const
+    -> std::pair<size_t, size_t> {
+    auto first = std::partition_point(sorted_rows.begin(), sorted_rows.end(), [&](size_t row) {
+        return compare_prefix(get_text(row), prefix) < 0;
+    });
+    auto last = std::partition_point(first, sorted_rows.end(), [&](size_t row) {
+        return compare_prefix(get_text(row), prefix) == 0;
+    });
+    return {first - sorted_rows.begin(), last - sorted_rows.begin()};
+}
+
+// Where `row` is in the index
+auto TypeAhead::position_of(size_t row, const GetText &get_text) const -> size_t {
+    auto text = get_text(row);
+    auto found = std::partition_point(sorted_rows.begin(), sorted_rows.end(), [&](size_t other) {
+        return is_before(get_text(other), other, text, row);
+    });
+    return found - sorted_rows.begin();
+}
@@ -0,0 +1,44 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Finds rows by the start of their text, as typed by the user. The index is a permutation of
+// the rows sorted by text, ignoring ASCII case, built on first use. Each key is then a binary
+// search. Keys typed within `timeout` of each other refine the search, typing the same letter
+// again moves to the next row starting with it.
+struct TypeAhead {
+    using GetText = std::function<std::string_view(size_t row)>;
+
+    std::chrono::milliseconds timeout = std::chrono::milliseconds(1000);
+
+    // `text` is what the key typed. Returns the row to select, or -1 when nothing matches.
+    // A space only counts once something was typed, so it can still be used by the view.
+    auto on_key(std::string_view text, size_t count, const GetText &get_text, int current_row)
+        -> int;
+
+    // Call when the rows change, the index is built again on the next key
+    auto invalidate() -> void;
+
+  private:
+    auto build(size_t count, const GetText &get_text) -> void;
+    auto find(std::string_view prefix, const GetText &get_text) const -> std::pair<size_t, size_t>;
+    auto position_of(size_t row, const GetText &get_text) const -> size_t;
+
+    std::vector<size_t> sorted_rows;
+    bool is_valid = false;
+    std::string typed;
+    std::chrono::steady_clock::time_point last_key;
+};
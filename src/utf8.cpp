@@ -0,0 +1,178 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "utf8.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SVISION_UTF8_SSE2
+#endif
+
+auto utf8_decode(std::string_view::const_iterator &it, std::string_view::const_iterator end)
+    -> char32_t {
+    auto lead = static_cast<unsigned char>(*it);
+    ++it;
+    if (lead < 0x80) {
+        return lead;
+    }
+
+    auto needed = 0;
+    auto code_point = char32_t{0};
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        needed = 1;
+        code_point = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        needed = 2;
+        code_point = lead & 0x0F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        needed = 3;
+        code_point = lead & 0x07;
+    } else {
+        // continuation byte, or a lead byte which can only start an overlong form
+        return utf8_replacement_character;
+    }
+
+    for (auto i = 0; i < needed; i++) {
+        if (it == end) {
+            return utf8_replacement_character;
+        }
+        // The second byte also rules out overlongs, surrogates and values above U+10FFFF
+        auto low = 0x80;
+        auto high = 0xBF;
+        if (i == 0) {
+            switch (lead) {
+            case 0xE0:
+                low = 0xA0;
+                break;
+            case 0xED:
+                high = 0x9F;
+                break;
+            case 0xF0:
+                low = 0x90;
+                break;
+            case 0xF4:
+                high = 0x8F;
+                break;
+            }
+        }
+        auto c = static_cast<unsigned char>(*it);
+        if (c < low || c > high) {
+            return utf8_replacement_character;
+        }
+        code_point = (code_point << 6) | (c & 0x3F);
+        ++it;
+    }
+    return code_point;
+}
+
+auto utf8_ascii_prefix(std::string_view text) -> size_t {
+    auto data = reinterpret_cast<const unsigned char *>(text.data());
+    auto size = text.size();
+    auto i = size_t{0};
+
+#if defined(__AVX2__)
+    for (; i + 32 <= size; i += 32) {
+        auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        if (_mm256_movemask_epi8(chunk) != 0) {
+            break;
+        }
+    }
+#elif defined(SVISION_UTF8_SSE2)
+    for (; i + 16 <= size; i += 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        if (_mm_movemask_epi8(chunk) != 0) {
+            break;
+        }
+    }
+#endif
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        if (word & 0x8080808080808080ull) {
+            break;
+        }
+    }
+    while (i < size && data[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+auto utf8_append(std::string &text, char32_t code_point) -> void {
+    if ((code_point >= 0xD800 && code_point <= 0xDFFF) || code_point > 0x10FFFF) {
+        code_point = utf8_replacement_character;
+    }
+    if (code_point < 0x80) {
+        text += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        text += static_cast<char>(0xC0 | (code_point >> 6));
+        text += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+        text += static_cast<char>(0xE0 | (code_point >> 12));
+        text += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        text += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+        text += static_cast<char>(0xF0 | (code_point >> 18));
+        text += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        text += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        text += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+}
+
+auto Utf16Joiner::push(char16_t unit) -> char32_t {
+    auto high = high_surrogate;
+    high_surrogate = 0;
+    if (unit >= 0xD800 && unit <= 0xDBFF) {
+        high_surrogate = unit;
+        return 0;
+    }
+    if (unit >= 0xDC00 && unit <= 0xDFFF) {
+        if (high == 0) {
+            return utf8_replacement_character;
+        }
+        return 0x10000 + ((static_cast<char32_t>(high) - 0xD800) << 10) + (unit - 0xDC00);
+    }
+    return unit;
+}
+
+auto utf8_next(std::string_view text, size_t offset) -> size_t {
+    if (offset >= text.size()) {
+        return text.size();
+    }
+    auto it = text.begin() + offset;
+    utf8_decode(it, text.end());
+    return it - text.begin();
+}
+
+auto utf8_prev(std::string_view text, size_t offset) -> size_t {
+    if (offset == 0 || text.empty()) {
+        return 0;
+    }
+    offset = std::min(offset, text.size());
+    auto start = offset - 1;
+    auto limit = offset > 4 ? offset - 4 : 0;
+    while (start > limit && (static_cast<unsigned char>(text[start]) & 0xC0) == 0x80) {
+        start--;
+    }
+    // Make sure we landed on a sequence which really ends at `offset`
+    if (utf8_next(text, start) != offset) {
+        return offset - 1;
+    }
+    return start;
+}
+
+auto utf8_length(std::string_view text) -> size_t {
+    auto count = size_t{0};
+    utf8_for_each(text, [&count](char32_t) { count++; });
+    return count;
+}
@@ -0,0 +1,63 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Returned for every malformed or truncated sequence
+constexpr char32_t utf8_replacement_character = 0xFFFD;
+
+// Decodes one code point and advances `it`. Never reads past `end`. Invalid input
+// (overlong forms, surrogates, values above U+10FFFF, truncated sequences) decodes to
+// U+FFFD, consuming the longest valid prefix of the bad sequence.
+auto utf8_decode(std::string_view::const_iterator &it, std::string_view::const_iterator end)
+    -> char32_t;
+
+// Appends the encoding of `code_point` to `text`. Surrogates and values above U+10FFFF are
+// appended as U+FFFD.
+auto utf8_append(std::string &text, char32_t code_point) -> void;
+
+// Joins UTF-16 code units which arrive one at a time, like WM_CHAR messages. `push()` returns
+// the code point once it is complete, and 0 after a high surrogate. A high surrogate not
+// followed by a low one is dropped, a lone low surrogate becomes U+FFFD.
+struct Utf16Joiner {
+    auto push(char16_t unit) -> char32_t;
+
+  private:
+    char16_t high_surrogate = 0;
+};
+
+// Number of leading ASCII bytes in `text`. Checks 16 or 32 bytes per step when SIMD is
+// available.
+auto utf8_ascii_prefix(std::string_view text) -> size_t;
+
+// Byte offsets of the next/previous code point, relative to `offset`
+auto utf8_next(std::string_view text, size_t offset) -> size_t;
+auto utf8_prev(std::string_view text, size_t offset) -> size_t;
+
+// Number of code points in `text`
+auto utf8_length(std::string_view text) -> size_t;
+
+// Calls `callback(char32_t)` for every code point in `text`. ASCII runs are found in bulk
+// and passed through without decoding.
+template <typename Callback>
+auto utf8_for_each(std::string_view text, Callback &&callback) -> void {
+    auto it = text.begin();
+    const auto end = text.end();
+    while (it != end) {
+        auto ascii = utf8_ascii_prefix(std::string_view(&*it, end - it));
+        for (const auto run_end = it + ascii; it != run_end; ++it) {
+            callback(static_cast<char32_t>(*it));
+        }
+        if (it != end) {
+            callback(utf8_decode(it, end));
+        }
+    }
+}
@@ -12,6 +12,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+
 static auto point_in_rect(Position p, Size s, int x, int y) -> bool {
     if (x < p.x) {
         return false;
@@ -47,17 +49,27 @@ auto WidgetCollection::add(std::shared_ptr<Widget> widget, PlatformWindow *windo
     }
     widget->window = window;
     if (widget->focus_index < 0) {
-        if (window) {
-            widget->focus_index = max_focus_index;
-            widget->theme = window->main_widget.theme;
-        } else {
-            widget->focus_index = max_focus_index;
-        }
+        widget->focus_index = max_focus_index;
         max_focus_index++;
     }
     return widget;
 }
 
+auto WidgetCollection::remove(std::shared_ptr<Widget> widget) -> void {
+    auto it = std::find(widgets.begin(), widgets.end(), widget);
+    if (it == widgets.end()) {
+        return;
+    }
+    if (last_overed_widget == widget) {
+        last_overed_widget.reset();
+    }
+    if (focused_widget == widget) {
+        focused_widget.reset();
+    }
+    widget->on_remove();
+    widgets.erase(it);
+}
+
 // TODO - if we move this widget collection back into widget, the last argument is no longer needed
 auto WidgetCollection::on_mouse(const EventMouse &event, Widget &myself) -> EventPropagation {
     auto widget_under_mouse = std::shared_ptr<Widget>();
@@ -346,14 +358,42 @@ auto Widget::invalidate() -> void {
         return;
     }
     this->needs_redraw = true;
+    // Only the path up to an updating widget is marked, it passes the request on when done
+    if (update_depth > 0) {
+        return;
+    }
     if (this->parent && !this->parent->needs_redraw) {
         this->parent->invalidate();
     }
-    if (this->window && !this->window->needs_redraw) {
+    if (this->window && !this->window->needs_redraw && !is_updating()) {
         this->window->invalidate();
     }
 }
 
+auto Widget::end_update() -> void {
+    assert(update_depth > 0);
+    update_depth--;
+    if (update_depth > 0 || is_updating()) {
+        return;
+    }
+    if (window && window->main_widget.layout) {
+        window->relayout();
+    }
+    if (needs_redraw) {
+        needs_redraw = false;
+        invalidate();
+    }
+}
+
+auto Widget::is_updating() const -> bool {
+    for (auto w = this; w; w = w->parent) {
+        if (w->update_depth > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 auto Widget::draw() -> void {
     if (draw_background) {
         if (content.background_color != 0) {
@@ -366,10 +406,7 @@ auto Widget::draw() -> void {
         if (!w->is_visible()) {
             continue;
         }
-        if (w->needs_redraw) {
-            w->draw();
-            w->needs_redraw = false;
-        }
+        w->draw_if_needed();
         content.draw(w->position, w->content);
     }
 
@@ -441,42 +478,78 @@ auto Widget::on_resize() -> void {
     }
 }
 
-auto Widget::get_theme() const -> std::shared_ptr<Theme> {
+auto Widget::on_theme_changed() -> void {}
+
+auto Widget::get_theme() const -> Theme * {
     if (theme) {
-        return theme;
+        return theme.get();
+    }
+    if (resolved_theme) {
+        return resolved_theme;
     }
     auto p = parent;
     while (p) {
         if (p->theme) {
-            return p->theme;
+            resolved_theme = p->theme.get();
+            return resolved_theme;
         }
         p = p->parent;
     }
     if (window) {
-        return window->main_widget.theme;
+        resolved_theme = window->main_widget.theme.get();
     }
-    return {};
+    return resolved_theme;
 }
 
 auto Widget::get_cursor() const -> MouseCursor {
     if (mouse_cursor != MouseCursor::Inherit) {
         return mouse_cursor;
     }
+    if (resolved_cursor != MouseCursor::Inherit) {
+        return resolved_cursor;
+    }
     auto p = parent;
     while (p) {
         if (p->mouse_cursor != MouseCursor::Inherit) {
-            return p->mouse_cursor;
+            resolved_cursor = p->mouse_cursor;
+            return resolved_cursor;
         }
         p = p->parent;
     }
     return MouseCursor::Inherit;
 }
 
+auto Widget::set_theme(std::shared_ptr<Theme> new_theme) -> void {
+    theme = new_theme;
+    forget_resolved();
+    invalidate();
+}
+
+auto Widget::set_cursor(MouseCursor new_cursor) -> void {
+    mouse_cursor = new_cursor;
+    forget_resolved();
+}
+
+auto Widget::set_parent(Widget *new_parent) -> void {
+    parent = new_parent;
+    forget_resolved();
+}
+
+auto Widget::forget_resolved() -> void {
+    resolved_theme = nullptr;
+    resolved_cursor = MouseCursor::Inherit;
+    invalidate_size_hint();
+    for (auto &w : widgets.widgets) {
+        w->forget_resolved();
+    }
+}
+
 auto Widget::show() -> void {
     if (is_visible()) {
         return;
     }
     is_widget_visible = true;
+    invalidate_size_hint();
     invalidate();
 }
 
@@ -485,6 +558,7 @@ auto Widget::hide() -> void {
         return;
     }
     is_widget_visible = false;
+    invalidate_size_hint();
     invalidate();
 }
 
@@ -499,6 +573,12 @@ auto Widget::get_padding() const -> LayoutParams {
     return {};
 }
 
+auto Widget::set_padding_style(PaddingStyle new_style) -> void {
+    padding_style = new_style;
+    invalidate_size_hint();
+    invalidate();
+}
+
 PlatformWindow::PlatformWindow() {
     main_widget.layout = std::make_shared<VerticalLayout>();
     main_widget.layout->padding.set_vertical(5);
@@ -603,12 +683,65 @@ auto PlatformWindow::on_resize(const EventResize &event) -> void {
     }
 }
 
+auto PlatformWindow::set_theme(std::shared_ptr<Theme> new_theme) -> void {
+    auto old_theme = main_widget.theme;
+    if (old_theme == new_theme && new_theme) {
+        // Same theme, modified in place
+        new_theme->invalidate_cache();
+    }
+
+    // Marked upfront, so widgets invalidating themselves while being notified do not post
+    // more repaints
+    needs_redraw = true;
+    main_widget.theme = new_theme;
+    apply_theme(main_widget, old_theme.get(), new_theme);
+    if (main_widget.layout) {
+        relayout();
+    }
+    if (platform) {
+        platform->invalidate(*this);
+    }
+}
+
+auto PlatformWindow::apply_theme(Widget &widget, const Theme *old_theme,
+                                 const std::shared_ptr<Theme> &new_theme) -> void {
+    // Widgets given the window theme explicitly follow the window, widgets with a theme of
+    // their own keep it.
+    if (widget.theme && widget.theme.get() == old_theme) {
+        widget.theme = new_theme;
+    }
+    widget.resolved_theme = nullptr;
+    widget.invalidate_size_hint();
+    widget.needs_redraw = true;
+    widget.on_theme_changed();
+    for (auto &w : widget.widgets.widgets) {
+        apply_theme(*w, old_theme, new_theme);
+    }
+}
+
 auto PlatformWindow::invalidate() -> void {
     assert(platform);
     this->needs_redraw = true;
+    if (update_depth > 0) {
+        return;
+    }
     platform->invalidate(*this);
 };
 
+auto PlatformWindow::end_update() -> void {
+    assert(update_depth > 0);
+    update_depth--;
+    if (update_depth > 0) {
+        return;
+    }
+    if (main_widget.layout) {
+        relayout();
+    }
+    if (needs_redraw && platform) {
+        platform->invalidate(*this);
+    }
+}
+
 auto PlatformWindow::on_close() -> void {
     for (auto &w : main_widget.widgets.widgets) {
         if (w) {
@@ -21,6 +21,17 @@
 struct Theme;
 struct Widget;
 
+// Calls `begin_update()` on a widget or a window, and `end_update()` when it goes out of scope
+template <typename T> struct UpdateScope {
+    explicit UpdateScope(T &target) : target(target) { target.begin_update(); }
+    ~UpdateScope() { target.end_update(); }
+    UpdateScope(const UpdateScope &) = delete;
+    auto operator=(const UpdateScope &) -> UpdateScope & = delete;
+
+  private:
+    T &target;
+};
+
 struct WidgetCollection {
     std::vector<std::shared_ptr<Widget>> widgets;
     std::shared_ptr<Widget> last_overed_widget;
@@ -44,15 +55,12 @@ struct Widget : std::enable_shared_from_this<Widget>, LayoutItem {
     Bitmap content;
     Position position;
     WidgetCollection widgets;
-    std::shared_ptr<Theme> theme;
     Frame frame{FrameStyles::NoFrame, FrameSize::SingleFrame};
     std::shared_ptr<LayoutItem> layout;
-    MouseCursor mouse_cursor = MouseCursor::Inherit;
     PaddingStyle padding_style = PaddingStyle::Label;
 
     // TODO this should be a weak pointer
     PlatformWindow *window = nullptr;
-    Widget *parent = nullptr;
 
     bool draw_background = true;
     bool read_external_mouse_events = false;
@@ -77,6 +85,11 @@ struct Widget : std::enable_shared_from_this<Widget>, LayoutItem {
     virtual auto on_keyboard(const EventKeyboard &) -> EventPropagation;
     virtual auto on_remove() -> void;
     virtual auto on_resize() -> void;
+
+    // Called when the window changes its theme. Widgets keeping values computed from the theme
+    // (colors, item sizes) should refresh them here. There is no need to invalidate, the window
+    // is laid out and repainted once after all widgets were notified.
+    virtual auto on_theme_changed() -> void;
     virtual auto size_hint() const -> Size override { return {0, 0}; };
     virtual auto ignore_layout() const -> bool override { return !is_widget_visible; }
 
@@ -86,7 +99,7 @@ struct Widget : std::enable_shared_from_this<Widget>, LayoutItem {
         if (layout) {
             layout->add(widget);
         }
-        widget->parent = this;
+        widget->set_parent(this);
         return widget;
     }
 
@@ -104,19 +117,51 @@ struct Widget : std::enable_shared_from_this<Widget>, LayoutItem {
         if (layout) {
             layout->add(widget);
         }
-        // TODO - this needs to be a setter - do we can set all children's window as well
-        widget->parent = this;
+        widget->set_parent(this);
         return widget;
     }
 
-    auto get_theme() const -> std::shared_ptr<Theme>;
+    // Both are resolved up the parent chain once, and cached until the widget is reparented,
+    // or a theme or cursor is assigned with the setters below
+    auto get_theme() const -> Theme *;
     auto get_cursor() const -> MouseCursor;
+    auto set_theme(std::shared_ptr<Theme> new_theme) -> void;
+    auto set_cursor(MouseCursor new_cursor) -> void;
+    auto get_parent() const -> Widget * { return parent; }
+    auto set_parent(Widget *new_parent) -> void;
     auto show() -> void;
     auto hide() -> void;
     auto is_visible() const -> bool { return is_widget_visible; }
+
+    // Draws into `content` if invalidated since the last draw, or when forced. Returns true
+    // if the content was drawn.
+    auto draw_if_needed(bool force = false) -> bool {
+        if (!needs_redraw && !force) {
+            return false;
+        }
+        draw();
+        needs_redraw = false;
+        return true;
+    }
+
+    // Invalidations of this widget and its children are held back until the matching
+    // `end_update()`. The outermost one lays out the window once, and requests a single repaint
+    // of what was invalidated. Scopes nest, prefer `UpdateScope` to pair the calls.
+    auto begin_update() -> void { update_depth++; }
+    auto end_update() -> void;
+    auto is_updating() const -> bool;
     auto get_padding() const -> LayoutParams;
+    auto set_padding_style(PaddingStyle new_style) -> void;
 
     auto relayout(Position new_position, const Size size) -> void override {
+        if (layout) {
+            layout->parent_item = this;
+        }
+        if (!needs_layout && position == new_position && content.size == size) {
+            return;
+        }
+        needs_layout = false;
+
         auto has_new_size = (content.size != size);
         this->position = new_position;
 
@@ -140,6 +185,17 @@ struct Widget : std::enable_shared_from_this<Widget>, LayoutItem {
   protected:
     bool needs_redraw = true;
     bool is_widget_visible = true;
+
+  private:
+    auto forget_resolved() -> void;
+
+    std::shared_ptr<Theme> theme;
+    MouseCursor mouse_cursor = MouseCursor::Inherit;
+    Widget *parent = nullptr;
+    int update_depth = 0;
+
+    mutable Theme *resolved_theme = nullptr;
+    mutable MouseCursor resolved_cursor = MouseCursor::Inherit;
 };
 
 struct PlatformWindow {
@@ -182,9 +238,22 @@ struct PlatformWindow {
     auto set_override_cursor(MouseCursor cursor) -> void;
 
     virtual auto relayout() -> void {
+        if (update_depth > 0) {
+            return;
+        }
         main_widget.layout->relayout({0, 0}, main_widget.content.size);
     }
 
+    // While updating, relayouts and repaint requests of the window are dropped. The outermost
+    // `end_update()` lays out the window once, and posts one repaint if anything was
+    // invalidated.
+    auto begin_update() -> void { update_depth++; }
+    auto end_update() -> void;
+
+    // Switches the theme of this window, and of all the widgets which inherit it. Widgets are
+    // notified in a single pass, followed by one relayout and one repaint of the window.
+    auto set_theme(std::shared_ptr<Theme> new_theme) -> void;
+
     virtual auto draw() -> void;
     virtual auto on_keyboard(const EventKeyboard &) -> void;
     virtual auto on_mouse(const EventMouse &) -> void;
@@ -207,4 +276,10 @@ struct PlatformWindow {
         -> std::shared_ptr<T> {
         return main_widget.add_new_to_layout<T>(layout, std::forward<Args>(args)...);
     }
+
+  private:
+    int update_depth = 0;
+
+    auto apply_theme(Widget &widget, const Theme *old_theme,
+                     const std::shared_ptr<Theme> &new_theme) -> void;
 };
@@ -0,0 +1,66 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <bitmap.h>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+
+// The reference: one blend_pixel() per covered pixel
+static auto blend_mask_reference(Bitmap &bitmap, const AlphaMask &mask, Position position,
+                                 uint32_t color) -> void {
+    for (auto y = 0; y < mask.size.height; y++) {
+        for (auto x = 0; x < mask.size.width; x++) {
+            auto alpha = mask.buffer[y * mask.size.width + x];
+            if (alpha != 0) {
+                bitmap.blend_pixel(position.x + x, position.y + y, color, alpha);
+            }
+        }
+    }
+}
+
+TEST_CASE("Alpha mask blending", "[bitmap]") {
+    auto random = std::mt19937(1234);
+    auto byte = std::uniform_int_distribution<int>(0, 255);
+
+    for (auto width : {1, 3, 4, 7, 8, 9, 16, 33}) {
+        auto mask = AlphaMask();
+        mask.resize(width, 5);
+        for (auto &alpha : mask.buffer) {
+            // mostly empty and solid runs, like glyphs
+            auto kind = byte(random);
+            alpha = kind < 80 ? 0 : kind < 160 ? 255 : byte(random);
+        }
+
+        for (auto position : {Position{0, 0}, Position{-2, -1}, Position{10, 4}, Position{-40, 0},
+                              Position{15, 15}}) {
+            auto expected = Bitmap();
+            expected.resize(20, 8);
+            for (auto &pixel : expected.buffer) {
+                pixel = static_cast<uint32_t>(random());
+            }
+            auto actual = expected;
+            blend_mask_reference(expected, mask, position, 0x00336699);
+            actual.blend_mask(mask, position, 0x00336699);
+            REQUIRE(actual.buffer == expected.buffer);
+        }
+    }
+}
+
+TEST_CASE("Scrolling moves pixels in both directions", "[bitmap]") {
+    auto bitmap = Bitmap();
+    bitmap.resize(4, 3);
+    for (auto i = 0u; i < bitmap.buffer.size(); i++) {
+        bitmap.buffer[i] = i;
+    }
+
+    bitmap.scroll_horizontally(1);
+    REQUIRE(bitmap.buffer == std::vector<uint32_t>{1, 2, 3, 3, 5, 6, 7, 7, 9, 10, 11, 11});
+    bitmap.scroll_horizontally(-2);
+    REQUIRE(bitmap.buffer == std::vector<uint32_t>{1, 2, 1, 2, 5, 6, 5, 6, 9, 10, 9, 10});
+    bitmap.scroll_vertically(1);
+    REQUIRE(bitmap.buffer == std::vector<uint32_t>{5, 6, 5, 6, 9, 10, 9, 10, 9, 10, 9, 10});
+}
@@ -0,0 +1,40 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <fontproviders/fontproviderstb.hpp>
+
+TEST_CASE("Kerning pairs are found after the table grows", "[kerning]") {
+    auto pairs = KerningPairs();
+    auto advance = 0;
+    REQUIRE_FALSE(pairs.find(1, 2, advance));
+
+    // Enough pairs to grow the table a few times, advances may be negative
+    for (auto glyph = 0; glyph < 1000; glyph++) {
+        pairs.insert(glyph, glyph + 1, glyph % 2 == 0 ? -glyph : glyph);
+    }
+    REQUIRE(pairs.size() == 1000);
+    auto wrong_pairs = 0;
+    for (auto glyph = 0; glyph < 1000; glyph++) {
+        if (!pairs.find(glyph, glyph + 1, advance) ||
+            advance != (glyph % 2 == 0 ? -glyph : glyph)) {
+            wrong_pairs++;
+        }
+    }
+    REQUIRE(wrong_pairs == 0);
+
+    // Pairs are ordered, and inserting a pair again replaces its advance
+    REQUIRE_FALSE(pairs.find(2, 1, advance));
+    pairs.insert(10, 11, -3);
+    REQUIRE(pairs.size() == 1000);
+    REQUIRE(pairs.find(10, 11, advance));
+    REQUIRE(advance == -3);
+
+    // Glyph 0 is a valid glyph, not an empty slot
+    REQUIRE(pairs.find(0, 1, advance));
+    REQUIRE(advance == 0);
+}
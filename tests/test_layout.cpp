@@ -0,0 +1,190 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <layout.h>
+
+struct CountingItem : LayoutItem {
+    Size hint = {};
+    Position position = {};
+    Size size = {};
+    mutable int hint_calls = 0;
+    int relayout_calls = 0;
+
+    explicit CountingItem(Size hint) : hint(hint) {}
+
+    virtual auto relayout(Position new_position, const Size new_size) -> void override {
+        position = new_position;
+        size = new_size;
+        relayout_calls++;
+    }
+
+    virtual auto size_hint() const -> Size override {
+        hint_calls++;
+        return hint;
+    }
+};
+
+TEST_CASE("Size hints are computed once", "[layout]") {
+    auto root = VerticalLayout();
+    auto row = root.add(std::make_shared<HorizontalLayout>());
+    auto fixed = row->add(std::make_shared<CountingItem>(Size{50, 20}));
+    auto stretched = row->add(std::make_shared<CountingItem>(Size{0, 20}));
+    auto bottom = root.add(std::make_shared<CountingItem>(Size{0, 0}));
+
+    root.relayout({0, 0}, {200, 100});
+    REQUIRE(fixed->hint_calls == 1);
+    REQUIRE(stretched->hint_calls == 1);
+    REQUIRE(bottom->hint_calls == 1);
+    REQUIRE(fixed->size.width == 50);
+    REQUIRE(stretched->size.width == 150);
+    REQUIRE(stretched->position.x == 50);
+    REQUIRE(bottom->position.y == 20);
+    REQUIRE(bottom->size.height == 80);
+
+    // A new rectangle lays out again, without asking for hints
+    root.relayout({0, 0}, {300, 100});
+    REQUIRE(fixed->hint_calls == 1);
+    REQUIRE(stretched->size.width == 250);
+    REQUIRE(fixed->relayout_calls == 2);
+}
+
+TEST_CASE("Unchanged layouts are skipped", "[layout]") {
+    auto root = VerticalLayout();
+    auto top = root.add(std::make_shared<HorizontalLayout>());
+    auto bottom = root.add(std::make_shared<HorizontalLayout>());
+    auto item1 = top->add(std::make_shared<CountingItem>(Size{50, 20}));
+    auto item2 = bottom->add(std::make_shared<CountingItem>(Size{50, 20}));
+
+    root.relayout({0, 0}, {200, 100});
+    root.relayout({0, 0}, {200, 100});
+    REQUIRE(item1->relayout_calls == 1);
+    REQUIRE(item2->relayout_calls == 1);
+
+    // Only the branch containing the changed item is computed again
+    item1->hint = {80, 30};
+    item1->invalidate_size_hint();
+    root.relayout({0, 0}, {200, 100});
+    REQUIRE(item1->hint_calls == 2);
+    REQUIRE(item1->relayout_calls == 2);
+    REQUIRE(item1->size.height == 30);
+    REQUIRE(item2->hint_calls == 1);
+    REQUIRE(item2->position.y == 30);
+}
+
+TEST_CASE("Layout setters drop the cached measurements", "[layout]") {
+    auto root = HorizontalLayout();
+    auto left = root.add(std::make_shared<CountingItem>(Size{0, 20}));
+    auto right = root.add(std::make_shared<CountingItem>(Size{0, 20}));
+
+    root.relayout({0, 0}, {200, 20});
+    REQUIRE(left->size.width == 100);
+
+    // Same rectangle, the new weight is still applied
+    left->set_weight(3);
+    root.relayout({0, 0}, {200, 20});
+    REQUIRE(left->size.width == 150);
+    REQUIRE(right->position.x == 150);
+
+    auto margin = LayoutParams{};
+    margin.set_horizontal(10);
+    root.set_margin(margin);
+    root.relayout({0, 0}, {200, 20});
+    REQUIRE(left->relayout_calls == 3);
+    REQUIRE(left->position.x == 10);
+}
+
+TEST_CASE("Grid columns fit their widest item", "[layout]") {
+    auto grid = GridLayout(2);
+    auto label = grid.add(std::make_shared<CountingItem>(Size{40, 10}));
+    auto field = grid.add(std::make_shared<CountingItem>(Size{0, 20}));
+    auto wide_label = grid.add(std::make_shared<CountingItem>(Size{60, 10}));
+    auto spanning = grid.add_at(std::make_shared<CountingItem>(Size{0, 0}), 2, 0, 1, 2);
+
+    grid.relayout({0, 0}, {200, 100});
+    REQUIRE(label->size.width == 60);
+    REQUIRE(wide_label->position.y == 20);
+    REQUIRE(field->position.x == 60);
+    REQUIRE(field->size.width == 140);
+    REQUIRE(spanning->position.y == 30);
+    REQUIRE(spanning->size == Size{200, 70});
+
+    // Measurements are kept between passes
+    grid.relayout({0, 0}, {300, 100});
+    REQUIRE(field->size.width == 240);
+    REQUIRE(label->hint_calls == 1);
+
+    // Same rectangle, the new column count is still applied
+    grid.set_columns(3);
+    grid.relayout({0, 0}, {300, 100});
+    REQUIRE(wide_label->position == Position{240, 0});
+    REQUIRE(field->size.width == 200);
+}
+
+TEST_CASE("Flex items grow, shrink and wrap", "[layout]") {
+    auto grow = FlexItem();
+    grow.grow = 1;
+    auto grow_limited = grow;
+    grow_limited.max = {70, 0};
+
+    auto flex = FlexLayout(FlexDirection::Row);
+    auto fixed = flex.add(std::make_shared<CountingItem>(Size{50, 20}));
+    auto growing = flex.add_flex(std::make_shared<CountingItem>(Size{50, 20}), grow);
+    auto limited = flex.add_flex(std::make_shared<CountingItem>(Size{50, 20}), grow_limited);
+
+    flex.relayout({0, 0}, {250, 40});
+    REQUIRE(fixed->size == Size{50, 40});
+    REQUIRE(limited->size.width == 70);
+    REQUIRE(growing->size.width == 100);
+    REQUIRE(limited->position.x == 150);
+
+    flex.relayout({0, 0}, {120, 40});
+    REQUIRE(fixed->size.width == 40);
+    REQUIRE(limited->position.x == 80);
+
+    flex.set_wrap(true);
+    flex.set_align(FlexAlign::Start);
+    flex.relayout({0, 0}, {110, 60});
+    REQUIRE(limited->position == Position{0, 20});
+    REQUIRE(growing->size.width == 60);
+    REQUIRE(limited->size == Size{70, 20});
+
+    // Same rectangle, the new justification is still applied
+    auto packed = FlexLayout(FlexDirection::Row);
+    auto first = packed.add(std::make_shared<CountingItem>(Size{50, 20}));
+    packed.add(std::make_shared<CountingItem>(Size{50, 20}));
+    packed.relayout({0, 0}, {200, 20});
+    REQUIRE(first->position.x == 0);
+    packed.set_justify(FlexJustify::End);
+    packed.relayout({0, 0}, {200, 20});
+    REQUIRE(first->position.x == 100);
+}
+
+TEST_CASE("Removing all items drops their grid cells", "[layout]") {
+    auto grid = GridLayout(2);
+    grid.add_at(std::make_shared<CountingItem>(Size{40, 10}), 2, 1);
+    grid.relayout({0, 0}, {200, 100});
+    grid.remove_all();
+    auto first = grid.add(std::make_shared<CountingItem>(Size{40, 10}));
+    auto second = grid.add(std::make_shared<CountingItem>(Size{40, 10}));
+    grid.relayout({0, 0}, {200, 100});
+    REQUIRE(first->position == Position{0, 0});
+    REQUIRE(second->position.y == 0);
+    REQUIRE(second->position.x > 0);
+}
+
+TEST_CASE("Removing all items drops their flex parameters", "[layout]") {
+    auto grow = FlexItem();
+    grow.grow = 1;
+    auto flex = FlexLayout(FlexDirection::Row);
+    flex.add_flex(std::make_shared<CountingItem>(Size{50, 20}), grow);
+    flex.relayout({0, 0}, {200, 20});
+    flex.remove_all();
+    auto fixed = flex.add(std::make_shared<CountingItem>(Size{50, 20}));
+    flex.relayout({0, 0}, {200, 20});
+    REQUIRE(fixed->size.width == 50);
+}
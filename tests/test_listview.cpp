@@ -0,0 +1,256 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "testplatform.h"
+#include <catch2/catch_test_macros.hpp>
+#include <listview.h>
+
+#include <algorithm>
+#include <string>
+
+TEST_CASE("List views follow inserted and removed rows", "[listview]") {
+    auto platform = TestPlatform();
+    auto window = PlatformWindow();
+    window.platform = &platform;
+    window.main_widget.set_theme(
+        std::make_shared<ThemePlasma>(std::make_shared<FontProviderFixed>()));
+    window.main_widget.content.resize(300, 200);
+
+    auto strings = std::vector<std::string>();
+    for (auto i = 0; i < 1000; i++) {
+        strings.push_back("row " + std::to_string(i));
+    }
+    auto adapter = std::make_shared<ListItemAdapter>(strings);
+    auto view = window.add_new<ListView>();
+    view->adapter = adapter;
+    window.relayout();
+    window.draw();
+
+    auto height = int64_t(view->get_item_height());
+    view->set_scroll_offset(100 * height + 5);
+    view->current_item = 150;
+    window.draw();
+    auto current_text = [&]() { return std::string(adapter->get_text(view->current_item)); };
+
+    // Rows above the view push it down, the same rows stay on screen
+    adapter->strings.insert(adapter->strings.begin() + 20, 10, "new");
+    adapter->rows_inserted(20, 10);
+    REQUIRE(view->current_item == 160);
+    REQUIRE(current_text() == "row 150");
+    REQUIRE(view->get_scroll_offset() == 110 * height + 5);
+
+    adapter->strings.erase(adapter->strings.begin(), adapter->strings.begin() + 5);
+    adapter->rows_removed(0, 5);
+    REQUIRE(view->current_item == 155);
+    REQUIRE(view->get_scroll_offset() == 105 * height + 5);
+
+    // Rows below the view move nothing
+    adapter->strings.insert(adapter->strings.begin() + 900, 3, "new");
+    adapter->rows_inserted(900, 3);
+    REQUIRE(view->current_item == 155);
+    REQUIRE(view->get_scroll_offset() == 105 * height + 5);
+
+    // Removing the current row moves it to the first row after the removed ones
+    adapter->strings.erase(adapter->strings.begin() + 150, adapter->strings.begin() + 160);
+    adapter->rows_removed(150, 10);
+    REQUIRE(view->current_item == 150);
+    REQUIRE(current_text() == "row 155");
+    window.draw();
+}
+
+TEST_CASE("List views search the text typed by keys", "[listview]") {
+    auto platform = TestPlatform();
+    auto window = PlatformWindow();
+    window.platform = &platform;
+    window.main_widget.set_theme(
+        std::make_shared<ThemePlasma>(std::make_shared<FontProviderFixed>()));
+    window.main_widget.content.resize(300, 200);
+
+    auto strings = std::vector<std::string>();
+    for (auto i = 0; i < 100; i++) {
+        strings.push_back("row " + std::to_string(i));
+    }
+    auto view = window.add_new<ListView>();
+    view->adapter = std::make_shared<ListItemAdapter>(strings);
+    window.relayout();
+    window.draw();
+
+    auto press = [&](KeyCodes key, std::string text) {
+        auto event = EventKeyboard{};
+        event.key = key;
+        event.keydown = true;
+        event.modifiers = 0;
+        event.text = std::move(text);
+        view->on_keyboard(event);
+    };
+
+    // Insert has the code of "~", but types nothing
+    view->current_item = 10;
+    press(KeyCodes::Insert, "");
+    REQUIRE(view->current_item == 10);
+
+    press(KeyCodes::Unknown, "row 4");
+    REQUIRE(view->current_item == 4);
+    press(KeyCodes::Unknown, "2");
+    REQUIRE(view->current_item == 42);
+}
+
+TEST_CASE("List view rows follow their text when the adapter storage moves", "[listview]") {
+    auto platform = TestPlatform();
+    auto window = PlatformWindow();
+    window.platform = &platform;
+    window.main_widget.set_theme(
+        std::make_shared<ThemePlasma>(std::make_shared<FontProviderFixed>()));
+    window.main_widget.content.resize(300, 200);
+
+    auto strings = std::vector<std::string>();
+    for (auto i = 0; i < 100; i++) {
+        strings.push_back("row " + std::to_string(i));
+    }
+    auto adapter = std::make_shared<ListItemAdapter>(strings);
+    auto view = window.add_new<ListView>();
+    view->adapter = adapter;
+    window.relayout();
+    window.draw();
+
+    // Every row on screen shows text owned by the adapter right now
+    auto rows_point_into_adapter = [&]() {
+        auto rows = 0;
+        for (auto &w : view->widgets.widgets) {
+            auto row = std::dynamic_pointer_cast<ListItemWidget>(w);
+            if (!row || !row->is_visible()) {
+                continue;
+            }
+            auto is_owner = [&](const std::string &s) { return s.data() == row->text.data(); };
+            if (!std::any_of(adapter->strings.begin(), adapter->strings.end(), is_owner)) {
+                return false;
+            }
+            rows++;
+        }
+        return rows > 0;
+    };
+    REQUIRE(rows_point_into_adapter());
+
+    // Appending below the view reallocates the strings, the kept rows are not redrawn
+    adapter->strings.shrink_to_fit();
+    adapter->strings.push_back("new");
+    adapter->rows_inserted(100, 1);
+    window.draw();
+    REQUIRE(rows_point_into_adapter());
+
+    // Inserting above the view shifts it, no row is redrawn either
+    view->set_scroll_offset(10 * view->get_item_height());
+    window.draw();
+    adapter->strings.shrink_to_fit();
+    adapter->strings.insert(adapter->strings.begin(), "first");
+    adapter->rows_inserted(0, 1);
+    window.draw();
+    REQUIRE(rows_point_into_adapter());
+
+    adapter->strings.erase(adapter->strings.begin());
+    adapter->strings.shrink_to_fit();
+    adapter->rows_removed(0, 1);
+    window.draw();
+    REQUIRE(rows_point_into_adapter());
+
+    // A hovered row draws itself again, from its current text
+    for (auto &w : view->widgets.widgets) {
+        if (std::dynamic_pointer_cast<ListItemWidget>(w) && w->is_visible()) {
+            w->invalidate();
+        }
+    }
+    window.draw();
+    REQUIRE(rows_point_into_adapter());
+}
+
+// Remembers the rows given content, those are the rows drawn again
+struct CountingAdapter : ListItemAdapter {
+    using ListItemAdapter::ListItemAdapter;
+    std::vector<size_t> drawn;
+
+    virtual auto set_content(PWidget widget, size_t position, ItemStatus status)
+        -> void override {
+        drawn.push_back(position);
+        ListItemAdapter::set_content(widget, position, status);
+    }
+};
+
+TEST_CASE("List views scroll by moving pixels and drawing the exposed rows", "[listview]") {
+    auto strings = std::vector<std::string>();
+    for (auto i = 0; i < 1000; i++) {
+        strings.push_back("row " + std::to_string(i));
+    }
+
+    // Each view has its own window, `reference` is drawn from scratch at every offset
+    struct Fixture {
+        TestPlatform platform;
+        PlatformWindow window;
+        std::shared_ptr<CountingAdapter> adapter;
+        std::shared_ptr<ListView> view;
+
+        explicit Fixture(const std::vector<std::string> &strings) {
+            window.platform = &platform;
+            window.main_widget.set_theme(
+                std::make_shared<ThemePlasma>(std::make_shared<FontProviderFixed>()));
+            window.main_widget.content.resize(300, 200);
+            adapter = std::make_shared<CountingAdapter>(strings);
+            view = window.add_new<ListView>(Position{0, 0}, Size{300, 200});
+            view->adapter = adapter;
+            window.draw();
+        }
+    };
+    auto scrolled = Fixture(strings);
+    auto &view = *scrolled.view;
+    auto &adapter = *scrolled.adapter;
+    auto height = int64_t(view.get_item_height());
+    auto visible_rows = size_t(200 / height + 1);
+
+    auto scroll_to = [&](int64_t offset) {
+        adapter.drawn.clear();
+        view.set_scroll_offset(offset);
+        scrolled.window.draw();
+        auto reference = Fixture(strings);
+        reference.view->set_scroll_offset(offset);
+        reference.window.draw();
+        return view.content.buffer == reference.view->content.buffer;
+    };
+    auto first_row = [&]() { return size_t(view.get_scroll_offset() / height); };
+
+    // Down by two rows, only the rows at the bottom are drawn
+    REQUIRE(scroll_to(2 * height));
+    REQUIRE(!adapter.drawn.empty());
+    REQUIRE(adapter.drawn.size() <= 3);
+    for (auto row : adapter.drawn) {
+        REQUIRE(row >= first_row() + visible_rows - 3);
+    }
+
+    // Up by a bit more than a row, only the rows at the top are drawn
+    REQUIRE(scroll_to(height - 3));
+    REQUIRE(!adapter.drawn.empty());
+    REQUIRE(adapter.drawn.size() <= 2);
+    for (auto row : adapter.drawn) {
+        REQUIRE(row <= first_row() + 1);
+    }
+
+    // Less than a row still draws the strip scrolled into view, rows partly on screen
+    // before are kept but drawn again
+    REQUIRE(scroll_to(height + 5));
+    REQUIRE(!adapter.drawn.empty());
+    REQUIRE(adapter.drawn.size() <= 2);
+    REQUIRE(scroll_to(height));
+    REQUIRE(adapter.drawn == std::vector<size_t>{1});
+
+    // More than a page away nothing on screen can be reused
+    REQUIRE(scroll_to(100 * height));
+    REQUIRE(adapter.drawn.size() >= visible_rows - 1);
+    REQUIRE(scroll_to(100 * height - 200));
+    REQUIRE(adapter.drawn.size() >= visible_rows - 1);
+
+    // Not moving draws nothing
+    REQUIRE(scroll_to(100 * height - 200));
+    REQUIRE(adapter.drawn.empty());
+}
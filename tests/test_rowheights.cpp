@@ -0,0 +1,160 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <rowheights.h>
+
+TEST_CASE("Uniform rows need no storage", "[rowheights]") {
+    auto rows = RowHeights();
+    rows.reset(50'000'000, 20);
+    REQUIRE(rows.is_uniform());
+    REQUIRE(rows.total_height() == 1'000'000'000);
+    REQUIRE(rows.offset_of(40'000'000) == 800'000'000);
+    REQUIRE(rows.row_at(800'000'019) == 40'000'000);
+    REQUIRE(rows.row_at(rows.total_height() + 5) == 49'999'999);
+
+    // Same height, nothing changes
+    rows.set_height(10, 20);
+    REQUIRE(rows.is_uniform());
+}
+
+TEST_CASE("Variable rows are found by offset", "[rowheights]") {
+    auto rows = RowHeights();
+    rows.reset(1000, 10);
+    rows.set_height(3, 30);
+    rows.set_height(500, 0);
+    REQUIRE(!rows.is_uniform());
+    REQUIRE(rows.total_height() == 10000 + 20 - 10);
+    REQUIRE(rows.offset_of(3) == 30);
+    REQUIRE(rows.offset_of(4) == 60);
+    REQUIRE(rows.row_at(59) == 3);
+    REQUIRE(rows.row_at(60) == 4);
+
+    // Rows without height are never found
+    REQUIRE(rows.offset_of(501) == rows.offset_of(500));
+    REQUIRE(rows.row_at(rows.offset_of(500)) == 501);
+
+    // Compare with a linear scan
+    for (auto row = size_t(0); row < rows.size(); row += 7) {
+        rows.set_height(row, static_cast<int>(row % 13) + 1);
+    }
+    auto offset = int64_t(0);
+    for (auto row = size_t(0); row < rows.size(); row++) {
+        REQUIRE(rows.offset_of(row) == offset);
+        if (rows.get_height(row) != 0) {
+            REQUIRE(rows.row_at(offset) == row);
+            REQUIRE(rows.row_at(offset + rows.get_height(row) - 1) == row);
+        }
+        offset += rows.get_height(row);
+    }
+    REQUIRE(rows.total_height() == offset);
+}
+
+TEST_CASE("Rows are inserted and removed", "[rowheights]") {
+    auto rows = RowHeights();
+    rows.reset(1000, 10);
+    rows.insert(1000, 500, 10);
+    REQUIRE(rows.is_uniform());
+    REQUIRE(rows.total_height() == 15000);
+
+    // A model of the heights, compared after each change
+    auto model = std::vector<int>(1500, 10);
+    auto compare = [&]() {
+        REQUIRE(rows.size() == model.size());
+        auto offset = int64_t(0);
+        for (auto row = size_t(0); row < model.size(); row++) {
+            REQUIRE(rows.get_height(row) == model[row]);
+            REQUIRE(rows.offset_of(row) == offset);
+            offset += model[row];
+        }
+        REQUIRE(rows.total_height() == offset);
+    };
+
+    rows.insert(300, 20, 25);
+    model.insert(model.begin() + 300, 20, 25);
+    compare();
+
+    rows.set_height(1200, 3);
+    model[1200] = 3;
+    rows.remove(10, 400);
+    model.erase(model.begin() + 10, model.begin() + 410);
+    compare();
+
+    // Removing the last different rows makes the list uniform again
+    rows.remove(800, 1);
+    model.erase(model.begin() + 800);
+    compare();
+    REQUIRE(rows.is_uniform());
+}
+
+TEST_CASE("Long lists are changed without copying their rows", "[rowheights]") {
+    auto rows = RowHeights();
+    rows.reset(50'000'000, 20);
+    rows.set_height(1'000'000, 40);
+    rows.set_height(49'000'000, 10);
+
+    // Near the top, every row after moves
+    rows.insert(10, 5, 20);
+    rows.insert(20, 2, 30);
+    REQUIRE(rows.size() == 50'000'007);
+    REQUIRE(rows.get_height(1'000'007) == 40);
+    REQUIRE(rows.offset_of(1'000'007) == int64_t(1'000'007) * 20 + 20);
+    REQUIRE(rows.row_at(rows.offset_of(49'000'007)) == 49'000'007);
+
+    rows.remove(0, 30);
+    REQUIRE(rows.get_height(1'000'007 - 30) == 40);
+    REQUIRE(rows.total_height() == int64_t(49'999'977) * 20 + 20 - 10);
+}
+
+TEST_CASE("Random changes match a model", "[rowheights]") {
+    auto rows = RowHeights();
+    rows.reset(1000, 10);
+    auto model = std::vector<int>(1000, 10);
+    auto seed = uint32_t(7);
+    auto next = [&seed](uint32_t limit) {
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) % limit;
+    };
+
+    for (auto step = 0; step < 100; step++) {
+        auto row = next(static_cast<uint32_t>(model.size()) + 1);
+        auto height = static_cast<int>(next(4)) * 10;
+        switch (next(3)) {
+        case 0:
+            if (row < model.size()) {
+                rows.set_height(row, height);
+                model[row] = height;
+            }
+            break;
+        case 1: {
+            auto count = next(300);
+            rows.insert(row, count, height);
+            model.insert(model.begin() + row, count, height);
+            break;
+        }
+        default: {
+            auto count = std::min<size_t>(next(300), model.size() - row);
+            rows.remove(row, count);
+            model.erase(model.begin() + row, model.begin() + row + count);
+            break;
+        }
+        }
+
+        REQUIRE(rows.size() == model.size());
+        auto offset = int64_t(0);
+        auto wrong_rows = 0;
+        for (auto i = size_t(0); i < model.size(); i++) {
+            auto is_found = model[i] == 0 || rows.row_at(offset) == i;
+            if (rows.get_height(i) != model[i] || rows.offset_of(i) != offset || !is_found) {
+                wrong_rows++;
+            }
+            offset += model[i];
+        }
+        REQUIRE(wrong_rows == 0);
+        REQUIRE(rows.total_height() == offset);
+    }
+}
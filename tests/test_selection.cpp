@@ -0,0 +1,67 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <selectionmodel.h>
+
+struct ChangeLog : SelectionObserver {
+    std::vector<RowRange> changed;
+    virtual auto on_selection_changed(const std::vector<RowRange> &ranges) -> void override {
+        changed = ranges;
+    }
+};
+
+TEST_CASE("Selection is kept as merged ranges", "[selection]") {
+    auto selection = SelectionModel();
+    auto log = ChangeLog();
+    selection.add_observer(&log);
+
+    selection.select(10, 20);
+    selection.select(20, 30);
+    selection.select(5, 12);
+    REQUIRE(selection.get_ranges() == std::vector<RowRange>{{5, 30}});
+    REQUIRE(log.changed == std::vector<RowRange>{{5, 10}});
+
+    selection.deselect(15, 17);
+    REQUIRE(selection.get_ranges() == std::vector<RowRange>{{5, 15}, {17, 30}});
+    REQUIRE(selection.get_selected_count() == 23);
+    REQUIRE(selection.is_selected(14));
+    REQUIRE(!selection.is_selected(15));
+    REQUIRE(!selection.is_selected(30));
+
+    selection.toggle(15);
+    selection.toggle(16);
+    REQUIRE(selection.get_ranges() == std::vector<RowRange>{{5, 30}});
+
+    // Selecting a billion rows is a single range
+    selection.select_all(1'000'000'000);
+    REQUIRE(selection.get_ranges().size() == 1);
+    REQUIRE(log.changed == std::vector<RowRange>{{0, 5}, {30, 1'000'000'000}});
+
+    selection.invert(1'000'000'000);
+    REQUIRE(selection.is_empty());
+    selection.invert(100);
+    REQUIRE(log.changed == std::vector<RowRange>{{0, 100}});
+}
+
+TEST_CASE("Selection follows inserted and removed rows", "[selection]") {
+    auto selection = SelectionModel();
+    selection.select(10, 20);
+
+    // New rows are not selected, even inside a selected range
+    selection.insert_rows(15, 5);
+    REQUIRE(selection.get_ranges() == std::vector<RowRange>{{10, 15}, {20, 25}});
+    selection.insert_rows(0, 2);
+    REQUIRE(selection.get_ranges() == std::vector<RowRange>{{12, 17}, {22, 27}});
+
+    selection.remove_rows(0, 12);
+    REQUIRE(selection.get_ranges() == std::vector<RowRange>{{0, 5}, {10, 15}});
+    selection.remove_rows(5, 5);
+    REQUIRE(selection.get_ranges() == std::vector<RowRange>{{0, 10}});
+    selection.remove_rows(0, 100);
+    REQUIRE(selection.is_empty());
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "testplatform.h"
+#include <catch2/catch_test_macros.hpp>
+#include <sortfilteradapter.h>
+#include <threadpool.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+static auto wait_for(TestPlatform &platform, const SortFilterProxyAdapter &adapter) -> void {
+    while (adapter.is_busy()) {
+        platform.run_posted();
+        std::this_thread::yield();
+    }
+}
+
+struct CountingObserver : ItemAdapterObserver {
+    size_t inserted = 0;
+    size_t removed = 0;
+    int resets = 0;
+
+    virtual auto on_rows_inserted(size_t, size_t count) -> void override { inserted += count; }
+    virtual auto on_rows_removed(size_t, size_t count) -> void override { removed += count; }
+    virtual auto on_rows_changed(size_t, size_t) -> void override {}
+    virtual auto on_reset() -> void override { resets++; }
+};
+
+static auto texts(const SortFilterProxyAdapter &adapter) -> std::vector<std::string> {
+    auto result = std::vector<std::string>();
+    for (size_t i = 0; i < adapter.get_count(); i++) {
+        result.emplace_back(adapter.get_text(i));
+    }
+    return result;
+}
+
+TEST_CASE("Thread pool runs every index once", "[threadpool]") {
+    auto pool = ThreadPool(4);
+    auto hits = std::vector<std::atomic<int>>(10'000);
+    pool.parallel_for(hits.size(), [&](size_t i) { hits[i]++; });
+    REQUIRE(std::all_of(hits.begin(), hits.end(), [](auto &hit) { return hit == 1; }));
+
+    // Nested batches do not wait for a free worker
+    auto total = std::atomic<int>(0);
+    pool.parallel_for(8, [&](size_t) { pool.parallel_for(8, [&](size_t) { total++; }); });
+    REQUIRE(total == 64);
+}
+
+TEST_CASE("Rows are sorted and filtered in the background", "[sortfilter]") {
+    auto platform = TestPlatform();
+    auto strings = std::vector<std::string>();
+    for (auto i = 0; i < 20'000; i++) {
+        strings.push_back("item " + std::to_string((i * 7919) % 20'000));
+    }
+    auto source = std::make_shared<ListItemAdapter>(strings);
+    auto proxy = std::make_shared<SortFilterProxyAdapter>(source, platform);
+    proxy->chunk_size = 1000;
+    auto observer = CountingObserver();
+    proxy->add_observer(&observer);
+    REQUIRE(proxy->get_count() == strings.size());
+
+    proxy->set_sort_order(SortFilterProxyAdapter::SortOrder::Ascending);
+    wait_for(platform, *proxy);
+    auto sorted = strings;
+    std::sort(sorted.begin(), sorted.end());
+    REQUIRE(texts(*proxy) == sorted);
+    REQUIRE(observer.resets == 1);
+    REQUIRE(observer.inserted == strings.size());
+
+    // Narrowing checks only the rows shown, and removes those which fail
+    proxy->set_filter("ITEM 1");
+    wait_for(platform, *proxy);
+    auto expected = std::vector<std::string>();
+    std::copy_if(sorted.begin(), sorted.end(), std::back_inserter(expected),
+                 [](auto &s) { return s.find("item 1") != std::string::npos; });
+    REQUIRE(texts(*proxy) == expected);
+    REQUIRE(observer.resets == 1);
+    REQUIRE(observer.removed == strings.size() - expected.size());
+
+    proxy->set_filter("item 12");
+    wait_for(platform, *proxy);
+    REQUIRE(proxy->get_count() == 1111);
+
+    // Widening starts again from all the rows
+    proxy->set_filter("");
+    wait_for(platform, *proxy);
+    REQUIRE(texts(*proxy) == sorted);
+    REQUIRE(proxy->get_text(0) == "item 0");
+    REQUIRE(source->strings[proxy->map_to_source(0)] == "item 0");
+}
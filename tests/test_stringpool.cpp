@@ -0,0 +1,60 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <stringpooladapter.h>
+#include <threadpool.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+TEST_CASE("Lines are split from text and files", "[stringpool]") {
+    auto adapter = StringPoolAdapter("first\r\nsecond\n\nlast");
+    REQUIRE(adapter.get_count() == 4);
+    REQUIRE(adapter.get_text(0) == "first");
+    REQUIRE(adapter.get_text(1) == "second");
+    REQUIRE(adapter.get_text(2) == "");
+    REQUIRE(adapter.get_text(3) == "last");
+
+    REQUIRE(StringPoolAdapter("").get_count() == 0);
+    REQUIRE(StringPoolAdapter("one\n").get_count() == 1);
+
+    auto strings = StringPoolAdapter(std::vector<std::string>{"a", "", "c"});
+    REQUIRE(strings.get_count() == 3);
+    REQUIRE(strings.get_text(2) == "c");
+
+    auto file_name = (std::filesystem::temp_directory_path() / "svision-stringpool.txt").string();
+    {
+        auto file = std::ofstream(file_name, std::ios::binary);
+        file << "alpha\nbeta\n";
+    }
+    auto mapped = StringPoolAdapter::open(file_name);
+    REQUIRE(mapped);
+    REQUIRE(mapped->get_count() == 2);
+    REQUIRE(mapped->get_text(1) == "beta");
+    std::remove(file_name.c_str());
+
+    REQUIRE(!StringPoolAdapter::open(file_name));
+}
+
+TEST_CASE("Lines split on workers match a single thread", "[stringpool]") {
+    auto text = std::string();
+    for (auto i = 0; i < 500'000; i++) {
+        text += "row " + std::to_string(i) + "\n";
+    }
+    auto pool = ThreadPool(4);
+    auto parallel = StringPoolAdapter(text, &pool);
+    auto single = StringPoolAdapter(text);
+    REQUIRE(parallel.get_count() == 500'000);
+    REQUIRE(single.get_count() == 500'000);
+    for (size_t i = 0; i < parallel.get_count(); i += 997) {
+        REQUIRE(parallel.get_text(i) == single.get_text(i));
+        REQUIRE(parallel.get_text(i) == "row " + std::to_string(i));
+    }
+}
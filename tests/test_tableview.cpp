@@ -0,0 +1,154 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "testplatform.h"
+#include <catch2/catch_test_macros.hpp>
+#include <tableview.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+// Remembers which cells were drawn, and the width each one got
+struct CountingTable : TableAdapter {
+    size_t rows = 1000;
+    size_t columns = 40;
+    std::set<std::pair<size_t, size_t>> drawn;
+    std::set<size_t> drawn_rows;
+    size_t drawn_count = 0;
+    std::map<size_t, int> widths;
+    mutable std::string text;
+
+    virtual auto get_count() const -> size_t override { return rows; }
+    virtual auto get_column_count() const -> size_t override { return columns; }
+    virtual auto get_column_title(size_t column) const -> std::string_view override {
+        text = "column " + std::to_string(column);
+        return text;
+    }
+    virtual auto get_cell_text(size_t row, size_t column) const -> std::string_view override {
+        text = std::to_string(row) + ":" + std::to_string(column);
+        return text;
+    }
+    virtual auto get_column_width(size_t, Theme &) -> int override { return 50; }
+    virtual auto draw_cell(Bitmap &content, size_t row, size_t column, ItemStatus status,
+                           Theme &theme) -> void override {
+        drawn.insert({row, column});
+        drawn_rows.insert(row);
+        drawn_count++;
+        widths[column] = content.size.width;
+        TableAdapter::draw_cell(content, row, column, status, theme);
+    }
+    auto clear() -> void {
+        drawn.clear();
+        drawn_rows.clear();
+        drawn_count = 0;
+        widths.clear();
+    }
+};
+
+struct TableFixture {
+    TestPlatform platform;
+    PlatformWindow window;
+    std::shared_ptr<CountingTable> adapter = std::make_shared<CountingTable>();
+    std::shared_ptr<TableView> view;
+    int row_height = 0;
+
+    TableFixture() {
+        window.platform = &platform;
+        window.main_widget.set_theme(
+            std::make_shared<ThemePlasma>(std::make_shared<FontProviderFixed>()));
+        window.main_widget.content.resize(300, 200);
+        view = window.add_new<TableView>(Position{0, 0}, Size{300, 200});
+        view->adapter = adapter;
+        view->draw();
+        row_height = adapter->get_item_height(0, *view->get_theme());
+    }
+};
+
+TEST_CASE("Table views draw only the cells that changed", "[tableview]") {
+    auto f = TableFixture();
+    auto &adapter = *f.adapter;
+
+    // The first frame draws the cells on screen, not the whole table
+    auto visible_rows = size_t(200 / f.row_height + 2);
+    auto visible_columns = size_t(300 / 50 + 2);
+    REQUIRE(adapter.drawn_count > 0);
+    REQUIRE(adapter.drawn_count <= visible_rows * visible_columns);
+    REQUIRE(adapter.drawn.count({0, 0}) == 1);
+    REQUIRE(*adapter.drawn_rows.rbegin() < visible_rows);
+
+    // Nothing changed, nothing is drawn
+    adapter.clear();
+    f.view->draw();
+    REQUIRE(adapter.drawn_count == 0);
+
+    // A changed row draws only that row
+    adapter.clear();
+    adapter.rows_changed(2, 1);
+    f.view->draw();
+    REQUIRE(adapter.drawn_count > 0);
+    REQUIRE(adapter.drawn_rows == std::set<size_t>{2});
+
+    // Rows outside the view draw nothing
+    adapter.clear();
+    adapter.rows_changed(900, 5);
+    f.view->draw();
+    REQUIRE(adapter.drawn_count == 0);
+
+    // Scrolling down by one row draws only the strip scrolled into view
+    adapter.clear();
+    f.view->set_scroll_offset(0, f.row_height);
+    f.view->draw();
+    REQUIRE(adapter.drawn_count > 0);
+    REQUIRE(adapter.drawn_rows.size() <= 2);
+    REQUIRE(*adapter.drawn_rows.begin() >= visible_rows - 3);
+}
+
+TEST_CASE("Table views resize columns and scroll to rows", "[tableview]") {
+    auto f = TableFixture();
+    auto &adapter = *f.adapter;
+
+    REQUIRE(f.view->get_column_width(1) == 50);
+    f.view->set_column_width(1, 120);
+    REQUIRE(f.view->get_column_width(1) == 120);
+    REQUIRE(f.view->get_column_width(2) == 50);
+
+    // A resized column redraws the view, its cells get the new width
+    adapter.clear();
+    f.view->draw();
+    REQUIRE(adapter.drawn.count({0, 1}) == 1);
+    REQUIRE(adapter.widths[0] == 50);
+    REQUIRE(adapter.widths[1] == 120);
+    REQUIRE(adapter.widths[2] == 50);
+
+    // Narrower than the minimum is clamped, the column stays usable
+    f.view->set_column_width(1, 0);
+    REQUIRE(f.view->get_column_width(1) > 0);
+    f.view->set_column_width(1, 120);
+
+    // Rows below the view are scrolled up to its bottom edge, rows above to its top
+    f.view->ensure_row_visible(500);
+    auto offset = f.view->get_vertical_offset();
+    REQUIRE(offset > int64_t(490) * f.row_height);
+    REQUIRE(offset < int64_t(500) * f.row_height);
+    f.view->ensure_row_visible(501);
+    REQUIRE(f.view->get_vertical_offset() == offset + f.row_height);
+
+    // A visible row does not move the view
+    f.view->ensure_row_visible(499);
+    REQUIRE(f.view->get_vertical_offset() == offset + f.row_height);
+
+    f.view->ensure_row_visible(10);
+    REQUIRE(f.view->get_vertical_offset() == int64_t(10) * f.row_height);
+
+    // Rows past the end scroll to the end and no further
+    f.view->ensure_row_visible(adapter.rows - 1);
+    auto end = f.view->get_vertical_offset();
+    f.view->ensure_row_visible(adapter.rows + 10);
+    REQUIRE(f.view->get_vertical_offset() == end);
+}
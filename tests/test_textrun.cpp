@@ -0,0 +1,43 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <textrun.h>
+
+// Counts how often text is measured, a run measures its text when it rasterizes it again
+struct CountingFont : FontProviderFixed {
+    int measured = 0;
+
+    auto virtual text_size(const std::string_view str) -> Size override {
+        measured++;
+        return FontProviderFixed::text_size(str);
+    }
+    auto virtual add_fallback(const std::string_view) -> bool override {
+        bump_generation();
+        return true;
+    }
+};
+
+TEST_CASE("Text runs are rasterized again when the font changes", "[textrun]") {
+    auto font = CountingFont();
+    auto run = TextRun();
+    auto size = run.text_size(font, "Hello");
+    REQUIRE(run.text_size(font, "Hello") == size);
+    REQUIRE(font.measured == 1);
+
+    // A fallback font may draw glyphs which were missing
+    font.add_fallback("fallback.ttf");
+    REQUIRE(run.text_size(font, "Hello") == size);
+    REQUIRE(font.measured == 2);
+
+    // Another provider is another font, even at the same size
+    auto other = CountingFont();
+    run.text_size(other, "Hello");
+    REQUIRE(other.measured == 1);
+    run.text_size(font, "Hello");
+    REQUIRE(font.measured == 3);
+}
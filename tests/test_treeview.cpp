@@ -0,0 +1,128 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <treeview.h>
+
+#include <map>
+#include <random>
+#include <string>
+
+// Node n has n % 7 children, numbered n * 8 + 1 onwards. Fetches wait until `flush()` when
+// the model is asynchronous.
+struct NumberTree : TreeModel {
+    bool is_async = false;
+    std::vector<std::function<void()>> pending;
+    mutable std::string text;
+
+    virtual auto get_text(Node node) const -> std::string_view override {
+        text = std::to_string(node);
+        return text;
+    }
+    virtual auto has_children(Node node) const -> bool override { return get_children(node) != 0; }
+    virtual auto fetch_children(Node node, Children done) -> void override {
+        auto children = std::vector<Node>();
+        for (Node i = 0; i < get_children(node); i++) {
+            children.push_back(node * 8 + 1 + i);
+        }
+        if (!is_async) {
+            done(children);
+            return;
+        }
+        pending.push_back([done, children]() { done(children); });
+    }
+    auto flush() -> void {
+        auto tasks = std::move(pending);
+        for (auto &task : tasks) {
+            task();
+        }
+    }
+    static auto get_children(Node node) -> Node { return node == root ? 5 : node % 7; }
+};
+
+// Counts rows as views do, from the notifications
+struct RowCounter : ItemAdapterObserver {
+    size_t count = 0;
+    virtual auto on_rows_inserted(size_t, size_t rows) -> void override { count += rows; }
+    virtual auto on_rows_removed(size_t, size_t rows) -> void override { count -= rows; }
+    virtual auto on_rows_changed(size_t, size_t) -> void override {}
+    virtual auto on_reset() -> void override {}
+};
+
+// The rows expected, by walking the expanded nodes
+static auto flatten(const std::map<TreeModel::Node, bool> &expanded, TreeModel::Node node,
+                    std::vector<TreeModel::Node> &rows) -> void {
+    for (TreeModel::Node i = 0; i < NumberTree::get_children(node); i++) {
+        auto child = node * 8 + 1 + i;
+        rows.push_back(child);
+        auto found = expanded.find(child);
+        if (found != expanded.end() && found->second) {
+            flatten(expanded, child, rows);
+        }
+    }
+}
+
+TEST_CASE("Tree rows follow expanded nodes", "[treeview]") {
+    auto model = std::make_shared<NumberTree>();
+    auto rows = TreeRows::create(model);
+    auto counter = RowCounter();
+    counter.count = rows->get_count();
+    rows->add_observer(&counter);
+    REQUIRE(rows->get_count() == 5);
+
+    auto expanded = std::map<TreeModel::Node, bool>();
+    auto random = std::mt19937(42);
+    for (auto step = 0; step < 2000; step++) {
+        auto row = random() % rows->get_count();
+        auto node = rows->get_node(row);
+        if (rows->is_expanded(row)) {
+            rows->collapse(row);
+            expanded[node] = false;
+        } else {
+            rows->expand(row);
+            expanded[node] = NumberTree::get_children(node) != 0;
+        }
+
+        auto expected = std::vector<TreeModel::Node>();
+        flatten(expanded, TreeModel::root, expected);
+        REQUIRE(rows->get_count() == expected.size());
+        REQUIRE(counter.count == expected.size());
+        for (size_t i = 0; i < expected.size(); i += 1 + expected.size() / 50) {
+            REQUIRE(rows->get_node(i) == expected[i]);
+        }
+    }
+    rows->remove_observer(&counter);
+}
+
+TEST_CASE("Children loaded later are inserted when they arrive", "[treeview]") {
+    auto model = std::make_shared<NumberTree>();
+    model->is_async = true;
+    auto rows = TreeRows::create(model);
+    REQUIRE(rows->get_count() == 0);
+    model->flush();
+    REQUIRE(rows->get_count() == 5);
+
+    // Node 4 has 4 children, they show once loaded
+    REQUIRE(rows->get_node(3) == 4);
+    rows->expand(3);
+    REQUIRE(rows->is_loading(3));
+    REQUIRE(rows->get_count() == 5);
+    model->flush();
+    REQUIRE(!rows->is_loading(3));
+    REQUIRE(rows->get_count() == 9);
+    REQUIRE(rows->get_node(4) == 33);
+    REQUIRE(rows->get_depth(4) == 1);
+    REQUIRE(rows->get_parent_row(4) == 3);
+
+    // Collapsed while loading, the children are kept for the next expand
+    rows->expand(2);
+    rows->collapse(2);
+    model->flush();
+    REQUIRE(rows->get_count() == 9);
+    rows->expand(2);
+    REQUIRE(rows->get_count() == 12);
+}
@@ -0,0 +1,42 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <typeahead.h>
+
+TEST_CASE("Typing finds rows by prefix", "[typeahead]") {
+    auto strings = std::vector<std::string>{"Cherry", "apple", "banana", "Apricot", "avocado",
+                                            "blueberry"};
+    auto get_text = [&strings](size_t row) { return std::string_view(strings[row]); };
+    auto type_ahead = TypeAhead();
+    auto type = [&](char key, int current) {
+        return type_ahead.on_key(std::string(1, key), strings.size(), get_text, current);
+    };
+
+    // Case is ignored, the first match in text order is selected
+    REQUIRE(type('A', 0) == 1);
+    REQUIRE(type('p', 1) == 1);
+    REQUIRE(type('r', 1) == 3);
+    REQUIRE(type('x', 3) == -1);
+
+    // Same letter again cycles the matches
+    type_ahead.invalidate();
+    REQUIRE(type('b', 0) == 2);
+    REQUIRE(type('b', 2) == 5);
+    REQUIRE(type('b', 5) == 2);
+
+    // A space does not start a search, keys which type nothing are ignored
+    type_ahead.invalidate();
+    REQUIRE(type(' ', 0) == -1);
+    REQUIRE(type_ahead.on_key("", strings.size(), get_text, 0) == -1);
+    REQUIRE(type('b', 0) == 2);
+
+    // Keys typed after the timeout start a new search
+    type_ahead.timeout = std::chrono::milliseconds(0);
+    REQUIRE(type('c', 1) == 0);
+    REQUIRE(type('a', 0) == 1);
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <utf8.h>
+#include <vector>
+
+static auto decode_all(std::string_view text) -> std::vector<char32_t> {
+    auto result = std::vector<char32_t>();
+    utf8_for_each(text, [&result](char32_t c) { result.push_back(c); });
+    return result;
+}
+
+TEST_CASE("UTF-8 valid input", "[utf8]") {
+    REQUIRE(decode_all("abc") == std::vector<char32_t>{'a', 'b', 'c'});
+    REQUIRE(decode_all("\xC3\xA9") == std::vector<char32_t>{0xE9});
+    REQUIRE(decode_all("\xD7\xA9\xD7\x9C\xD7\x95\xD7\x9D") ==
+            std::vector<char32_t>{0x5E9, 0x5DC, 0x5D5, 0x5DD});
+    REQUIRE(decode_all("\xE2\x82\xAC") == std::vector<char32_t>{0x20AC});
+    REQUIRE(decode_all("\xF0\x9F\x98\x80") == std::vector<char32_t>{0x1F600});
+    REQUIRE(decode_all("\xF4\x8F\xBF\xBF") == std::vector<char32_t>{0x10FFFF});
+    REQUIRE(utf8_length("a\xC3\xA9z") == 3);
+}
+
+TEST_CASE("UTF-8 invalid input", "[utf8]") {
+    auto fffd = utf8_replacement_character;
+
+    // stray continuation, overlong, surrogate, above U+10FFFF
+    REQUIRE(decode_all("\x80") == std::vector<char32_t>{fffd});
+    REQUIRE(decode_all("\xC0\xAF") == std::vector<char32_t>{fffd, fffd});
+    REQUIRE(decode_all("\xE0\x80\xAF") == std::vector<char32_t>{fffd, fffd, fffd});
+    REQUIRE(decode_all("\xED\xA0\x80") == std::vector<char32_t>{fffd, fffd, fffd});
+    REQUIRE(decode_all("\xF4\x90\x80\x80") == std::vector<char32_t>{fffd, fffd, fffd, fffd});
+
+    // truncated sequences must not read past the end
+    auto text = std::string("x\xE2\x82\xAC");
+    REQUIRE(decode_all(std::string_view(text.data(), 3)) == std::vector<char32_t>{'x', fffd});
+    REQUIRE(decode_all("\xE2\x82z") == std::vector<char32_t>{fffd, 'z'});
+}
+
+TEST_CASE("UTF-8 ASCII runs", "[utf8]") {
+    auto text = std::string(100, 'a');
+    REQUIRE(utf8_ascii_prefix(text) == 100);
+    for (auto i = size_t{0}; i < text.size(); i++) {
+        auto copy = text;
+        copy[i] = '\xC3';
+        REQUIRE(utf8_ascii_prefix(copy) == i);
+    }
+    REQUIRE(utf8_length(text + "\xC3\xA9" + text) == 201);
+}
+
+TEST_CASE("UTF-8 cursor movement", "[utf8]") {
+    auto text = std::string_view("a\xC3\xA9\xE2\x82\xAC\x80z");
+    REQUIRE(utf8_next(text, 0) == 1);
+    REQUIRE(utf8_next(text, 1) == 3);
+    REQUIRE(utf8_next(text, 3) == 6);
+    REQUIRE(utf8_next(text, 6) == 7);
+    REQUIRE(utf8_next(text, 8) == 8);
+    REQUIRE(utf8_prev(text, 8) == 7);
+    REQUIRE(utf8_prev(text, 7) == 6);
+    REQUIRE(utf8_prev(text, 6) == 3);
+    REQUIRE(utf8_prev(text, 3) == 1);
+    REQUIRE(utf8_prev(text, 1) == 0);
+    REQUIRE(utf8_prev(text, 0) == 0);
+}
+
+TEST_CASE("UTF-16 units are joined into code points", "[utf8]") {
+    auto joiner = Utf16Joiner();
+    REQUIRE(joiner.push(u'a') == U'a');
+    REQUIRE(joiner.push(0x05D0) == 0x05D0);
+
+    // U+1F600 is D83D DE00
+    REQUIRE(joiner.push(0xD83D) == 0);
+    REQUIRE(joiner.push(0xDE00) == 0x1F600);
+    auto text = std::string();
+    utf8_append(text, 0x1F600);
+    REQUIRE(text == "\xF0\x9F\x98\x80");
+
+    // Unpaired surrogates
+    REQUIRE(joiner.push(0xDE00) == utf8_replacement_character);
+    REQUIRE(joiner.push(0xD83D) == 0);
+    REQUIRE(joiner.push(u'b') == U'b');
+    REQUIRE(joiner.push(0xDE00) == utf8_replacement_character);
+}
@@ -0,0 +1,26 @@
+/*
+ * This file is part of SVision2
+ * Copyright (c) Diego Iastrubni <diegoiast@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <platform.h>
+
+// A platform without a display, windows are drawn into their bitmaps only. Posted tasks are
+// run by the test, instead of a main loop.
+struct TestPlatform : Platform {
+    virtual auto platform_init() -> void override {}
+    virtual auto done() -> void override {}
+    virtual auto open_window(int, int, int, int, const std::string_view)
+        -> std::shared_ptr<PlatformWindow> override {
+        return {};
+    }
+    virtual auto show_window(std::shared_ptr<PlatformWindow>) -> void override {}
+    virtual auto clear_cursor_cache() -> void override {}
+    virtual auto set_cursor(PlatformWindow &, MouseCursor) -> void override {}
+    virtual auto invalidate(PlatformWindow &) -> void override {}
+    virtual auto main_loop() -> void override {}
+};